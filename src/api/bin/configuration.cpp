@@ -44,6 +44,29 @@ namespace copper_server::api::configuration {
             conflict_type = t::prevent_join;
     }
 
+    std::string to_string(ServerConfiguration::Protocol::PacketLimit::action_t action) {
+        switch (action) {
+            using t = ServerConfiguration::Protocol::PacketLimit::action_t;
+        case t::drop:
+            return "drop";
+        case t::delay:
+            return "delay";
+        case t::kick:
+            return "kick";
+        }
+        throw std::runtime_error("Stack corruption or incomplete to_string code");
+    }
+
+    void set_from_string(ServerConfiguration::Protocol::PacketLimit::action_t& action, const std::string& val) {
+        using t = ServerConfiguration::Protocol::PacketLimit::action_t;
+        if (val == "drop")
+            action = t::drop;
+        else if (val == "delay")
+            action = t::delay;
+        else if (val == "kick")
+            action = t::kick;
+    }
+
     void merge_configs_query(ServerConfiguration& cfg, js_object& data) {
         auto query = js_object::get_object(data["query"]);
         cfg.query.enabled = query["enabled"].or_apply(cfg.query.enabled);
@@ -134,6 +157,7 @@ namespace copper_server::api::configuration {
     void merge_configs_protocol(ServerConfiguration& cfg, js_object& data) {
         auto protocol = js_object::get_object(data["protocol"]);
         cfg.protocol.compression_threshold = protocol["compression_threshold"].or_apply(cfg.protocol.compression_threshold);
+        cfg.protocol.compression_backend = (std::string)protocol["compression_backend"].or_apply(cfg.protocol.compression_backend);
         cfg.protocol.rate_limit = protocol["rate_limit"].or_apply(cfg.protocol.rate_limit);
         cfg.protocol.handle_legacy = protocol["handle_legacy"].or_apply(cfg.protocol.handle_legacy);
         cfg.protocol.new_client_buffer = protocol["new_client_buffer"].or_apply(cfg.protocol.new_client_buffer);
@@ -144,11 +168,25 @@ namespace copper_server::api::configuration {
         cfg.protocol.timeout_seconds = protocol["timeout_seconds"].or_apply(cfg.protocol.timeout_seconds);
         cfg.protocol.keep_alive_send_each_seconds = protocol["keep_alive_send_each_seconds"].or_apply(cfg.protocol.keep_alive_send_each_seconds);
         cfg.protocol.all_connections_timeout_seconds = protocol["all_connections_timeout_seconds"].or_apply(cfg.protocol.all_connections_timeout_seconds);
+        cfg.protocol.send_buffer_flush_size = protocol["send_buffer_flush_size"].or_apply(cfg.protocol.send_buffer_flush_size);
+        cfg.protocol.inbound_queue_size = protocol["inbound_queue_size"].or_apply(cfg.protocol.inbound_queue_size);
 
         cfg.protocol.prevent_proxy_connections = protocol["prevent_proxy_connections"].or_apply(cfg.protocol.prevent_proxy_connections);
         cfg.protocol.enable_encryption = protocol["enable_encryption"].or_apply(cfg.protocol.enable_encryption);
         cfg.protocol.send_nbt_data_in_chunk = protocol["send_nbt_data_in_chunk"].or_apply(cfg.protocol.send_nbt_data_in_chunk);
         set_from_string(cfg.protocol.connection_conflict, protocol["connection_conflict"].or_apply(to_string(cfg.protocol.connection_conflict)));
+        {
+            auto packet_limits = js_object::get_object(protocol["packet_limits"]);
+            std::unordered_map<std::string, ServerConfiguration::Protocol::PacketLimit> res;
+            for (auto&& [name, _] : packet_limits) {
+                auto limit = js_object::get_object(packet_limits[name]);
+                auto& item = res[(std::string)name];
+                item.per_second = limit["per_second"].or_apply(item.per_second);
+                item.processing_ms = limit["processing_ms"].or_apply(item.processing_ms);
+                set_from_string(item.action, limit["action"].or_apply(to_string(item.action)));
+            }
+            cfg.protocol.packet_limits = std::move(res);
+        }
     }
 
     void merge_configs_anti_cheat(ServerConfiguration& cfg, js_object& data) {
@@ -208,6 +246,12 @@ namespace copper_server::api::configuration {
     void merge_configs_mojang(ServerConfiguration& cfg, js_object& data) {
         auto mojang = js_object::get_object(data["mojang"]);
         cfg.mojang.enforce_secure_profile = mojang["enforce_secure_profile"].or_apply(cfg.mojang.enforce_secure_profile);
+        cfg.mojang.session_server = (std::string)mojang["session_server"].or_apply(cfg.mojang.session_server);
+        cfg.mojang.session_server_port = mojang["session_server_port"].or_apply(cfg.mojang.session_server_port);
+        cfg.mojang.session_server_path = (std::string)mojang["session_server_path"].or_apply(cfg.mojang.session_server_path);
+        cfg.mojang.session_cache_seconds = mojang["session_cache_seconds"].or_apply(cfg.mojang.session_cache_seconds);
+        cfg.mojang.session_max_concurrent_requests = mojang["session_max_concurrent_requests"].or_apply(cfg.mojang.session_max_concurrent_requests);
+        cfg.mojang.session_max_idle_connections = mojang["session_max_idle_connections"].or_apply(cfg.mojang.session_max_idle_connections);
     }
 
     void merge_configs_status(ServerConfiguration& cfg, js_object& data) {
@@ -6,11 +6,24 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
-#include <src/mojang/api/session_server.hpp>
+#include <src/api/configuration.hpp>
+#include <src/api/mojang/session_server.hpp>
 
 namespace copper_server::api::mojang {
     ::mojang::api::session_server& get_session_server() {
         static ::mojang::api::session_server sessions;
         return sessions;
     }
+
+    void reload_session_server() {
+        auto& config = api::configuration::get().mojang;
+        get_session_server().configure({
+            .host = config.session_server,
+            .port = config.session_server_port,
+            .path = config.session_server_path,
+            .cache_duration = std::chrono::seconds(config.session_cache_seconds),
+            .max_concurrent_requests = config.session_max_concurrent_requests,
+            .max_idle_connections = config.session_max_idle_connections
+        });
+    }
 }
\ No newline at end of file
@@ -37,6 +37,13 @@ namespace copper_server {
                 return client_post_send_viewers[mode][id].join([fn = std::move(fn)](auto& it, auto& cl) { fn(it, cl); return false; });
             }
 
+            bool has_client_viewers(uint8_t mode, size_t id) {
+                auto viewers = client_viewers[mode].find(id);
+                auto post_send_viewers = client_post_send_viewers[mode].find(id);
+                return (viewers != client_viewers[mode].end() && !viewers->second.empty())
+                       || (post_send_viewers != client_post_send_viewers[mode].end() && !post_send_viewers->second.empty());
+            }
+
             void unregister_client_viewer(uint8_t mode, size_t id, base_objects::events::event_register_id reg_id) {
                 client_viewers[mode][id].leave(reg_id);
             }
@@ -185,10 +192,7 @@ namespace copper_server {
                     result.z = (int32_t)chunk.chunk_z;
                     for (auto& section : chunk.sub_chunks) {
                         base_objects::pallete_container_biome biomes(registers::biomes.size());
-                        for (auto& x : section.biomes)
-                            for (auto& y : x)
-                                for (auto& z : y)
-                                    biomes.add(z);
+                        biomes.assign(&section->biomes[0][0][0], 64);
                         result.sections_of_biomes.value.push_back(std::move(biomes));
                     }
                     return result;
@@ -198,9 +202,14 @@ namespace copper_server {
                     level_chunk_with_light result;
                     static auto build_height_map = [](uint8_t type, const uint64_t (&hei_map)[16][16], size_t world_height) {
                         base_objects::pallete_data_height_map data(base_objects::pallete_data::bits_for_max(world_height));
+                        uint32_t values[256];
                         for (uint_fast8_t x = 0; x < 16; x++)
-                            for (uint_fast8_t z = 0; z < 16; z++)
-                                data.add(hei_map[x][z]);
+                            for (uint_fast8_t z = 0; z < 16; z++) {
+                                if (hei_map[x][z] > UINT32_MAX)
+                                    throw std::out_of_range("value is too large for the given bits_per_entry");
+                                values[x * 16 + z] = uint32_t(hei_map[x][z]);
+                            }
+                        data.assign(values, 256);
                         return height_map{
                             .type = height_map::type_e(type),
                             .pallete_data = std::move(data)
@@ -220,23 +229,27 @@ namespace copper_server {
                         uint16_t block_count = 0;
                         base_objects::pallete_container_block blocks(base_objects::block::block_states_size());
                         base_objects::pallete_container_biome biomes(registers::biomes.size());
-                        for (auto& x : section_.blocks)
-                            for (auto& y : x)
-                                for (auto z : y) {
-                                    block_count += !z.is_air();
-                                    blocks.add(z.id);
-                                }
-                        for (auto& x : section_.biomes)
-                            for (auto& y : x)
-                                for (auto& z : y)
-                                    biomes.add(z);
+                        int32_t ids[base_objects::world::block_storage::entries_count];
+                        //sections are mostly runs of same block, so air check is done once per run
+                        uint32_t last_id = uint32_t(-1);
+                        bool last_is_air = false;
+                        section_->blocks.for_each([&](uint16_t index, base_objects::block_id_t id) {
+                            if (id != last_id) {
+                                last_id = id;
+                                last_is_air = base_objects::block(id).is_air();
+                            }
+                            block_count += !last_is_air;
+                            ids[index] = id;
+                        });
+                        blocks.assign(ids, base_objects::world::block_storage::entries_count);
+                        biomes.assign(&section_->biomes[0][0][0], 64);
                         result.sections.value.push_back(section{block_count, std::move(blocks), std::move(biomes)});
                     }
                     if (api::configuration::get().protocol.send_nbt_data_in_chunk) {
                         auto sub_chunk = world.get_world_y_chunk_offset();
                         for (auto& section : chunk.sub_chunks) {
                             auto sub_chunk_pos = sub_chunk * 16;
-                            section.for_each_block_entity(
+                            section->for_each_block_entity(
                                 [&result, sub_chunk_pos](uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::block block, const enbt::value& entity_data) {
                                     result.block_entities.push_back(
                                         block_entity{
@@ -269,8 +282,16 @@ namespace copper_server {
                     bit_list_array<uint64_t> block_light_mask;
                     bit_list_array<uint64_t> empty_sky_light_mask;
                     bit_list_array<uint64_t> empty_block_light_mask;
-                    list_array<list_array<uint8_t>> sky_light;
-                    list_array<list_array<uint8_t>> block_light;
+                    list_array<list_array_fixed<uint8_t, 2048>> sky_light;
+                    list_array<list_array_fixed<uint8_t, 2048>> block_light;
+                    //light_data is stored in network layout, so it copied as is
+                    static auto convert_light = [](const base_objects::world::light_data& light) {
+                        if (auto packed = light.packed(); packed)
+                            return list_array_fixed<uint8_t, 2048>(packed->data(), packed->size());
+                        base_objects::world::light_data::packed_t uniform;
+                        light.copy_to(uniform.data());
+                        return list_array_fixed<uint8_t, 2048>(uniform.data(), uniform.size());
+                    };
                     {
                         //light below world is unset
                         sky_light_mask.push_back(false);
@@ -278,35 +299,15 @@ namespace copper_server {
                         empty_sky_light_mask.push_back(true);
                         empty_block_light_mask.push_back(true);
                         for (auto& section : chunk.sub_chunks) {
-                            sky_light_mask.push_back(section.sky_lighted);
-                            block_light_mask.push_back(section.block_lighted);
-                            empty_sky_light_mask.push_back(section.sky_lighted);
-                            empty_block_light_mask.push_back(section.block_lighted);
-
-                            if (section.sky_lighted) {
-                                bit_list_array<> section_sky_light;
-                                for (auto& x : section.sky_light.light_map)
-                                    for (auto& y : x)
-                                        for (auto z : y) {
-                                            section_sky_light.push_back(z.light_point & 1);
-                                            section_sky_light.push_back(z.light_point & 2);
-                                            section_sky_light.push_back(z.light_point & 4);
-                                            section_sky_light.push_back(z.light_point & 8);
-                                        }
-                                sky_light.push_back(section_sky_light.take());
-                            }
-                            if (section.block_lighted) {
-                                bit_list_array<> section_block_light;
-                                for (auto& x : section.block_light.light_map)
-                                    for (auto& y : x)
-                                        for (auto z : y) {
-                                            section_block_light.push_back(z.light_point & 1);
-                                            section_block_light.push_back(z.light_point & 2);
-                                            section_block_light.push_back(z.light_point & 4);
-                                            section_block_light.push_back(z.light_point & 8);
-                                        }
-                                block_light.push_back(section_block_light.take());
-                            }
+                            sky_light_mask.push_back(section->sky_lighted);
+                            block_light_mask.push_back(section->block_lighted);
+                            empty_sky_light_mask.push_back(section->sky_lighted);
+                            empty_block_light_mask.push_back(section->block_lighted);
+
+                            if (section->sky_lighted)
+                                sky_light.push_back(convert_light(section->sky_light));
+                            if (section->block_lighted)
+                                block_light.push_back(convert_light(section->block_light));
                         }
                         //light above world is unset
                         sky_light_mask.push_back(false);
@@ -315,17 +316,6 @@ namespace copper_server {
                         empty_block_light_mask.push_back(true);
                     }
 
-
-                    static auto convert_light = [](list_array<list_array<uint8_t>>&& arr) {
-                        return arr
-                            .take()
-                            .convert_fn(
-                                [](list_array<uint8_t>&& it) {
-                                    return it.to_container<list_array_fixed<uint8_t, 2048>>();
-                                }
-                            );
-                    };
-
                     light_update update;
                     update.x = (int32_t)chunk.chunk_x;
                     update.z = (int32_t)chunk.chunk_z;
@@ -333,8 +323,8 @@ namespace copper_server {
                     update.block_light_mask = block_light_mask.data();
                     update.empty_sky_light_mask = empty_sky_light_mask.data();
                     update.empty_block_light_mask = empty_block_light_mask.data();
-                    update.sky_light = convert_light(std::move(sky_light));
-                    update.block_light = convert_light(std::move(block_light));
+                    update.sky_light = std::move(sky_light);
+                    update.block_light = std::move(block_light);
                     return update;
                 }
 
@@ -348,46 +338,28 @@ namespace copper_server {
 
                 bundle_delimiter::bundle_delimiter(const list_array<play_packet>&& copy) : packets(copy) {}
 
+                //bit field layout is implementation defined, so values packed explicitly in protocol order
                 uint64_t section_blocks_update::position_t::to_packet() const {
-                    union {
-                        uint64_t r;
-                        position_t v;
-                    } tmp;
-
-                    tmp.v = *this;
-                    return tmp.r;
+                    return (uint64_t(x) << 42) | (uint64_t(z) << 20) | uint64_t(y);
                 }
 
                 section_blocks_update::position_t section_blocks_update::position_t::from_packet(uint64_t value) {
-                    union {
-                        uint64_t v;
-                        position_t r;
-                    } tmp;
-
-                    tmp.v = value;
-                    return tmp.r;
+                    return {.x = (value >> 42) & 0x3FFFFF, .z = (value >> 20) & 0x3FFFFF, .y = value & 0xFFFFF};
                 }
 
                 var_int64 section_blocks_update::block_entry::to_packet() const {
-                    union {
-                        int64_t r;
-                        block_entry v;
-                    } tmp;
-
-                    tmp.v = *this;
-                    return tmp.r;
+                    return int64_t(block_state) << 12 | int64_t(local_x) << 8 | int64_t(local_z) << 4 | int64_t(local_y);
                 }
 
                 section_blocks_update::block_entry section_blocks_update::block_entry::from_packet(var_int64 value) {
-                    union {
-                        int64_t v;
-                        block_entry r;
-                    } tmp;
-
-                    tmp.v = value;
-                    return tmp.r;
+                    int64_t raw = value.value;
+                    return {
+                        .block_state = uint32_t(raw >> 12) & 0xFFFFF,
+                        .local_x = uint32_t(raw >> 8) & 15,
+                        .local_z = uint32_t(raw >> 4) & 15,
+                        .local_y = uint32_t(raw) & 15,
+                    };
                 }
-
             }
         }
 
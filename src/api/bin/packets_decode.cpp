@@ -6,6 +6,8 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
+#include <algorithm>
+#include <src/api/configuration.hpp>
 #include <src/api/network/tcp.hpp>
 #include <src/api/packets.hpp>
 #include <src/base_objects/shared_client_data.hpp>
@@ -590,8 +592,141 @@ namespace copper_server::api::packets {
     static const auto server_configuration_dec = decoders_server<server_bound::configuration_packet::base>::make();
     static const auto server_play_dec = decoders_server<server_bound::play_packet::base>::make();
 
+    template <class A>
+    struct packet_names {};
+
+    template <class... Args>
+    struct packet_names<std::variant<Args...>> {
+        static constexpr std::array<std::string_view, sizeof...(Args)> make() {
+            std::array<std::string_view, sizeof...(Args)> flat;
+            (
+                [&]() {
+                    flat.at(Args::packet_id::value) = reflect::get_pretty_type_name<Args>();
+                }(),
+                ...
+            );
+            return flat;
+        }
+    };
+
+    static constexpr auto server_play_names = packet_names<server_bound::play_packet::base>::make();
+    using budget_clock = base_objects::network::packet_budget::clock;
+    using limit_action = configuration::ServerConfiguration::Protocol::PacketLimit::action_t;
+
+    struct packet_limit_state {
+        std::atomic_uint32_t per_second = 0;
+        std::atomic_uint32_t processing_ms = 0;
+        std::atomic<limit_action> action = limit_action::drop;
+        std::atomic_uint64_t received = 0;
+        std::atomic_uint64_t dropped = 0;
+        std::atomic_uint64_t delayed = 0;
+        std::atomic_uint64_t kicked = 0;
+    };
+
+    static std::array<packet_limit_state, server_play_names.size()> server_play_limits;
+    static std::atomic_bool packet_limits_enabled = false;
+    static std::mutex offenders_mutex;
+    static std::unordered_map<std::string, uint64_t> offenders;
+
+    void reload_packet_limits() {
+        auto& config = api::configuration::get().protocol.packet_limits;
+        bool enabled = false;
+        for (size_t i = 0; i < server_play_names.size(); i++) {
+            auto& state = server_play_limits[i];
+            auto it = config.find(std::string(server_play_names[i]));
+            if (it != config.end()) {
+                state.per_second = it->second.per_second;
+                state.processing_ms = it->second.processing_ms;
+                state.action = it->second.action;
+                enabled |= it->second.per_second || it->second.processing_ms;
+            } else {
+                state.per_second = 0;
+                state.processing_ms = 0;
+            }
+        }
+        for (auto& [name, _] : config)
+            if (std::find(server_play_names.begin(), server_play_names.end(), name) == server_play_names.end())
+                log::warn("protocol", "packet limit set for unknown play packet: " + name);
+        packet_limits_enabled = enabled;
+    }
+
+    list_array<packet_limit_stats> get_packet_limit_stats() {
+        list_array<packet_limit_stats> res;
+        for (size_t i = 0; i < server_play_names.size(); i++) {
+            auto& state = server_play_limits[i];
+            packet_limit_stats stats{server_play_names[i], state.received, state.dropped, state.delayed, state.kicked};
+            if (stats.received || stats.dropped || stats.delayed || stats.kicked)
+                res.push_back(stats);
+        }
+        return res;
+    }
+
+    list_array<std::pair<std::string, uint64_t>> get_packet_limit_offenders(size_t max_count) {
+        std::vector<std::pair<std::string, uint64_t>> res;
+        {
+            std::lock_guard guard(offenders_mutex);
+            res.assign(offenders.begin(), offenders.end());
+        }
+        std::sort(res.begin(), res.end(), [](auto& a, auto& b) { return a.second > b.second; });
+        if (res.size() > max_count)
+            res.resize(max_count);
+        return list_array<std::pair<std::string, uint64_t>>(res.begin(), res.end());
+    }
+
+    void reset_packet_limit_stats() {
+        for (auto& state : server_play_limits) {
+            state.received = 0;
+            state.dropped = 0;
+            state.delayed = 0;
+            state.kicked = 0;
+        }
+        std::lock_guard guard(offenders_mutex);
+        offenders.clear();
+    }
+
+    //returns false when packet must not be handled
+    bool check_packet_limit(SharedClientData& context, size_t packet_id) {
+        auto& state = server_play_limits[packet_id];
+        ++state.received;
+        uint32_t per_second = state.per_second;
+        uint32_t processing_ms = state.processing_ms;
+        if (!per_second && !processing_ms)
+            return true;
+        if (context.packet_budget.allows(packet_id, per_second, processing_ms, budget_clock::now()))
+            return true;
+        {
+            std::lock_guard guard(offenders_mutex);
+            ++offenders[context.name];
+        }
+        switch (state.action.load()) {
+        case limit_action::drop:
+        default:
+            ++state.dropped;
+            return false;
+        case limit_action::delay:
+            ++state.delayed;
+            //decode could run on game worker, so nothing waits here, transport handles packet again after window end
+            context.packet_budget.delay(context.packet_budget.window_end());
+            return false;
+        case limit_action::kick:
+            ++state.kicked;
+            send(context, client_bound::play::disconnect{.reason = "Too many " + std::string(server_play_names[packet_id]) + " packets"});
+            return false;
+        }
+    }
+
     bool decode(SharedClientData& context, ArrayStream& stream) {
         auto packet_id = stream.read_var<int32_t>();
+        if (packet_limits_enabled && context.packets_state.state == SharedClientData::packets_state_t::protocol_state::play) {
+            if (packet_id < 0 || size_t(packet_id) >= server_play_limits.size())
+                throw std::out_of_range("invalid packet id");
+            if (!check_packet_limit(context, size_t(packet_id)))
+                return false;
+            auto started = budget_clock::now();
+            bool res = !server_handle_play_dec.at(packet_id)(context, stream);
+            context.packet_budget.processed(size_t(packet_id), budget_clock::now() - started);
+            return res;
+        }
         switch (context.packets_state.state) {
         case SharedClientData::packets_state_t::protocol_state::handshake:
             return !server_handle_handshake_dec.at(packet_id)(context, stream);
@@ -6,11 +6,13 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
+#include <src/api/configuration.hpp>
 #include <src/api/network/tcp.hpp>
 #include <src/api/packets.hpp>
 #include <src/base_objects/shared_client_data.hpp>
 #include <src/base_objects/slot.hpp>
 #include <src/log.hpp>
+#include <src/storage/world_data.hpp>
 #include <src/util/reflect.hpp>
 #include <tuple>
 
@@ -627,6 +629,23 @@ namespace copper_server::api::packets {
         return true;
     }
 
+    bool send_chunk(SharedClientData& client, const storage::chunk_data& chunk, const storage::world_data& world) {
+        using packet_t = client_bound::play::level_chunk_with_light;
+        if (debugging_enabled || __internal::has_client_viewers(3, packet_t::packet_id::value))
+            return send(client, packet_t::create(chunk, world));
+        bool with_block_entities = api::configuration::get().protocol.send_nbt_data_in_chunk;
+        auto encoded = chunk.packet_cache.get((chunk.revision() << 1) | with_block_entities, [&] {
+            //chunk packet does not depend on client, so it serialized without one
+            SharedClientData context;
+            base_objects::network::response res;
+            auto packet = packet_t::create(chunk, world);
+            serialize_packet(res, context, packet);
+            return std::move(res.data.front());
+        });
+        client.sendPacket(base_objects::network::response(*encoded));
+        return true;
+    }
+
     base_objects::network::response internal_encode(SharedClientData& client, client_bound_packet&& packet) {
         return std::visit(
             [&client](auto& mode) -> base_objects::network::response {
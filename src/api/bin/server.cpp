@@ -11,6 +11,7 @@
 namespace copper_server::api::server {
     bool shutdown_command = false;
     base_objects::events::event<void> shutdown_event;
+    base_objects::events::event<void> tick_end_event;
 
     void shutdown(){
         shutdown_command = true;
@@ -71,6 +71,7 @@ namespace copper_server::api::configuration {
 
         struct Protocol {
             int32_t compression_threshold = -1;
+            std::string compression_backend = "zlib"; //built in are 'zlib' and 'zlib_fast', plugins could register other
             uint32_t rate_limit = 0; //0 for unlimited, in bytes per second
             bool handle_legacy = false;
             uint16_t new_client_buffer = 100;       //buffer for new connections, in bytes, used to prevent DoS attacks
@@ -79,7 +80,9 @@ namespace copper_server::api::configuration {
             uint16_t max_send_packet_size = 8192;   //8192 bytes, maximum packet size, if packet is too large then client will be disconnected
             float timeout_seconds = 30;
             float keep_alive_send_each_seconds = 20;
-            float all_connections_timeout_seconds = 30000; //30 sec
+            float all_connections_timeout_seconds = 30;   //disconnects any connection which sends nothing for this time, 0 to disable
+            uint32_t send_buffer_flush_size = 32768;      //packets are collected and sent once per tick, if collected data grows over this size it sent earlier
+            uint32_t inbound_queue_size = 256;            //play packets waiting for game workers per connection, connection is not read while full, 0 handles packets on connection task
 
 
             bool prevent_proxy_connections = false; //	If the ISP/AS sent from the server is different from the one from Mojang Studios' authentication server, the player is kicked.
@@ -91,6 +94,20 @@ namespace copper_server::api::configuration {
                 prevent_join
             } connection_conflict
                 = connection_conflict_t::kick_connected;
+
+            struct PacketLimit {
+                uint32_t per_second = 0;    //0 for unlimited
+                uint32_t processing_ms = 0; //time spent on handling in each second, 0 for unlimited
+
+                enum class action_t {
+                    drop,
+                    delay, //packet handled when next second starts
+                    kick
+                } action
+                    = action_t::drop;
+            };
+
+            std::unordered_map<std::string, PacketLimit> packet_limits; //per client limits for play packets by name, like 'move_player_pos'
         } protocol;
 
         //in this struct everything can be disabled by setting to zero
@@ -140,6 +157,12 @@ namespace copper_server::api::configuration {
 
         struct Mojang {
             bool enforce_secure_profile = true; //enables signature signing for chat messages using mojang's service
+            std::string session_server = "sessionserver.mojang.com"; //could be replaced with local server for testing
+            uint16_t session_server_port = 80;
+            std::string session_server_path = "/session/minecraft/hasJoined";
+            uint32_t session_cache_seconds = 1200;        //cached join checks, 0 to disable
+            uint32_t session_max_concurrent_requests = 8; //other checks wait for free request
+            uint32_t session_max_idle_connections = 4;    //kept open for next checks
         } mojang;
 
         struct Query {
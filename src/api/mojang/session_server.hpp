@@ -12,6 +12,8 @@
 
 namespace copper_server::api::mojang {
     ::mojang::api::session_server& get_session_server();
+    //applies mojang section of configuration
+    void reload_session_server();
 }
 
 
@@ -11,7 +11,10 @@
 #include <library/list_array.hpp>
 #include <src/base_objects/atomic_holder.hpp>
 #include <src/base_objects/events/sync_event.hpp>
+#include <src/base_objects/network/compression.hpp>
 
+#include <memory>
+#include <mutex>
 #include <span>
 
 namespace copper_server::base_objects {
@@ -31,6 +34,10 @@ namespace copper_server::api::network::tcp {
         int32_t compression_threshold = -1;
         bool is_not_legacy : 1 = false;
 
+        //created on first compressed packet from `protocol.compression_backend`
+        std::unique_ptr<base_objects::network::compressor> compression;
+        std::mutex compression_mutex; //guards creation of `compression` and compressing, decompressing does not lock it
+
         session(uint64_t id) : id(id) {}
 
         virtual ~session() {}
@@ -44,6 +51,14 @@ namespace copper_server::api::network::tcp {
         virtual void request_buffer(size_t) {}
 
         virtual void send_indirect(base_objects::network::response&&) = 0;
+
+        //sends packets collected by `send_indirect`
+        virtual void flush() {}
+
+        //for work which continues after packet handler returned, expires with session
+        virtual std::weak_ptr<session> weak_ref() {
+            return {};
+        }
     };
 
     bool decrypt_data(list_array<uint8_t>& data);
@@ -3505,6 +3505,9 @@ namespace copper_server {
 
 
         bool send(base_objects::SharedClientData& client, client_bound_packet&&);
+        //sends level_chunk_with_light serialized once per chunk revision and shared by all viewers
+        //falls back to `send` when debug mode enabled or packet has viewers, they require packet object
+        bool send_chunk(base_objects::SharedClientData& client, const storage::chunk_data& chunk, const storage::world_data& world);
         base_objects::network::response internal_encode(base_objects::SharedClientData& client, client_bound_packet&&);
         base_objects::network::response encode(client_bound_packet&& packet);
         base_objects::network::response encode(server_bound_packet&& packet);
@@ -3550,11 +3553,28 @@ namespace copper_server {
 
         void set_debug_mode(bool enabled);
 
+        struct packet_limit_stats {
+            std::string_view name;
+            uint64_t received; //counted only while limits enabled
+            uint64_t dropped;
+            uint64_t delayed;
+            uint64_t kicked;
+        };
+
+        //applies `protocol.packet_limits` to server bound play packets
+        void reload_packet_limits();
+        //only packets which were received at least once
+        list_array<packet_limit_stats> get_packet_limit_stats();
+        //clients which exceeded limits most times, by name
+        list_array<std::pair<std::string, uint64_t>> get_packet_limit_offenders(size_t max_count);
+        void reset_packet_limit_stats();
+
         namespace __internal {
             base_objects::events::event_register_id register_client_viewer(uint8_t mode, size_t id, base_objects::events::sync_event<client_bound_packet&, base_objects::SharedClientData&>::function&&);
             base_objects::events::event_register_id register_server_viewer(uint8_t mode, size_t id, base_objects::events::sync_event<server_bound_packet&, base_objects::SharedClientData&>::function&&);
             base_objects::events::event_register_id register_viewer_post_send_client_bound(uint8_t mode, size_t id, std::function<void(client_bound_packet&, base_objects::SharedClientData&)>&&);
             base_objects::events::event_register_id register_server_processor(uint8_t mode, size_t id, std::function<void(server_bound_packet&&, base_objects::SharedClientData&)>&&);
+            bool has_client_viewers(uint8_t mode, size_t id);
 
             void unregister_client_viewer(uint8_t mode, size_t id, base_objects::events::event_register_id);
             void unregister_server_viewer(uint8_t mode, size_t id, base_objects::events::event_register_id);
@@ -12,6 +12,8 @@
 
 namespace copper_server::api::server {
     extern base_objects::events::event<void> shutdown_event;
+    //called after every server tick, used to flush data collected during tick
+    extern base_objects::events::event<void> tick_end_event;
 
     void shutdown();
     bool is_shutting_down();
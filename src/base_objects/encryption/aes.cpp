@@ -6,6 +6,7 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
+#include <algorithm>
 #include <src/base_objects/encryption/aes.hpp>
 
 namespace copper_server::encryption {
@@ -50,4 +51,32 @@ namespace copper_server::encryption {
         }
         out.resize(outlen);
     }
+
+    bool aes::encrypt(uint8_t* data, size_t size) {
+        if (!enc_ctx)
+            return false;
+        while (size) {
+            int part = (int)std::min<size_t>(size, INT32_MAX);
+            int outlen = 0;
+            if (EVP_EncryptUpdate(enc_ctx, data, &outlen, data, part) != 1 || outlen != part)
+                return false;
+            data += part;
+            size -= part;
+        }
+        return true;
+    }
+
+    bool aes::decrypt(uint8_t* data, size_t size) {
+        if (!dec_ctx)
+            return false;
+        while (size) {
+            int part = (int)std::min<size_t>(size, INT32_MAX);
+            int outlen = 0;
+            if (EVP_DecryptUpdate(dec_ctx, data, &outlen, data, part) != 1 || outlen != part)
+                return false;
+            data += part;
+            size -= part;
+        }
+        return true;
+    }
 }
\ No newline at end of file
@@ -24,6 +24,9 @@ namespace copper_server::encryption {
         bool initialize(const list_array<uint8_t>& key, const list_array<uint8_t>& iv);
         void encrypt(const list_array<uint8_t>& data, list_array<uint8_t>& out);
         void decrypt(const list_array<uint8_t>& data, list_array<uint8_t>& out);
+        //in place, cfb8 does not change data size
+        bool encrypt(uint8_t* data, size_t size);
+        bool decrypt(uint8_t* data, size_t size);
 
     private:
         EVP_CIPHER_CTX* enc_ctx = nullptr;
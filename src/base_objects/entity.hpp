@@ -19,6 +19,8 @@
 #include <src/base_objects/events/sync_event.hpp>
 #include <src/base_objects/slot.hpp>
 #include <src/base_objects/world/block_action.hpp>
+#include <src/base_objects/world/chunk_bitmap.hpp>
+#include <src/base_objects/world/chunk_send_queue.hpp>
 #include <src/util/calculations.hpp>
 #include <stdint.h>
 
@@ -146,8 +148,11 @@ namespace copper_server {
             struct world_processor { //used to handle changes applied for entity and implement AI or send changes to client
                 void (*entity_init)(entity& self, entity&) = nullptr;
 
+                //movement callbacks are batched by world and fired once per `track_tick_interval`
+                //entity_teleport also used to sync entity for viewer which did not track it before, it carries current rotation and motion
                 void (*entity_teleport)(entity& self, entity&, util::VECTOR new_pos) = nullptr;
                 void (*entity_move)(entity& self, entity&, util::VECTOR move) = nullptr;
+                void (*entity_move_rotate)(entity& self, entity&, util::VECTOR move, util::ANGLE_DEG new_rotation) = nullptr; //if nullptr then entity_move and entity_rotation_changes used
                 void (*entity_look_changes)(entity& self, entity&, util::ANGLE_DEG new_rotation) = nullptr;
                 void (*entity_rotation_changes)(entity& self, entity&, util::ANGLE_DEG new_rotation) = nullptr;
                 void (*entity_motion_changes)(entity& self, entity&, util::VECTOR new_motion) = nullptr;
@@ -196,7 +201,8 @@ namespace copper_server {
                 void (*notify_sub_chunk_light)(entity& self, int64_t chunk_x, int64_t chunk_y, int64_t chunk_z, const world::sub_chunk_data&) = nullptr; //used after multiply changes
                 void (*notify_chunk_light)(entity& self, int64_t chunk_x, int64_t chunk_z, const storage::chunk_data&) = nullptr;                        //used after multiply changes
 
-                void (*notify_sub_chunk_blocks)(entity& self, int64_t chunk_x, int64_t chunk_y, int64_t chunk_z, const world::sub_chunk_data&) = nullptr; //used after multiply changes
+                //blocks changed in section during tick, `positions` are 0xXYZ local indexes, chunk_y is section y in world coordinates
+                void (*notify_sub_chunk_blocks)(entity& self, int64_t chunk_x, int64_t chunk_y, int64_t chunk_z, const world::sub_chunk_data&, const std::vector<uint16_t>& positions) = nullptr;
                 void (*notify_chunk_blocks)(entity& self, int64_t chunk_x, int64_t chunk_z, const storage::chunk_data&) = nullptr;                        //used after multiply changes
 
                 void (*on_change_world)(entity& self, storage::world_data& new_world) = nullptr;
@@ -280,7 +286,7 @@ namespace copper_server {
             };
 
             struct world_syncing {
-                bit_list_array<> processed_chunks;
+                world::chunk_bitmap processed_chunks;
                 base_objects::cubic_bounds_chunk_radius processing_region;
                 uint64_t assigned_world_id = (uint64_t)-1;
                 storage::world_data* world = nullptr;
@@ -290,17 +296,15 @@ namespace copper_server {
                 bool is_sleeping : 1 = false;
                 bool is_sneaking : 1 = false;
                 bool is_sprinting : 1 = false;
+                uint64_t processing_revision = 0; //changes when processing region moved or flushed
+                world::chunk_send_queue chunk_sending;
 
                 bool mark_chunk(int64_t pos_x, int64_t pos_z, bool loaded) {
                     if (pos_x > INT32_MAX || pos_x < INT32_MIN || pos_z > INT32_MAX || pos_z < INT32_MIN)
                         return false;
                     if (!processing_region.in_bounds(pos_x, pos_z))
                         return false;
-
-                    int64_t offset_x = pos_x - (processing_region.center_x - processing_region.radius);
-                    int64_t offset_z = pos_z - (processing_region.center_z - processing_region.radius);
-                    size_t index = offset_z * (processing_region.radius + processing_region.radius + 1) + offset_x;
-                    processed_chunks.set(index, loaded);
+                    processed_chunks.set(pos_x, pos_z, loaded);
                     return true;
                 }
 
@@ -316,44 +320,17 @@ namespace copper_server {
 
                     if (!processing_region.in_bounds(pos_x, pos_z))
                         return false;
-                    uint64_t offset_x = pos_x - (processing_region.center_x - processing_region.radius);
-                    uint64_t offset_z = pos_z - (processing_region.center_z - processing_region.radius);
-
-
-                    size_t index = offset_z * (processing_region.radius + processing_region.radius + 1) + offset_x;
-                    return processed_chunks.at(index);
+                    return processed_chunks.get(pos_x, pos_z);
                 }
 
+                //chunks which stays in region keeps their state, only newly exposed rows and columns are cleared
                 void update_processing(int32_t center_x, int32_t center_z, uint8_t render_distance) {
-                    if (processing_region.center_x == center_x && processing_region.center_z == center_z && processing_region.radius == render_distance)
+                    int64_t new_radius = int64_t(render_distance) + 3;
+                    if (processing_region.center_x == center_x && processing_region.center_z == center_z && processing_region.radius == new_radius)
                         return;
-                    auto new_processing_diameter = 2 * render_distance + 7;
-                    bit_list_array<> new_processing_data(new_processing_diameter * new_processing_diameter);
-
-                    auto processing_diameter = (processing_region.radius + processing_region.radius + 1);
-                    int32_t new_radius = new_processing_diameter / 2;
-
-                    for (int32_t dz = 0; dz < new_processing_diameter; ++dz) {
-                        for (int32_t dx = 0; dx < new_processing_diameter; ++dx) {
-                            // World coordinates for this chunk in the new area
-                            int32_t chunk_x = center_x - new_radius + dx;
-                            int32_t chunk_z = center_z - new_radius + dz;
-
-                            // Map to old area offsets
-                            int64_t old_offset_x = chunk_x - (processing_region.center_x - processing_region.radius);
-                            int64_t old_offset_z = chunk_z - (processing_region.center_z - processing_region.radius);
-
-                            // If the chunk was loaded in the old area, copy its bit
-                            if (old_offset_x >= 0 && old_offset_x < processing_diameter && old_offset_z >= 0 && old_offset_z < processing_diameter) {
-                                size_t old_index = old_offset_z * processing_diameter + old_offset_x;
-                                size_t new_index = dz * new_processing_diameter + dx;
-                                if (processed_chunks[old_index])
-                                    new_processing_data.set(new_index, true);
-                            }
-                        }
-                    }
                     processing_region = {center_x, center_z, new_radius};
-                    processed_chunks = std::move(new_processing_data);
+                    processed_chunks.move(processing_region);
+                    ++processing_revision;
                 }
 
                 void update_render_distance(uint8_t render_distance) {
@@ -362,19 +339,22 @@ namespace copper_server {
 
 
                 void flush_processing() {
-                    auto diameter = processing_region.radius + processing_region.radius + 1;
-                    processed_chunks = bit_list_array<>(diameter * diameter);
+                    processed_chunks.reset(processing_region);
+                    ++processing_revision;
                 }
 
                 template <class FN>
                 void for_each_processing(FN&& fn) {
-                    auto diameter = processing_region.radius + processing_region.radius + 1;
-                    auto x_offset_pre = processing_region.center_x - processing_region.radius;
-                    auto z_offset_pre = processing_region.center_z - processing_region.radius;
                     processing_region.enum_points_from_center([&](auto x, auto z) {
-                        fn(x, z, processed_chunks.at((z - z_offset_pre) * diameter + (x - x_offset_pre)));
+                        fn(x, z, processed_chunks.get(x, z));
                     });
                 }
+
+                //calls `fn(x, z)` for chunks in region which are not sent yet
+                template <class FN>
+                void for_each_not_processed(FN&& fn) const {
+                    processed_chunks.for_each_unset(std::forward<FN>(fn));
+                }
             };
 
             enbt::raw_uuid id;
@@ -79,6 +79,10 @@ namespace copper_server::base_objects::events {
             return false;
         }
 
+        bool empty() const {
+            return heigh_priority.empty() && upper_avg_priority.empty() && avg_priority.empty() && lower_avg_priority.empty() && low_priority.empty();
+        }
+
         void clear() {
             heigh_priority.clear();
             upper_avg_priority.clear();
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <mutex>
+#include <src/base_objects/network/compression.hpp>
+#include <stdexcept>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace copper_server::base_objects::network {
+    class zlib_compressor : public compressor {
+        z_stream deflate_stream{};
+        z_stream inflate_stream{};
+
+        static void check_size(size_t size) {
+            if (decltype(z_stream::avail_in)(-1) < size)
+                throw std::overflow_error("packet size is too large for zlib");
+        }
+
+    public:
+        zlib_compressor(int level, int mem_level) {
+            if (deflateInit2(&deflate_stream, level, Z_DEFLATED, MAX_WBITS, mem_level, Z_DEFAULT_STRATEGY) != Z_OK)
+                throw std::runtime_error("deflateInit failed");
+            if (inflateInit(&inflate_stream) != Z_OK) {
+                deflateEnd(&deflate_stream);
+                throw std::runtime_error("inflateInit failed");
+            }
+        }
+
+        ~zlib_compressor() override {
+            deflateEnd(&deflate_stream);
+            inflateEnd(&inflate_stream);
+        }
+
+        size_t bound(size_t size) override {
+            check_size(size);
+            return deflateBound(&deflate_stream, (uLong)size);
+        }
+
+        size_t compress(const uint8_t* in, size_t size, uint8_t* out, size_t out_size) override {
+            check_size(size);
+            check_size(out_size);
+            //reset keeps allocated window and hash tables
+            if (deflateReset(&deflate_stream) != Z_OK)
+                throw std::runtime_error("deflateReset failed");
+            deflate_stream.next_in = const_cast<uint8_t*>(in);
+            deflate_stream.avail_in = (uInt)size;
+            deflate_stream.next_out = out;
+            deflate_stream.avail_out = (uInt)out_size;
+            if (deflate(&deflate_stream, Z_FINISH) != Z_STREAM_END)
+                throw std::runtime_error("deflate failed");
+            return deflate_stream.total_out;
+        }
+
+        void decompress(const uint8_t* in, size_t size, uint8_t* out, size_t out_size) override {
+            check_size(size);
+            check_size(out_size);
+            if (inflateReset(&inflate_stream) != Z_OK)
+                throw std::runtime_error("inflateReset failed");
+            inflate_stream.next_in = const_cast<uint8_t*>(in);
+            inflate_stream.avail_in = (uInt)size;
+            inflate_stream.next_out = out;
+            inflate_stream.avail_out = (uInt)out_size;
+            if (inflate(&inflate_stream, Z_FINISH) != Z_STREAM_END || inflate_stream.total_out != out_size)
+                throw std::runtime_error("inflate failed");
+        }
+    };
+
+    struct compressors_t {
+        std::mutex mutex;
+        std::unordered_map<std::string, compressor_factory> factories{
+            {"zlib", [] { return std::make_unique<zlib_compressor>(Z_DEFAULT_COMPRESSION, 8); }},
+            //fastest zlib level, uses deflate_fast which is several times faster on chunk data with slightly worse ratio
+            {"zlib_fast", [] { return std::make_unique<zlib_compressor>(Z_BEST_SPEED, 8); }},
+        };
+    };
+
+    compressors_t& compressors() {
+        static compressors_t instance;
+        return instance;
+    }
+
+    void register_compressor(const std::string& name, compressor_factory&& factory) {
+        auto& instance = compressors();
+        std::lock_guard guard(instance.mutex);
+        instance.factories[name] = std::move(factory);
+    }
+
+    bool has_compressor(const std::string& name) {
+        auto& instance = compressors();
+        std::lock_guard guard(instance.mutex);
+        return instance.factories.contains(name);
+    }
+
+    std::unique_ptr<compressor> make_compressor(const std::string& name) {
+        auto& instance = compressors();
+        std::lock_guard guard(instance.mutex);
+        auto it = instance.factories.find(name);
+        if (it == instance.factories.end())
+            throw std::invalid_argument("compression backend " + name + " not registered");
+        return it->second();
+    }
+}
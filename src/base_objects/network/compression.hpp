@@ -0,0 +1,41 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_BASE_OBJECTS_NETWORK_COMPRESSION
+#define SRC_BASE_OBJECTS_NETWORK_COMPRESSION
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace copper_server::base_objects::network {
+    //per connection packet compression state, contexts are kept between packets
+    //output must be zlib stream, this is what client expects
+    //`compress` and `decompress` could be called concurrently with each other, but each of them from one thread at time
+    class compressor {
+    public:
+        virtual ~compressor() = default;
+
+        //maximal compressed size of `size` bytes
+        virtual size_t bound(size_t size) = 0;
+        //returns compressed size, `out_size` must be at least `bound(size)`
+        virtual size_t compress(const uint8_t* in, size_t size, uint8_t* out, size_t out_size) = 0;
+        //`out_size` is exact uncompressed size, throws when data is invalid or uncompressed size differs
+        virtual void decompress(const uint8_t* in, size_t size, uint8_t* out, size_t out_size) = 0;
+    };
+
+    using compressor_factory = std::function<std::unique_ptr<compressor>()>;
+
+    //built in backends are `zlib` and `zlib_fast`, plugins could register own
+    void register_compressor(const std::string& name, compressor_factory&& factory);
+    bool has_compressor(const std::string& name);
+    //throws when backend is not registered
+    std::unique_ptr<compressor> make_compressor(const std::string& name);
+}
+
+#endif /* SRC_BASE_OBJECTS_NETWORK_COMPRESSION */
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <src/base_objects/network/packet_budget.hpp>
+
+namespace copper_server::base_objects::network {
+    bool packet_budget::allows(size_t packet_id, uint32_t per_second, uint32_t processing_ms, clock::time_point now) {
+        if (now >= window_end()) {
+            std::fill(entries.begin(), entries.end(), entry{});
+            window_start = now;
+        }
+        if (entries.size() <= packet_id)
+            entries.resize(packet_id + 1);
+        auto& it = entries[packet_id];
+        if (per_second && it.count >= per_second)
+            return false;
+        if (processing_ms && it.processing_us >= uint64_t(processing_ms) * 1000)
+            return false;
+        ++it.count;
+        return true;
+    }
+
+    void packet_budget::processed(size_t packet_id, clock::duration took) {
+        if (entries.size() <= packet_id)
+            return;
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(took).count();
+        auto& it = entries[packet_id];
+        it.processing_us = (uint32_t)std::min<uint64_t>(uint64_t(it.processing_us) + uint64_t(std::max<int64_t>(us, 0)), UINT32_MAX);
+    }
+}
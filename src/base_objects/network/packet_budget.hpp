@@ -0,0 +1,53 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_BASE_OBJECTS_NETWORK_PACKET_BUDGET
+#define SRC_BASE_OBJECTS_NETWORK_PACKET_BUDGET
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace copper_server::base_objects::network {
+    //per client count and processing time of server bound packets by packet id in current second
+    //not thread safe, packets of one client are handled sequentially
+    class packet_budget {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        //`per_second` and `processing_ms` are limits per second, 0 for unlimited
+        bool allows(size_t packet_id, uint32_t per_second, uint32_t processing_ms, clock::time_point now);
+        void processed(size_t packet_id, clock::duration took);
+
+        clock::time_point window_end() const {
+            return window_start + std::chrono::seconds(1);
+        }
+
+        //set by `delay` limit action, transport must handle same packet again not before this time
+        void delay(clock::time_point until) {
+            delayed_until = until;
+        }
+
+        //returns zero time point when last packet was not delayed
+        clock::time_point take_delay() {
+            return std::exchange(delayed_until, clock::time_point());
+        }
+
+    private:
+        struct entry {
+            uint32_t count = 0;
+            uint32_t processing_us = 0;
+        };
+
+        std::vector<entry> entries;
+        clock::time_point window_start;
+        clock::time_point delayed_until;
+    };
+}
+
+#endif /* SRC_BASE_OBJECTS_NETWORK_PACKET_BUDGET */
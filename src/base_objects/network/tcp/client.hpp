@@ -8,6 +8,7 @@
  */
 #ifndef SRC_BASE_OBJECTS_NETWORK_TCP_CLIENT
 #define SRC_BASE_OBJECTS_NETWORK_TCP_CLIENT
+#include <span>
 #include <src/base_objects/network/response.hpp>
 #include <string>
 
@@ -20,7 +21,8 @@ namespace copper_server::base_objects::network::tcp {
     class client {
     protected:
     public:
-        virtual response work_client(list_array<uint8_t>&) = 0;
+        //`valid_till` of result is count of consumed bytes, data is not used after return
+        virtual response work_client(std::span<uint8_t>) = 0;
 
         virtual response on_switch();
 
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <mutex>
+#include <src/base_objects/network/timer_wheel.hpp>
+#include <stdexcept>
+
+namespace copper_server::base_objects::network {
+    wheel_timer::wheel_timer(timer_wheel& wheel, std::function<void()>&& callback)
+        : wheel(wheel), callback(std::move(callback)) {}
+
+    wheel_timer::~wheel_timer() {
+        cancel();
+    }
+
+    void wheel_timer::arm(std::chrono::steady_clock::duration after) {
+        auto ticks = (std::max(after, std::chrono::steady_clock::duration::zero()) + wheel.resolution_ - std::chrono::steady_clock::duration(1)) / wheel.resolution_;
+        auto now = wheel.tick_of(std::chrono::steady_clock::now());
+        std::lock_guard guard(wheel.mutex);
+        if (linked)
+            wheel.unlink(*this);
+        //never in already processed tick, otherwise it would wait whole turn
+        deadline = std::max(now + uint64_t(ticks), wheel.current + 1);
+        wheel.link(*this);
+    }
+
+    bool wheel_timer::cancel() {
+        std::lock_guard guard(wheel.mutex);
+        if (!linked)
+            return false;
+        wheel.unlink(*this);
+        return true;
+    }
+
+    bool wheel_timer::armed() {
+        std::lock_guard guard(wheel.mutex);
+        return linked;
+    }
+
+    timer_wheel::timer_wheel(clock::duration resolution, size_t slots)
+        : slots_(slots, nullptr), started(clock::now()), resolution_(resolution) {
+        if (resolution <= clock::duration::zero() || !slots)
+            throw std::invalid_argument("timer wheel requires positive resolution and slots count");
+    }
+
+    uint64_t timer_wheel::tick_of(clock::time_point point) const {
+        return point <= started ? 0 : uint64_t((point - started) / resolution_);
+    }
+
+    void timer_wheel::link(wheel_timer& timer) {
+        auto& head = slots_[timer.deadline % slots_.size()];
+        timer.prev = nullptr;
+        timer.next = head;
+        if (head)
+            head->prev = &timer;
+        head = &timer;
+        timer.linked = true;
+        ++armed_count;
+    }
+
+    void timer_wheel::unlink(wheel_timer& timer) {
+        if (timer.prev)
+            timer.prev->next = timer.next;
+        else
+            slots_[timer.deadline % slots_.size()] = timer.next;
+        if (timer.next)
+            timer.next->prev = timer.prev;
+        timer.prev = timer.next = nullptr;
+        timer.linked = false;
+        --armed_count;
+    }
+
+    void timer_wheel::collect(size_t slot, uint64_t until) {
+        wheel_timer* it = slots_[slot];
+        while (it) {
+            wheel_timer* next = it->next;
+            if (it->deadline <= until) {
+                unlink(*it);
+                if (it->callback)
+                    due.push_back(it->callback);
+            }
+            it = next;
+        }
+    }
+
+    size_t timer_wheel::advance(clock::time_point now) {
+        std::lock_guard advance_guard(advance_mutex);
+        {
+            std::lock_guard guard(mutex);
+            uint64_t target = tick_of(now);
+            if (target <= current)
+                return 0;
+            if (target - current >= slots_.size()) {
+                //behind for whole turn, every slot has due timers
+                for (size_t i = 0; i < slots_.size(); i++)
+                    collect(i, target);
+            } else {
+                for (uint64_t tick = current + 1; tick <= target; tick++)
+                    collect(tick % slots_.size(), target);
+            }
+            current = target;
+        }
+        size_t fired = due.size();
+        for (auto& it : due) {
+            try {
+                it();
+            } catch (...) {
+            }
+        }
+        due.clear();
+        return fired;
+    }
+}
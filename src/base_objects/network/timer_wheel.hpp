@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_BASE_OBJECTS_NETWORK_TIMER_WHEEL
+#define SRC_BASE_OBJECTS_NETWORK_TIMER_WHEEL
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <library/fast_task.hpp>
+#include <vector>
+
+namespace copper_server::base_objects::network {
+    class timer_wheel;
+
+    //owned by user, cancelled on destruction, wheel must outlive it
+    class wheel_timer {
+        friend class timer_wheel;
+        timer_wheel& wheel;
+        std::function<void()> callback;
+        wheel_timer* prev = nullptr;
+        wheel_timer* next = nullptr;
+        uint64_t deadline = 0;
+        bool linked = false;
+
+    public:
+        wheel_timer(timer_wheel& wheel, std::function<void()>&& callback = nullptr);
+        wheel_timer(const wheel_timer&) = delete;
+        wheel_timer& operator=(const wheel_timer&) = delete;
+        ~wheel_timer();
+
+        //must not be called while timer armed
+        void set_callback(std::function<void()>&& fn) {
+            callback = std::move(fn);
+        }
+
+        //rearms timer when it already armed, `after` rounded up to wheel resolution
+        void arm(std::chrono::steady_clock::duration after);
+        //returns false when timer was not armed
+        bool cancel();
+        bool armed();
+    };
+
+    //hashed timing wheel, arm and cancel are O(1) and does not touch scheduler
+    //timers with deadline further than one wheel turn stays in their slot and skipped until their turn
+    //due timers fired by `advance` in one pass, callbacks called without lock so they could arm timers again
+    //callback could still be called once after `cancel` when it was already taken by running `advance`
+    class timer_wheel {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        timer_wheel(clock::duration resolution, size_t slots);
+
+        //fires all timers with deadline before `now`, returns fired count
+        size_t advance(clock::time_point now);
+
+        clock::duration resolution() const {
+            return resolution_;
+        }
+
+        size_t size() const {
+            return armed_count;
+        }
+
+    private:
+        friend class wheel_timer;
+        uint64_t tick_of(clock::time_point point) const;
+        void link(wheel_timer& timer);
+        void unlink(wheel_timer& timer);
+        void collect(size_t slot, uint64_t until);
+
+        fast_task::task_mutex mutex;
+        std::vector<wheel_timer*> slots_; //heads of intrusive lists
+        std::vector<std::function<void()>> due; //reused between passes, used only by `advance`
+        fast_task::task_mutex advance_mutex; //taken before `mutex`
+        clock::time_point started;
+        clock::duration resolution_;
+        uint64_t current = 0; //last processed tick
+        size_t armed_count = 0;
+    };
+}
+
+#endif /* SRC_BASE_OBJECTS_NETWORK_TIMER_WHEEL */
@@ -8,11 +8,14 @@
  */
 #ifndef SRC_BASE_OBJECTS_PALLETE_CONTAINER
 #define SRC_BASE_OBJECTS_PALLETE_CONTAINER
+#include <bit>
 #include <cassert>
+#include <cstring>
 #include <library/list_array.hpp>
 #include <unordered_map>
 #include <unordered_set>
 #include <variant>
+#include <vector>
 
 namespace copper_server::base_objects {
     struct pallete_data {
@@ -42,6 +45,47 @@ namespace copper_server::base_objects {
                 data.push_back((value >> i) & 1);
         }
 
+        //packs entries into `out` as continuous lsb first bit stream, same layout as produced by `add`
+        //`out` must hold (count * bits + 7) / 8 bytes, values must fit in `bits`
+        static void pack(const uint32_t* values, size_t count, uint8_t bits, uint8_t* out) {
+            auto store = [](uint8_t* to, uint64_t word, size_t bytes) {
+                if constexpr (std::endian::native == std::endian::little)
+                    std::memcpy(to, &word, bytes);
+                else
+                    for (size_t i = 0; i < bytes; i++)
+                        to[i] = uint8_t(word >> (i * 8));
+            };
+            if (!bits || !count)
+                return;
+            uint64_t word = 0;
+            uint8_t used = 0;
+            for (size_t i = 0; i < count; i++) {
+                uint64_t value = values[i];
+                word |= value << used;
+                used += bits;
+                if (used >= 64) {
+                    store(out, word, 8);
+                    out += 8;
+                    used -= 64;
+                    word = value >> (bits - used); //bits which did not fit in stored word
+                }
+            }
+            store(out, word, (used + 7) / 8);
+        }
+
+        //replaces content, word at a time replacement for sequence of `add`
+        void assign(const uint32_t* values, size_t count) {
+            uint32_t all = 0;
+            for (size_t i = 0; i < count; i++)
+                all |= values[i];
+            if (all >= (size_t(1) << bits_per_entry))
+                throw std::out_of_range("value is too large for the given bits_per_entry");
+            std::vector<uint8_t> bytes((count * bits_per_entry + 7) / 8);
+            pack(values, count, (uint8_t)bits_per_entry, bytes.data());
+            data.clear();
+            data.data() = list_array<uint8_t>(bytes.data(), bytes.size());
+        }
+
         template <class FN>
         constexpr void for_each(FN&& fn) {
             data.commit();
@@ -89,6 +133,44 @@ namespace copper_server::base_objects {
         }
     };
 
+    //distinct values in first seen order with fixed capacity, used instead of hash containers while encoding sections
+    template <size_t capacity>
+    class pallete_builder {
+        static constexpr size_t slots = std::bit_ceil(capacity * 2);
+        static constexpr int slot_shift = 32 - std::countr_zero(slots);
+        int32_t keys[slots];
+        uint16_t indexes[slots] = {}; //index + 1, zero is empty slot
+        int32_t values_[capacity];
+        size_t count = 0;
+
+    public:
+        static_assert(capacity < UINT16_MAX);
+
+        //returns index of value and adds it if missing, returns -1 if value is missing and builder is full
+        int32_t insert(int32_t value) {
+            size_t slot = (uint32_t(value) * 0x9E3779B1u) >> slot_shift;
+            while (indexes[slot]) {
+                if (keys[slot] == value)
+                    return indexes[slot] - 1;
+                slot = (slot + 1) & (slots - 1);
+            }
+            if (count == capacity)
+                return -1;
+            keys[slot] = value;
+            values_[count] = value;
+            indexes[slot] = uint16_t(++count);
+            return int32_t(count - 1);
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        const int32_t* values() const {
+            return values_;
+        }
+    };
+
     struct pallete_container_single {
         const uint8_t bits_per_entry = 0;
         int32_t id_of_palette;
@@ -126,6 +208,26 @@ namespace copper_server::base_objects {
                 unique_pallete.insert((int32_t)value);
         }
 
+        //replaces content, result is same as `add` called for each value
+        //distinct values are collected by fixed builder and inserted in same order as `add` does, so palette order is not changed
+        void assign(const int32_t* values, size_t count) {
+            uint32_t all = 0;
+            for (size_t i = 0; i < count; i++)
+                all |= uint32_t(values[i]);
+            if (all >= (size_t(1) << bits_per_entry))
+                throw std::out_of_range("value is too large for the given bits_per_entry");
+
+            data = list_array<int32_t>(values, count);
+            unique_pallete.clear();
+            pallete_builder<max_indirect_blocks + 1> builder;
+            size_t limit = max_indirect() + 1;
+            for (size_t i = 0; i < count && builder.size() < limit; i++)
+                if (i == 0 || values[i] != values[i - 1])
+                    builder.insert(values[i]);
+            for (size_t i = 0; i < builder.size(); i++)
+                unique_pallete.insert(builder.values()[i]);
+        }
+
         std::variant<pallete_container_single, pallete_container_indirect, pallete_data> compile() && {
             if (unique_pallete.size() == 1) {
                 pallete_container_single res;
@@ -133,22 +235,13 @@ namespace copper_server::base_objects {
                 data.clear();
                 unique_pallete.clear();
                 return res;
-            } else if ((is_biomes_mode && unique_pallete.size() <= max_indirect_biomes) || (!is_biomes_mode && unique_pallete.size() <= max_indirect_blocks)) {
-                pallete_container_indirect res(pallete_data::bits_for_max(unique_pallete.size()));
-                std::unordered_map<int32_t, size_t> map;
-                res.palette = to_list_array(unique_pallete);
-                res.palette.for_each([&map](auto it, size_t index) {
-                    map[(int32_t)it] = index;
-                });
-                for (auto it : data)
-                    res.data.add(map[it]);
+            } else if (unique_pallete.size() <= max_indirect()) {
+                auto res = compile_indirect();
                 data.clear();
                 unique_pallete.clear();
                 return res;
             } else {
-                pallete_data res(bits_per_entry);
-                for (auto it : data)
-                    res.add(it);
+                auto res = compile_direct();
                 data.clear();
                 unique_pallete.clear();
                 return res;
@@ -160,24 +253,49 @@ namespace copper_server::base_objects {
                 pallete_container_single res;
                 res.id_of_palette = *unique_pallete.begin();
                 return res;
-            } else if ((is_biomes_mode && unique_pallete.size() <= max_indirect_biomes) || (!is_biomes_mode && unique_pallete.size() <= max_indirect_blocks)) {
-                pallete_container_indirect res(pallete_data::bits_for_max(unique_pallete.size()));
-                std::unordered_map<int32_t, size_t> map;
-                res.palette = to_list_array(unique_pallete);
-                res.palette.for_each([&map](auto it, size_t index) {
-                    map[(int32_t)it] = index;
-                });
-                for (auto it : data)
-                    res.data.add(map[it]);
-                return res;
-            } else {
-                pallete_data res(bits_per_entry);
-                for (auto it : data)
-                    res.add(it);
-                return res;
+            } else if (unique_pallete.size() <= max_indirect())
+                return compile_indirect();
+            else
+                return compile_direct();
+        }
+
+    private:
+        size_t max_indirect() const {
+            return is_biomes_mode ? max_indirect_biomes : max_indirect_blocks;
+        }
+
+        pallete_container_indirect compile_indirect() const {
+            pallete_container_indirect res(pallete_data::bits_for_max(unique_pallete.size()));
+            res.palette = to_list_array(unique_pallete);
+            pallete_builder<max_indirect_blocks + 1> map;
+            for (auto it : res.palette)
+                map.insert(it);
+            std::vector<uint32_t> indexes;
+            indexes.reserve(data.size());
+            int32_t last_value = 0;
+            uint32_t last_index = uint32_t(-1);
+            for (auto it : data) {
+                if (last_index == uint32_t(-1) || it != last_value) {
+                    last_value = it;
+                    last_index = uint32_t(map.insert(it));
+                }
+                indexes.push_back(last_index);
             }
+            res.data.assign(indexes.data(), indexes.size());
+            return res;
+        }
+
+        pallete_data compile_direct() const {
+            pallete_data res(bits_per_entry);
+            std::vector<uint32_t> values;
+            values.reserve(data.size());
+            for (auto it : data)
+                values.push_back(uint32_t(it));
+            res.assign(values.data(), values.size());
+            return res;
         }
 
+    public:
         void decompile(std::variant<pallete_container_single, pallete_container_indirect, pallete_data>&& vars) {
             unique_pallete.clear();
             data.clear();
@@ -18,6 +18,11 @@ namespace copper_server::base_objects {
         ss->send_indirect(std::move(resp));
     }
 
+    void SharedClientData::flushPackets() {
+        if (!special_callback && ss)
+            ss->flush();
+    }
+
     SharedClientData::~SharedClientData() {
         delete &player_data;
     }
@@ -19,6 +19,7 @@
 #include <library/fast_task.hpp>
 #include <library/list_array.hpp>
 #include <src/base_objects/atomic_holder.hpp>
+#include <src/base_objects/network/packet_budget.hpp>
 #include <src/base_objects/ptr_optional.hpp>
 #include <src/mojang/api/session_server.hpp>
 #include <src/plugin/registration.hpp>
@@ -122,6 +123,7 @@ namespace copper_server {
             } packets_state;
 
             std::chrono::milliseconds ping = std::chrono::milliseconds(0);
+            network::packet_budget packet_budget; //used by `protocol.packet_limits`
 
             void registerPlugin(PluginRegistrationPtr plugin) {
                 compatible_plugins.push_back(plugin);
@@ -143,6 +145,9 @@ namespace copper_server {
                 sent = true;
             }
 
+            //sends collected packets now instead of at tick end
+            void flushPackets();
+
             SharedClientData(api::network::tcp::session* ss = nullptr, void* assigned_data = nullptr, std::function<void(base_objects::SharedClientData& self, base_objects::network::response&&)> special_callback = nullptr);
             ~SharedClientData();
 
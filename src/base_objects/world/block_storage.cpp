@@ -0,0 +1,246 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <bit>
+#include <src/base_objects/world/block_storage.hpp>
+
+namespace copper_server::base_objects::world {
+    static size_t words_for(uint8_t bits) {
+        size_t per_word = 64 / bits;
+        return (block_storage::entries_count + per_word - 1) / per_word;
+    }
+
+    static bool is_tickable_id(block_id_t id) {
+        return base_objects::block(id).is_tickable();
+    }
+
+    block_storage::block_storage(block_id_t fill_with)
+        : single_value(fill_with) {}
+
+    uint32_t block_storage::get_packed(uint16_t index) const {
+        uint8_t per_word = 64 / bits;
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        return uint32_t((data[index / per_word] >> ((index % per_word) * bits)) & mask);
+    }
+
+    void block_storage::set_packed(uint16_t index, uint32_t value) {
+        uint8_t per_word = 64 / bits;
+        uint8_t shift = (index % per_word) * bits;
+        uint64_t mask = ((uint64_t(1) << bits) - 1) << shift;
+        auto& word = data[index / per_word];
+        word = (word & ~mask) | ((uint64_t(value) << shift) & mask);
+    }
+
+    block_id_t block_storage::get(uint16_t index) const {
+        switch (mode_) {
+        case mode_t::single:
+            return single_value;
+        case mode_t::indirect:
+            return palette[get_packed(index)];
+        default:
+            return block_id_t(get_packed(index));
+        }
+    }
+
+    void block_storage::set(uint16_t index, block_id_t id) {
+        if (mode_ == mode_t::single) {
+            if (id == single_value)
+                return;
+            ++writes_;
+            tickable = uint16_t((is_tickable_id(single_value) ? entries_count - 1 : 0) + is_tickable_id(id));
+            palette = {single_value, id};
+            palette_counts = {entries_count - 1, 1};
+            palette_used = 2;
+            bits = min_indirect_bits;
+            mode_ = mode_t::indirect;
+            data.assign(words_for(bits), 0);
+            set_packed(index, 1);
+            return;
+        }
+        if (mode_ == mode_t::indirect) {
+            uint32_t old = get_packed(index);
+            if (palette[old] == id)
+                return;
+            ++writes_;
+            uint32_t new_index = palette_add(id);
+            if (mode_ == mode_t::indirect) {
+                tickable = uint16_t(tickable + is_tickable_id(id) - is_tickable_id(palette[old]));
+                set_packed(index, new_index);
+                palette_release(old);
+                return;
+            }
+            //palette overflowed, storage switched to direct mode
+        }
+        block_id_t old = block_id_t(get_packed(index));
+        if (old == id)
+            return;
+        ++writes_;
+        tickable = uint16_t(tickable + is_tickable_id(id) - is_tickable_id(old));
+        set_packed(index, id);
+        ++direct_counts[id];
+        if (auto it = direct_counts.find(old); it != direct_counts.end() && !--it->second) {
+            direct_counts.erase(it);
+            if (direct_counts.size() <= (size_t(1) << max_indirect_bits) / 2)
+                compact();
+        }
+    }
+
+    uint32_t block_storage::palette_add(block_id_t id) {
+        uint32_t free_slot = UINT32_MAX;
+        for (uint32_t i = 0; i < palette.size(); i++) {
+            if (!palette_counts[i]) {
+                if (free_slot == UINT32_MAX)
+                    free_slot = i;
+            } else if (palette[i] == id) {
+                ++palette_counts[i];
+                return i;
+            }
+        }
+        ++palette_used;
+        if (free_slot != UINT32_MAX) {
+            palette[free_slot] = id;
+            palette_counts[free_slot] = 1;
+            return free_slot;
+        }
+        if (palette.size() == (size_t(1) << bits)) {
+            if (bits == max_indirect_bits) {
+                to_direct();
+                return UINT32_MAX;
+            }
+            resize(bits + 1);
+        }
+        palette.push_back(id);
+        palette_counts.push_back(1);
+        return uint32_t(palette.size() - 1);
+    }
+
+    void block_storage::palette_release(uint32_t palette_index) {
+        if (--palette_counts[palette_index])
+            return;
+        --palette_used;
+        //shrink only when half of smaller palette is enough, prevents repacking on every add/remove
+        if (palette_used == 1 || (bits > min_indirect_bits && palette_used <= (size_t(1) << (bits - 1)) / 2))
+            compact();
+    }
+
+    void block_storage::resize(uint8_t new_bits) {
+        std::vector<uint32_t> values(entries_count);
+        for (uint16_t i = 0; i < entries_count; i++)
+            values[i] = get_packed(i);
+        bits = new_bits;
+        data.assign(words_for(bits), 0);
+        for (uint16_t i = 0; i < entries_count; i++)
+            set_packed(i, values[i]);
+    }
+
+    void block_storage::to_direct() {
+        std::vector<block_id_t> values(entries_count);
+        for_each([&](uint16_t index, block_id_t id) { values[index] = id; });
+        direct_counts.clear();
+        for (uint32_t i = 0; i < palette.size(); i++)
+            if (palette_counts[i])
+                direct_counts[palette[i]] = palette_counts[i];
+        std::vector<block_id_t>().swap(palette);
+        std::vector<uint16_t>().swap(palette_counts);
+        palette_used = 0;
+        mode_ = mode_t::direct;
+        bits = direct_bits;
+        data.assign(words_for(bits), 0);
+        for (uint16_t i = 0; i < entries_count; i++)
+            set_packed(i, values[i]);
+    }
+
+    void block_storage::compact() {
+        std::vector<block_id_t> values(entries_count);
+        for_each([&](uint16_t index, block_id_t id) { values[index] = id; });
+        assign(values.data());
+    }
+
+    void block_storage::fill(block_id_t id) {
+        ++writes_;
+        std::vector<uint64_t>().swap(data);
+        std::vector<block_id_t>().swap(palette);
+        std::vector<uint16_t>().swap(palette_counts);
+        direct_counts.clear();
+        palette_used = 0;
+        tickable = 0;
+        bits = 0;
+        single_value = id;
+        mode_ = mode_t::single;
+    }
+
+    void block_storage::assign(const block_id_t* values) {
+        ++writes_;
+        std::unordered_map<block_id_t, uint16_t> counts;
+        std::vector<block_id_t> order;
+        for (uint16_t i = 0; i < entries_count; i++)
+            if (!counts[values[i]]++)
+                order.push_back(values[i]);
+
+        if (order.size() == 1) {
+            fill(order[0]);
+            return;
+        }
+        tickable = 0;
+        for (auto& [id, count] : counts)
+            if (is_tickable_id(id))
+                tickable += count;
+        if (order.size() <= (size_t(1) << max_indirect_bits)) {
+            direct_counts.clear();
+            mode_ = mode_t::indirect;
+            bits = std::max<uint8_t>(min_indirect_bits, uint8_t(std::bit_width(order.size() - 1)));
+            palette = std::move(order);
+            palette_counts.resize(palette.size());
+            std::unordered_map<block_id_t, uint32_t> palette_index;
+            for (uint32_t i = 0; i < palette.size(); i++) {
+                palette_index[palette[i]] = i;
+                palette_counts[i] = counts[palette[i]];
+            }
+            palette_used = uint16_t(palette.size());
+            data.assign(words_for(bits), 0);
+            for (uint16_t i = 0; i < entries_count; i++)
+                set_packed(i, palette_index[values[i]]);
+        } else {
+            std::vector<block_id_t>().swap(palette);
+            std::vector<uint16_t>().swap(palette_counts);
+            palette_used = 0;
+            direct_counts = std::move(counts);
+            mode_ = mode_t::direct;
+            bits = direct_bits;
+            data.assign(words_for(bits), 0);
+            for (uint16_t i = 0; i < entries_count; i++)
+                set_packed(i, values[i]);
+        }
+    }
+
+    size_t block_storage::distinct_count() const {
+        switch (mode_) {
+        case mode_t::single:
+            return 1;
+        case mode_t::indirect:
+            return palette_used;
+        default:
+            return direct_counts.size();
+        }
+    }
+
+    uint16_t block_storage::tickable_count() const {
+        if (mode_ == mode_t::single)
+            return is_tickable_id(single_value) ? entries_count : 0;
+        return tickable;
+    }
+
+    size_t block_storage::memory_usage() const {
+        return sizeof(*this)
+               + data.capacity() * sizeof(uint64_t)
+               + palette.capacity() * sizeof(block_id_t)
+               + palette_counts.capacity() * sizeof(uint16_t)
+               + direct_counts.size() * (sizeof(block_id_t) + sizeof(uint16_t) + sizeof(void*) * 2);
+    }
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_BASE_OBJECTS_WORLD_BLOCK_STORAGE
+#define SRC_BASE_OBJECTS_WORLD_BLOCK_STORAGE
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <src/base_objects/block.hpp>
+
+namespace copper_server::base_objects::world {
+    //palette compressed storage for 16x16x16 block ids
+    //single   - whole section filled by one id, no data allocated
+    //indirect - palette with up to 256 entries, 4..8 bits per entry
+    //direct   - raw block ids, 15 bits per entry
+    //entries are not spanned between words, index is `x << 8 | y << 4 | z`
+    class block_storage {
+    public:
+        enum class mode_t : uint8_t {
+            single,
+            indirect,
+            direct
+        };
+
+        static constexpr uint16_t entries_count = 4096;
+        static constexpr uint8_t min_indirect_bits = 4;
+        static constexpr uint8_t max_indirect_bits = 8;
+        static constexpr uint8_t direct_bits = 15;
+
+        block_storage(block_id_t fill_with = 0);
+
+        static uint16_t index_of(uint8_t local_x, uint8_t local_y, uint8_t local_z) {
+            return uint16_t((local_x & 15) << 8) | uint16_t((local_y & 15) << 4) | uint16_t(local_z & 15);
+        }
+
+        block_id_t get(uint16_t index) const;
+        void set(uint16_t index, block_id_t id);
+
+        block_id_t get(uint8_t local_x, uint8_t local_y, uint8_t local_z) const {
+            return get(index_of(local_x, local_y, local_z));
+        }
+
+        void set(uint8_t local_x, uint8_t local_y, uint8_t local_z, block_id_t id) {
+            set(index_of(local_x, local_y, local_z), id);
+        }
+
+        void fill(block_id_t id);
+        //`values` must contain `entries_count` items in storage index order
+        void assign(const block_id_t* values);
+
+        mode_t mode() const {
+            return mode_;
+        }
+
+        uint8_t bits_per_entry() const {
+            return bits;
+        }
+
+        //count of distinct ids currently stored
+        size_t distinct_count() const;
+
+        //count of entries which blocks are tickable, random ticks skips storage with zero count
+        uint16_t tickable_count() const;
+
+        bool is_uniform() const {
+            return mode_ == mode_t::single;
+        }
+
+        block_id_t uniform_value() const {
+            return single_value;
+        }
+
+        size_t memory_usage() const;
+
+        //incremented by every call which changed stored ids, used to detect changes made through mutable access
+        uint64_t writes() const {
+            return writes_;
+        }
+
+        const std::vector<uint64_t>& raw_data() const {
+            return data;
+        }
+
+        const std::vector<block_id_t>& raw_palette() const {
+            return palette;
+        }
+
+        template <class FN>
+        void for_each(FN&& func) const {
+            if (mode_ == mode_t::single) {
+                for (uint16_t i = 0; i < entries_count; i++)
+                    func(i, single_value);
+                return;
+            }
+            uint8_t per_word = 64 / bits;
+            uint64_t mask = (uint64_t(1) << bits) - 1;
+            uint16_t i = 0;
+            for (uint64_t word : data) {
+                for (uint8_t j = 0; j < per_word && i < entries_count; j++, i++) {
+                    uint32_t value = uint32_t((word >> (j * bits)) & mask);
+                    func(i, mode_ == mode_t::indirect ? palette[value] : block_id_t(value));
+                }
+            }
+        }
+
+    private:
+        uint32_t get_packed(uint16_t index) const;
+        void set_packed(uint16_t index, uint32_t value);
+        void resize(uint8_t new_bits);
+        uint32_t palette_add(block_id_t id);
+        void palette_release(uint32_t palette_index);
+        void to_direct();
+        void compact();
+
+        std::vector<uint64_t> data;
+        std::vector<block_id_t> palette;         //indirect: palette index => id
+        std::vector<uint16_t> palette_counts;    //indirect: palette index => usage count, 0 == free slot
+        std::unordered_map<block_id_t, uint16_t> direct_counts; //direct: id => usage count
+        uint64_t writes_ = 0;
+        uint16_t palette_used = 0;
+        uint16_t tickable = 0; //indirect and direct: tickable entries, single mode resolves it from `single_value`
+        block_id_t single_value = 0;
+        uint8_t bits = 0;
+        mode_t mode_ = mode_t::single;
+    };
+}
+#endif /* SRC_BASE_OBJECTS_WORLD_BLOCK_STORAGE */
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <src/base_objects/world/chunk_bitmap.hpp>
+
+namespace copper_server::base_objects::world {
+    void chunk_bitmap::reset(const cubic_bounds_chunk_radius& region) {
+        region_ = region;
+        diameter = size_t(region.radius * 2 + 1);
+        words_per_row = (diameter + 63) / 64;
+        words.assign(diameter * words_per_row, 0);
+    }
+
+    void chunk_bitmap::clear_column(size_t column) {
+        uint64_t mask = ~(uint64_t(1) << (column & 63));
+        for (size_t row = 0; row < diameter; row++)
+            words[row * words_per_row + (column >> 6)] &= mask;
+    }
+
+    void chunk_bitmap::clear_row(size_t row) {
+        std::fill_n(words.begin() + row * words_per_row, words_per_row, 0);
+    }
+
+    void chunk_bitmap::move(const cubic_bounds_chunk_radius& region) {
+        if (region.radius != region_.radius || !diameter) {
+            chunk_bitmap res;
+            res.reset(region);
+            if (diameter) {
+                int64_t min_x = std::max(region.center_x - region.radius, region_.center_x - region_.radius);
+                int64_t max_x = std::min(region.center_x + region.radius, region_.center_x + region_.radius);
+                int64_t min_z = std::max(region.center_z - region.radius, region_.center_z - region_.radius);
+                int64_t max_z = std::min(region.center_z + region.radius, region_.center_z + region_.radius);
+                for (int64_t z = min_z; z <= max_z; z++)
+                    for (int64_t x = min_x; x <= max_x; x++)
+                        if (get(x, z))
+                            res.set(x, z, true);
+            }
+            *this = std::move(res);
+            return;
+        }
+        int64_t dx = region.center_x - region_.center_x;
+        int64_t dz = region.center_z - region_.center_z;
+        if (size_t(std::abs(dx)) >= diameter || size_t(std::abs(dz)) >= diameter) {
+            reset(region);
+            return;
+        }
+        //exposed columns use same cells as columns which left region
+        for (int64_t i = 0; i < std::abs(dx); i++)
+            clear_column(column_of(dx > 0 ? region_.center_x + region_.radius + 1 + i : region_.center_x - region_.radius - 1 - i));
+        for (int64_t i = 0; i < std::abs(dz); i++)
+            clear_row(row_of(dz > 0 ? region_.center_z + region_.radius + 1 + i : region_.center_z - region_.radius - 1 - i));
+        region_ = region;
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_BASE_OBJECTS_WORLD_CHUNK_BITMAP
+#define SRC_BASE_OBJECTS_WORLD_CHUNK_BITMAP
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include <src/base_objects/bounds.hpp>
+
+namespace copper_server::base_objects::world {
+    //one bit per chunk of square region, addressed by chunk coordinates modulo region diameter
+    //moving region keeps bits of chunks which stays in it and clears only rows and columns which became exposed
+    //bits are stored by rows of z, each row starts from new word
+    class chunk_bitmap {
+    public:
+        chunk_bitmap() = default;
+
+        const cubic_bounds_chunk_radius& region() const {
+            return region_;
+        }
+
+        //clears all bits
+        void reset(const cubic_bounds_chunk_radius& region);
+        //moves region, if radius changed bits are copied for chunks which stays in region
+        void move(const cubic_bounds_chunk_radius& region);
+
+        //coordinates must be in region
+        bool get(int64_t x, int64_t z) const {
+            size_t bit = column_of(x);
+            return (words[row_of(z) * words_per_row + (bit >> 6)] >> (bit & 63)) & 1;
+        }
+
+        //coordinates must be in region
+        void set(int64_t x, int64_t z, bool value) {
+            size_t bit = column_of(x);
+            uint64_t& word = words[row_of(z) * words_per_row + (bit >> 6)];
+            if (value)
+                word |= uint64_t(1) << (bit & 63);
+            else
+                word &= ~(uint64_t(1) << (bit & 63));
+        }
+
+        //calls `fn(x, z)` for each chunk in region which bit is not set, scans whole words
+        template <class FN>
+        void for_each_unset(FN&& fn) const {
+            if (!diameter)
+                return;
+            int64_t min_x = region_.center_x - region_.radius;
+            int64_t min_z = region_.center_z - region_.radius;
+            size_t first_column = column_of(min_x);
+            for (size_t dz = 0; dz < diameter; dz++) {
+                int64_t z = min_z + int64_t(dz);
+                const uint64_t* row = words.data() + row_of(z) * words_per_row;
+                for (size_t w = 0; w < words_per_row; w++) {
+                    uint64_t unset = ~row[w];
+                    if (w == words_per_row - 1 && diameter & 63)
+                        unset &= (uint64_t(1) << (diameter & 63)) - 1;
+                    while (unset) {
+                        size_t column = (w << 6) + std::countr_zero(unset);
+                        unset &= unset - 1;
+                        size_t offset = column >= first_column ? column - first_column : column + diameter - first_column;
+                        fn(min_x + int64_t(offset), z);
+                    }
+                }
+            }
+        }
+
+    private:
+        static size_t wrap(int64_t value, size_t size) {
+            int64_t res = value % int64_t(size);
+            return size_t(res < 0 ? res + int64_t(size) : res);
+        }
+
+        size_t column_of(int64_t x) const {
+            return wrap(x, diameter);
+        }
+
+        size_t row_of(int64_t z) const {
+            return wrap(z, diameter);
+        }
+
+        void clear_column(size_t column);
+        void clear_row(size_t row);
+
+        std::vector<uint64_t> words;
+        cubic_bounds_chunk_radius region_{0, 0, 0};
+        size_t diameter = 0;
+        size_t words_per_row = 0;
+    };
+}
+#endif /* SRC_BASE_OBJECTS_WORLD_CHUNK_BITMAP */
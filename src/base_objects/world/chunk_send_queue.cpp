@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <src/base_objects/world/chunk_send_queue.hpp>
+
+namespace copper_server::base_objects::world {
+    chunk_send_queue::chunk_send_queue(chunk_send_queue&& move) noexcept
+        : queue(std::move(move.queue)),
+          built_for(move.built_for),
+          center_x(move.center_x),
+          center_z(move.center_z),
+          view_x(move.view_x),
+          view_z(move.view_z),
+          batch_quota(move.batch_quota),
+          built(move.built),
+          chunks_per_tick(move.chunks_per_tick.load()),
+          unacknowledged(move.unacknowledged.load()),
+          max_unacknowledged(move.max_unacknowledged.load()) {}
+
+    chunk_send_queue& chunk_send_queue::operator=(chunk_send_queue&& move) noexcept {
+        queue = std::move(move.queue);
+        built_for = move.built_for;
+        center_x = move.center_x;
+        center_z = move.center_z;
+        view_x = move.view_x;
+        view_z = move.view_z;
+        batch_quota = move.batch_quota;
+        built = move.built;
+        chunks_per_tick = move.chunks_per_tick.load();
+        unacknowledged = move.unacknowledged.load();
+        max_unacknowledged = move.max_unacknowledged.load();
+        return *this;
+    }
+
+    int64_t chunk_send_queue::priority_of(int64_t x, int64_t z) const {
+        int64_t dx = x - center_x;
+        int64_t dz = z - center_z;
+        int64_t distance = dx * dx + dz * dz;
+        //chunks behind player are sent as if they were 1.5 times farther
+        bool behind = dx * view_x + dz * view_z < 0;
+        return behind ? distance * 3 : distance * 2;
+    }
+
+    void chunk_send_queue::rebuild(uint64_t revision, int64_t new_center_x, int64_t new_center_z, double yaw, std::vector<chunk_pos>&& pending) {
+        center_x = new_center_x;
+        center_z = new_center_z;
+        //yaw 0 looks to +z, 90 to -x
+        double rad = yaw * std::numbers::pi / 180.0;
+        view_x = -std::sin(rad);
+        view_z = std::cos(rad);
+        queue.clear();
+        queue.reserve(pending.size());
+        for (auto& pos : pending)
+            queue.push_back({pos, priority_of(pos.x, pos.z)});
+        std::stable_sort(queue.begin(), queue.end(), [](const entry& a, const entry& b) { return a.priority < b.priority; });
+        built_for = revision;
+        built = true;
+    }
+
+    size_t chunk_send_queue::begin_tick() {
+        if (unacknowledged.load() >= max_unacknowledged.load())
+            return 0;
+        batch_quota = std::min(batch_quota + chunks_per_tick.load(), max_chunks_per_tick);
+        return batch_quota >= 1 ? size_t(batch_quota) : 0;
+    }
+
+    void chunk_send_queue::batch_sent(size_t count) {
+        if (!count)
+            return;
+        batch_quota = std::max(batch_quota - float(count), 0.0f);
+        ++unacknowledged;
+    }
+
+    void chunk_send_queue::acknowledge(float requested) {
+        uint32_t current = unacknowledged.load();
+        while (current && !unacknowledged.compare_exchange_weak(current, current - 1))
+            ;
+        chunks_per_tick = std::isnan(requested) ? min_chunks_per_tick : std::clamp(requested, min_chunks_per_tick, max_chunks_per_tick);
+        max_unacknowledged = max_unacknowledged_batches;
+    }
+
+    void chunk_send_queue::clear() {
+        queue.clear();
+        built = false;
+        batch_quota = 0;
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_BASE_OBJECTS_WORLD_CHUNK_SEND_QUEUE
+#define SRC_BASE_OBJECTS_WORLD_CHUNK_SEND_QUEUE
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace copper_server::base_objects::world {
+    //per player order of chunks waiting to be sent, nearest chunks and chunks in view direction goes first
+    //chunks are sent in batches, amount of chunks per tick follows rate which client reports in batch acknowledgements
+    //queue is used only from owner tick, `acknowledge` could be called from any thread
+    class chunk_send_queue {
+    public:
+        struct chunk_pos {
+            int64_t x;
+            int64_t z;
+        };
+
+        enum class result : uint8_t {
+            sent,
+            not_ready, //kept in queue and checked again next tick
+            drop
+        };
+
+        static constexpr float initial_chunks_per_tick = 9;
+        static constexpr float min_chunks_per_tick = 0.01f;
+        static constexpr float max_chunks_per_tick = 64;
+        static constexpr uint32_t max_unacknowledged_batches = 10;
+        //not ready chunks checked per tick, so queue with unloaded chunks is not scanned entirely every tick
+        static constexpr size_t max_probes_per_tick = 64;
+
+        chunk_send_queue() = default;
+        chunk_send_queue(chunk_send_queue&& move) noexcept;
+        chunk_send_queue& operator=(chunk_send_queue&& move) noexcept;
+
+        //`revision` is processing region revision which queue built for
+        bool outdated(uint64_t revision) const {
+            return !built || built_for != revision;
+        }
+
+        //replaces queue content
+        void rebuild(uint64_t revision, int64_t new_center_x, int64_t new_center_z, double yaw, std::vector<chunk_pos>&& pending);
+
+        //returns how many chunks could be sent in this tick, zero while client did not acknowledge previous batches
+        size_t begin_tick();
+
+        //takes chunks from queue front until `limit` sent, `try_send(x, z)` returns `result`
+        template <class FN>
+        size_t take(size_t limit, FN&& try_send) {
+            size_t sent = 0;
+            size_t probes = 0;
+            size_t kept = 0;
+            size_t i = 0;
+            for (; i < queue.size() && sent < limit && probes < max_probes_per_tick; i++) {
+                switch (try_send(queue[i].pos.x, queue[i].pos.z)) {
+                case result::sent:
+                    ++sent;
+                    break;
+                case result::not_ready:
+                    ++probes;
+                    queue[kept++] = queue[i];
+                    break;
+                case result::drop:
+                    break;
+                }
+            }
+            if (kept != i)
+                queue.erase(queue.begin() + kept, queue.begin() + i);
+            return sent;
+        }
+
+        //records batch with `count` chunks which was sent after `begin_tick`
+        void batch_sent(size_t count);
+        //called on chunk batch received, `requested` is chunks per tick rate which client asks for
+        void acknowledge(float requested);
+
+        size_t size() const {
+            return queue.size();
+        }
+
+        bool empty() const {
+            return queue.empty();
+        }
+
+        void clear();
+
+    private:
+        struct entry {
+            chunk_pos pos;
+            int64_t priority;
+        };
+
+        int64_t priority_of(int64_t x, int64_t z) const;
+
+        std::vector<entry> queue; //sorted by priority
+        uint64_t built_for = 0;
+        int64_t center_x = 0;
+        int64_t center_z = 0;
+        double view_x = 0;
+        double view_z = 1;
+        float batch_quota = 0;
+        bool built = false;
+
+        std::atomic<float> chunks_per_tick = initial_chunks_per_tick;
+        std::atomic<uint32_t> unacknowledged = 0;
+        std::atomic<uint32_t> max_unacknowledged = 1; //raised after first acknowledgement, client rate is unknown before it
+    };
+}
+#endif /* SRC_BASE_OBJECTS_WORLD_CHUNK_SEND_QUEUE */
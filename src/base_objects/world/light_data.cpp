@@ -0,0 +1,84 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <cstring>
+#include <src/base_objects/world/light_data.hpp>
+
+namespace copper_server::base_objects::world {
+    light_data::light_data(uint8_t uniform_value)
+        : uniform(uniform_value & 0xF) {}
+
+    light_data::light_data(const light_data& copy)
+        : data(copy.data ? std::make_unique<packed_t>(*copy.data) : nullptr), writes_(copy.writes_), uniform(copy.uniform) {}
+
+    light_data& light_data::operator=(const light_data& copy) {
+        if (this != &copy) {
+            data = copy.data ? std::make_unique<packed_t>(*copy.data) : nullptr;
+            writes_ = copy.writes_;
+            uniform = copy.uniform;
+        }
+        return *this;
+    }
+
+    void light_data::set(uint8_t local_x, uint8_t local_y, uint8_t local_z, uint8_t value) {
+        value &= 0xF;
+        if (!data) {
+            if (value == uniform)
+                return;
+            data = std::make_unique<packed_t>();
+            data->fill(uint8_t(uniform | (uniform << 4)));
+        }
+        auto index = index_of(local_x, local_y, local_z);
+        auto& byte = (*data)[index >> 1];
+        auto old = byte;
+        if (index & 1)
+            byte = uint8_t((byte & 0x0F) | (value << 4));
+        else
+            byte = uint8_t((byte & 0xF0) | value);
+        writes_ += byte != old;
+    }
+
+    void light_data::fill(uint8_t value) {
+        if (!data && uniform == (value & 0xF))
+            return;
+        ++writes_;
+        data = nullptr;
+        uniform = value & 0xF;
+    }
+
+    static bool uniform_packed(const uint8_t* packed) {
+        uint8_t first = packed[0];
+        return (first & 0xF) == (first >> 4) && std::all_of(packed, packed + light_data::data_size, [first](uint8_t it) { return it == first; });
+    }
+
+    void light_data::assign(const uint8_t* packed) {
+        if (uniform_packed(packed)) {
+            fill(packed[0] & 0xF);
+            return;
+        }
+        ++writes_;
+        if (!data)
+            data = std::make_unique<packed_t>();
+        std::memcpy(data->data(), packed, data_size);
+    }
+
+    void light_data::compact() {
+        if (data && uniform_packed(data->data())) {
+            uniform = (*data)[0] & 0xF;
+            data = nullptr;
+        }
+    }
+
+    void light_data::copy_to(uint8_t* out) const {
+        if (data)
+            std::memcpy(out, data->data(), data_size);
+        else
+            std::memset(out, uniform | (uniform << 4), data_size);
+    }
+}
@@ -8,17 +8,66 @@
  */
 #ifndef SRC_BASE_OBJECTS_WORLD_LIGHT_DATA
 #define SRC_BASE_OBJECTS_WORLD_LIGHT_DATA
+#include <array>
 #include <cstdint>
+#include <memory>
+
 namespace copper_server::base_objects::world {
+    //4 bits per block, nibble index is `x << 8 | y << 4 | z`, low nibble first
+    //this is same layout as network light arrays, so data can be sent as is
+    //array allocated only when light is not uniform
     struct light_data {
-        union light_item {
-            uint8_t light_point;
-        };
+        static constexpr size_t data_size = 2048;
+        using packed_t = std::array<uint8_t, data_size>;
+
+        light_data(uint8_t uniform_value = 0);
+        light_data(const light_data& copy);
+        light_data(light_data&& move) noexcept = default;
+        light_data& operator=(const light_data& copy);
+        light_data& operator=(light_data&& move) noexcept = default;
+
+        static uint16_t index_of(uint8_t local_x, uint8_t local_y, uint8_t local_z) {
+            return uint16_t((local_x & 15) << 8) | uint16_t((local_y & 15) << 4) | uint16_t(local_z & 15);
+        }
+
+        uint8_t get(uint8_t local_x, uint8_t local_y, uint8_t local_z) const {
+            if (!data)
+                return uniform;
+            auto index = index_of(local_x, local_y, local_z);
+            return ((*data)[index >> 1] >> ((index & 1) << 2)) & 0xF;
+        }
+
+        void set(uint8_t local_x, uint8_t local_y, uint8_t local_z, uint8_t value);
+        void fill(uint8_t value);
+        //`packed` must contain `data_size` bytes
+        void assign(const uint8_t* packed);
+        //frees array if all values are same
+        void compact();
+        //writes `data_size` bytes
+        void copy_to(uint8_t* out) const;
+
+        bool is_uniform() const {
+            return !data;
+        }
+
+        uint8_t uniform_value() const {
+            return uniform;
+        }
+
+        //nullptr if uniform
+        const packed_t* packed() const {
+            return data.get();
+        }
 
-        light_item light_map[16][16][16];
+        //incremented by every call which changed stored values, `compact` keeps it
+        uint64_t writes() const {
+            return writes_;
+        }
 
-        light_data()
-            : light_map() {}
+    private:
+        std::unique_ptr<packed_t> data;
+        uint64_t writes_ = 0;
+        uint8_t uniform;
     };
 }
 #endif /* SRC_BASE_OBJECTS_WORLD_LIGHT_DATA */
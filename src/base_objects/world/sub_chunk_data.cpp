@@ -6,13 +6,33 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
+#include <atomic>
+#include <cstring>
+#include <library/fast_task.hpp>
 #include <src/base_objects/entity.hpp>
 #include <src/base_objects/world/sub_chunk_data.hpp>
 
 namespace copper_server::base_objects::world {
+    //uniform key => immutable section shared between chunks
+    static fast_task::protected_value<std::unordered_map<uint64_t, std::shared_ptr<sub_chunk_data>>> interned_sections;
 
+    static std::shared_ptr<sub_chunk_data> intern_section(uint64_t key, const sub_chunk_data& section) {
+        return interned_sections.set([&](auto& map) {
+            auto& it = map[key];
+            if (!it)
+                it = std::make_shared<sub_chunk_data>(section);
+            return it;
+        });
+    }
+
+    static std::atomic_uint64_t revision_counter = 0;
 
-    sub_chunk_data::sub_chunk_data() {
+    static uint64_t next_revision() {
+        return revision_counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    sub_chunk_data::sub_chunk_data()
+        : biomes() {
     }
 
     sub_chunk_data::~sub_chunk_data() {
@@ -22,12 +42,19 @@ namespace copper_server::base_objects::world {
         return block_entities[local_z | (local_y << 4) | (local_x << 8)];
     }
 
+    base_objects::block sub_chunk_data::get_block(uint8_t local_x, uint8_t local_y, uint8_t local_z) const {
+        return base_objects::block(blocks.get(local_x, local_y, local_z));
+    }
+
     void sub_chunk_data::get_block(uint8_t local_x, uint8_t local_y, uint8_t local_z, std::function<void(base_objects::block& block)> on_normal, std::function<void(base_objects::block& block, enbt::value& entity_data)> on_entity) {
-        auto& block = blocks[local_x][local_y][local_z];
+        auto id = blocks.get(local_x, local_y, local_z);
+        base_objects::block block(id);
         if (block.is_block_entity())
             on_entity(block, get_block_entity_data(local_x, local_y, local_z));
         else
             on_normal(block);
+        if (block.id != id)
+            blocks.set(local_x, local_y, local_z, block.id);
     }
 
     void sub_chunk_data::set_block(uint8_t local_x, uint8_t local_y, uint8_t local_z, const base_objects::full_block_data& block) {
@@ -35,10 +62,10 @@ namespace copper_server::base_objects::world {
             [&](auto& block) {
                 using T = std::decay_t<decltype(block)>;
                 if constexpr (std::is_same_v<T, base_objects::block>) {
-                    blocks[local_x][local_y][local_z] = block;
+                    blocks.set(local_x, local_y, local_z, block.id);
                     block_entities.erase(local_z | (local_y << 4) | (local_x << 8));
                 } else {
-                    blocks[local_x][local_y][local_z] = block.block;
+                    blocks.set(local_x, local_y, local_z, block.block.id);
                     get_block_entity_data(local_x, local_y, local_z) = block.data;
                 }
             },
@@ -51,10 +78,10 @@ namespace copper_server::base_objects::world {
             [&](auto& block) {
                 using T = std::decay_t<decltype(block)>;
                 if constexpr (std::is_same_v<T, base_objects::block>) {
-                    blocks[local_x][local_y][local_z] = block;
+                    blocks.set(local_x, local_y, local_z, block.id);
                     block_entities.erase(local_z | (local_y << 4) | (local_x << 8));
                 } else {
-                    blocks[local_x][local_y][local_z] = block.block;
+                    blocks.set(local_x, local_y, local_z, block.block.id);
                     get_block_entity_data(local_x, local_y, local_z) = std::move(block.data);
                 }
             },
@@ -62,7 +89,7 @@ namespace copper_server::base_objects::world {
         );
     }
 
-    int32_t sub_chunk_data::get_biome(uint8_t local_x, uint8_t local_y, uint8_t local_z) {
+    int32_t sub_chunk_data::get_biome(uint8_t local_x, uint8_t local_y, uint8_t local_z) const {
         return biomes[2 >> local_x][2 >> local_y][2 >> local_z];
     }
 
@@ -71,10 +98,9 @@ namespace copper_server::base_objects::world {
     }
 
     void sub_chunk_data::for_each_block(std::function<void(uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::block block)> func) const {
-        for (uint8_t x = 0; x < 16; x++)
-            for (uint8_t y = 0; y < 16; y++)
-                for (uint8_t z = 0; z < 16; z++)
-                    func(x, y, z, blocks[x][y][z]);
+        blocks.for_each([&](uint16_t index, base_objects::block_id_t id) {
+            func(uint8_t(index >> 8), uint8_t((index >> 4) & 0xF), uint8_t(index & 0xF), base_objects::block(id));
+        });
     }
 
     void sub_chunk_data::for_each_block_entity(std::function<void(uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::block block, const enbt::value& entity_data)> func) const {
@@ -82,15 +108,20 @@ namespace copper_server::base_objects::world {
             auto local_z = uint8_t(pos & 0xF);
             auto local_y = uint8_t((pos >> 4) & 0xF);
             auto local_x = uint8_t((pos >> 8) & 0xF);
-            func(local_x, local_y, local_z, blocks[local_x][local_y][local_z], data);
+            func(local_x, local_y, local_z, get_block(local_x, local_y, local_z), data);
         }
     }
 
     void sub_chunk_data::for_each_block(std::function<void(uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::block& block)> func) {
         for (uint8_t x = 0; x < 16; x++)
             for (uint8_t y = 0; y < 16; y++)
-                for (uint8_t z = 0; z < 16; z++)
-                    func(x, y, z, blocks[x][y][z]);
+                for (uint8_t z = 0; z < 16; z++) {
+                    auto id = blocks.get(x, y, z);
+                    base_objects::block block(id);
+                    func(x, y, z, block);
+                    if (block.id != id)
+                        blocks.set(x, y, z, block.id);
+                }
     }
 
     void sub_chunk_data::for_each_block_entity(std::function<void(uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::block& block, enbt::value& entity_data)> func) {
@@ -98,7 +129,148 @@ namespace copper_server::base_objects::world {
             auto local_z = uint8_t(pos & 0xF);
             auto local_y = uint8_t((pos >> 4) & 0xF);
             auto local_x = uint8_t((pos >> 8) & 0xF);
-            func(local_x, local_y, local_z, blocks[local_x][local_y][local_z], data);
+            auto id = blocks.get(local_x, local_y, local_z);
+            base_objects::block block(id);
+            func(local_x, local_y, local_z, block, data);
+            if (block.id != id)
+                blocks.set(local_x, local_y, local_z, block.id);
         }
     }
-}
\ No newline at end of file
+
+    std::optional<uint64_t> sub_chunk_data::uniform_key() const {
+        if (!blocks.is_uniform() || !sky_light.is_uniform() || !block_light.is_uniform())
+            return std::nullopt;
+        if (!block_entities.empty() || !stored_entities.empty())
+            return std::nullopt;
+        int32_t biome = biomes[0][0][0];
+        for (auto& x : biomes)
+            for (auto& y : x)
+                for (auto z : y)
+                    if (z != biome)
+                        return std::nullopt;
+        //tickable blocks count follows from block id, so it is not part of the key
+        uint64_t flags = (uint64_t(need_to_recalculate_light) << 1)
+                         | (uint64_t(sky_lighted) << 2)
+                         | (uint64_t(block_lighted) << 3);
+        return uint64_t(uint32_t(biome))
+               | (uint64_t(blocks.uniform_value()) << 32)
+               | (uint64_t(sky_light.uniform_value()) << 48)
+               | (uint64_t(block_light.uniform_value()) << 52)
+               | (flags << 56);
+    }
+
+    sub_chunk_handle::sub_chunk_handle()
+        : changed_at(next_revision()), shared(true) {
+        static const std::shared_ptr<sub_chunk_data> empty = [] {
+            sub_chunk_data section;
+            return intern_section(*section.uniform_key(), section);
+        }();
+        data = empty;
+    }
+
+    sub_chunk_handle::sub_chunk_handle(sub_chunk_data&& section)
+        : data(std::make_shared<sub_chunk_data>(std::move(section))), changed_at(next_revision()), shared(false) {}
+
+    sub_chunk_data& sub_chunk_handle::edit() {
+        changed_at = next_revision();
+        if (shared) {
+            data = std::make_shared<sub_chunk_data>(*data);
+            shared = false;
+        }
+        return *data;
+    }
+
+    void sub_chunk_handle::get_block(uint8_t local_x, uint8_t local_y, uint8_t local_z, std::function<void(base_objects::block& block)> on_normal, std::function<void(base_objects::block& block, enbt::value& entity_data)> on_entity) {
+        auto block = data->get_block(local_x, local_y, local_z);
+        if (block.is_block_entity()) {
+            edit().get_block(local_x, local_y, local_z, on_normal, on_entity);
+            return;
+        }
+        auto id = block.id;
+        on_normal(block);
+        if (block.id != id)
+            edit().blocks.set(local_x, local_y, local_z, block.id);
+    }
+
+    //blocks and light counts their writes, rest is small enough to compare by value
+    struct section_stamp {
+        uint64_t blocks;
+        uint64_t sky_light;
+        uint64_t block_light;
+        size_t block_entities;
+        size_t stored_entities;
+        int32_t biomes[4][4][4];
+        bool need_to_recalculate_light;
+        bool sky_lighted;
+        bool block_lighted;
+
+        section_stamp(const sub_chunk_data& section)
+            : blocks(section.blocks.writes()),
+              sky_light(section.sky_light.writes()),
+              block_light(section.block_light.writes()),
+              block_entities(section.block_entities.size()),
+              stored_entities(section.stored_entities.size()),
+              need_to_recalculate_light(section.need_to_recalculate_light),
+              sky_lighted(section.sky_lighted),
+              block_lighted(section.block_lighted) {
+            std::memcpy(biomes, section.biomes, sizeof(biomes));
+        }
+
+        bool operator==(const section_stamp& other) const = default;
+    };
+
+    void sub_chunk_handle::update(const std::function<void(sub_chunk_data& section)>& func) {
+        if (!shared) {
+            section_stamp before(*data);
+            func(*data);
+            if (!(section_stamp(*data) == before))
+                changed_at = next_revision();
+            return;
+        }
+        //shared section is uniform, so its copy does not allocate
+        //copy is installed as private section while `func` runs, so `edit` called from `func` writes to same instance
+        auto original = data;
+        auto key = original->uniform_key();
+        auto working = std::make_shared<sub_chunk_data>(*original);
+        data = working;
+        shared = false;
+        try {
+            func(*working);
+        } catch (...) {
+            if (data == working && !shared)
+                changed_at = next_revision();
+            throw;
+        }
+        //section replaced by `func`, handle already in its final state
+        if (data != working || shared)
+            return;
+        auto new_key = working->uniform_key();
+        if (new_key == key) {
+            data = std::move(original);
+            shared = true;
+            return;
+        }
+        changed_at = next_revision();
+        if (new_key) {
+            data = intern_section(*new_key, *working);
+            shared = true;
+        }
+    }
+
+    bool sub_chunk_handle::try_share() {
+        if (shared)
+            return true;
+        if (auto key = data->uniform_key(); key) {
+            data = intern_section(*key, *data);
+            shared = true;
+            return true;
+        }
+        return false;
+    }
+
+    size_t sub_chunk_handle::interned_count() {
+        return interned_sections.get([](auto& map) {
+            return map.size();
+        });
+    }
+}
@@ -10,6 +10,8 @@
 #define SRC_BASE_OBJECTS_WORLD_SUB_CHUNK_DATA
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <unordered_map>
 
 #include <library/enbt/enbt.hpp>
@@ -17,6 +19,7 @@
 
 #include <src/base_objects/atomic_holder.hpp>
 #include <src/base_objects/block.hpp>
+#include <src/base_objects/world/block_storage.hpp>
 #include <src/base_objects/world/light_data.hpp>
 
 namespace copper_server::base_objects {
@@ -25,7 +28,7 @@ namespace copper_server::base_objects {
 
     namespace world {
         struct sub_chunk_data {
-            base_objects::block blocks[16][16][16];
+            block_storage blocks;
             int32_t biomes[4][4][4];
             std::unordered_map<uint16_t, enbt::value> block_entities;               //0xXYZ => block_entity
             std::unordered_map<uint64_t, base_objects::entity_ref> stored_entities; //uses id from world
@@ -33,25 +36,91 @@ namespace copper_server::base_objects {
 
             base_objects::world::light_data sky_light;
             base_objects::world::light_data block_light;
-            bool has_tickable_blocks = false;
             bool need_to_recalculate_light = false;
             bool sky_lighted = false;   //set true if at least one block is lighted in this sub_chunk
             bool block_lighted = false; //set true if at least one block is lighted in this sub_chunk
 
             sub_chunk_data();
+            sub_chunk_data(const sub_chunk_data&) = default;
+            sub_chunk_data(sub_chunk_data&&) noexcept = default;
+            sub_chunk_data& operator=(const sub_chunk_data&) = default;
+            sub_chunk_data& operator=(sub_chunk_data&&) noexcept = default;
             ~sub_chunk_data();
 
             enbt::value& get_block_entity_data(uint8_t local_x, uint8_t local_y, uint8_t local_z);
+            base_objects::block get_block(uint8_t local_x, uint8_t local_y, uint8_t local_z) const;
+            //changes made by callbacks to `block` are written back to storage
             void get_block(uint8_t local_x, uint8_t local_y, uint8_t local_z, std::function<void(base_objects::block& block)> on_normal, std::function<void(base_objects::block& block, enbt::value& entity_data)> on_entity);
             void set_block(uint8_t local_x, uint8_t local_y, uint8_t local_z, const base_objects::full_block_data& block);
             void set_block(uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::full_block_data&& block);
-            int32_t get_biome(uint8_t local_x, uint8_t local_y, uint8_t local_z);
+            int32_t get_biome(uint8_t local_x, uint8_t local_y, uint8_t local_z) const;
             void set_biome(uint8_t local_x, uint8_t local_y, uint8_t local_z, int32_t id);
+            //changes made by callbacks to `block` are written back to storage
             void for_each_block(std::function<void(uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::block& block)> func);
             void for_each_block_entity(std::function<void(uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::block& block, enbt::value& entity_data)> func);
 
             void for_each_block(std::function<void(uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::block block)> func) const;
             void for_each_block_entity(std::function<void(uint8_t local_x, uint8_t local_y, uint8_t local_z, base_objects::block block, const enbt::value& entity_data)> func) const;
+
+            //returns key if section is filled by one block, one biome, uniform light and has no entities
+            std::optional<uint64_t> uniform_key() const;
+        };
+
+        //copy-on-write handle for sub_chunk_data
+        //uniform sections are shared between all chunks and copied to private instance on first modification
+        class sub_chunk_handle {
+            std::shared_ptr<sub_chunk_data> data;
+            uint64_t changed_at;
+            bool shared;
+
+        public:
+            //shared empty section
+            sub_chunk_handle();
+            sub_chunk_handle(sub_chunk_data&& section);
+            sub_chunk_handle(const sub_chunk_handle&) = delete;
+            sub_chunk_handle(sub_chunk_handle&&) noexcept = default;
+            sub_chunk_handle& operator=(const sub_chunk_handle&) = delete;
+            sub_chunk_handle& operator=(sub_chunk_handle&&) noexcept = default;
+
+            const sub_chunk_data& get() const {
+                return *data;
+            }
+
+            const sub_chunk_data* operator->() const {
+                return data.get();
+            }
+
+            const sub_chunk_data& operator*() const {
+                return *data;
+            }
+
+            //materializes shared section, caller must write to it, reads should use const access
+            sub_chunk_data& edit();
+
+            //same as sub_chunk_data::get_block, but section copied and revision moved only when callback changes the block
+            //block entity data could be changed in place, so block entities always treated as changed
+            void get_block(uint8_t local_x, uint8_t local_y, uint8_t local_z, std::function<void(base_objects::block& block)> on_normal, std::function<void(base_objects::block& block, enbt::value& entity_data)> on_entity);
+
+            //for code which usually leaves section untouched, like block ticks
+            //revision moved only when blocks, light, biomes, flags or entity lists changed, shared section copied only when it changed
+            //in place changes of block entity data are not detected, such callers must use `edit`
+            //`edit` called from `func` returns same instance as `func` got, so nested writes are kept
+            void update(const std::function<void(sub_chunk_data& section)>& func);
+
+            bool is_shared() const {
+                return shared;
+            }
+
+            //value from process wide counter taken on creation and on every change of section content
+            //newer handle or later change always has greater value, so it could be used to invalidate caches of section content
+            uint64_t revision() const {
+                return changed_at;
+            }
+
+            //replaces private section with interned one if section is uniform
+            bool try_share();
+
+            static size_t interned_count();
         };
     }
 }
@@ -225,6 +225,20 @@ namespace copper_server::build_in_plugins {
                     };
                 }
             };
+            proc.entity_move_rotate = [](base_objects::entity& self, base_objects::entity& target, util::VECTOR dif, util::ANGLE_DEG rot) {
+                if (self.assigned_player) {
+                    auto delta = util::minecraft::packets::delta_move({(float)dif.x, (float)dif.y, (float)dif.z});
+                    *self.assigned_player << api::client::play::move_entity_pos_rot{
+                        .entity_id = target.protocol_id,
+                        .delta_x = delta.x,
+                        .delta_y = delta.y,
+                        .delta_z = delta.z,
+                        .yaw = rot.x,
+                        .pitch = rot.y,
+                        .on_ground = target.is_on_ground()
+                    };
+                }
+            };
             proc.entity_place_block = [](base_objects::entity& self, base_objects::entity& target, bool is_main_hand, [[maybe_unused]] int64_t x, [[maybe_unused]] int64_t y, [[maybe_unused]] int64_t z, [[maybe_unused]] const base_objects::block& block) {
                 if (self.assigned_player)
                     *self.assigned_player << api::client::play::animate{
@@ -468,23 +482,16 @@ namespace copper_server::build_in_plugins {
                     }
                 }
             };
+            //chunks which was not sent yet are left for send queue in `on_tick`, only sent chunks are resent here
             proc.notify_chunk = [](base_objects::entity& self, int64_t x, int64_t z, const storage::chunk_data& chunk) {
-                if (self.assigned_player) {
-                    if (self.get_syncing_data().chunk_in_bounds(x, z)) {
-                        //TODO implement batching
-                        *self.assigned_player << api::client::play::level_chunk_with_light::create(chunk, *self.current_world());
-                        self.get_syncing_data().mark_chunk(x, z, true);
-                    }
-                }
+                if (self.assigned_player)
+                    if (self.get_syncing_data().chunk_processed(x, z))
+                        api::packets::send_chunk(*self.assigned_player, chunk, *self.current_world());
             };
             proc.notify_chunk_blocks = [](base_objects::entity& self, int64_t x, int64_t z, const storage::chunk_data& chunk) {
-                if (self.assigned_player) {
-                    if (self.get_syncing_data().chunk_in_bounds(x, z)) {
-                        //TODO implement batching
-                        *self.assigned_player << api::client::play::level_chunk_with_light::create(chunk, *self.current_world());
-                        self.get_syncing_data().mark_chunk(x, z, true);
-                    }
-                }
+                if (self.assigned_player)
+                    if (self.get_syncing_data().chunk_processed(x, z))
+                        api::packets::send_chunk(*self.assigned_player, chunk, *self.current_world());
             };
             proc.notify_chunk_light = [](base_objects::entity& self, int64_t x, int64_t z, const storage::chunk_data& chunk) {
                 if (self.assigned_player)
@@ -493,28 +500,50 @@ namespace copper_server::build_in_plugins {
             };
             proc.notify_sub_chunk = [](base_objects::entity& self, int64_t x, [[maybe_unused]] int64_t y, int64_t z, [[maybe_unused]] const base_objects::world::sub_chunk_data& chunk) {
                 if (self.assigned_player) {
-                    if (self.get_syncing_data().chunk_in_bounds(x, z)) {
+                    if (self.get_syncing_data().chunk_processed(x, z)) {
                         if (self.current_world()) {
                             self.current_world()->get_chunk_at(x, z, [&](auto& chunk) {
-                                //TODO implement batching
-                                *self.assigned_player << api::client::play::level_chunk_with_light::create(chunk, *self.current_world());
-                                self.get_syncing_data().mark_chunk(x, z, true);
+                                api::packets::send_chunk(*self.assigned_player, chunk, *self.current_world());
                             });
                         }
                     }
                 }
             };
-            proc.notify_sub_chunk_blocks = [](base_objects::entity& self, int64_t x, [[maybe_unused]] int64_t y, int64_t z, [[maybe_unused]] const base_objects::world::sub_chunk_data& chunk) { //TODO use api::client::play::section_blocks_update
-                if (self.assigned_player) {
-                    if (self.get_syncing_data().chunk_in_bounds(x, z)) {
-                        if (self.current_world()) {
-                            self.current_world()->get_chunk_at(x, z, [&](auto& chunk) {
-                                //TODO implement batching
-                                *self.assigned_player << api::client::play::level_chunk_with_light::create(chunk, *self.current_world());
-                                self.get_syncing_data().mark_chunk(x, z, true);
-                            });
-                        }
-                    }
+            proc.notify_sub_chunk_blocks = [](base_objects::entity& self, int64_t x, int64_t y, int64_t z, const base_objects::world::sub_chunk_data& chunk, const std::vector<uint16_t>& positions) {
+                if (!self.assigned_player || !self.get_syncing_data().chunk_processed(x, z))
+                    return;
+                auto location = [&](uint16_t pos) -> base_objects::position {
+                    return {.x = int32_t(x * 16 + (pos >> 8)), .z = int32_t(z * 16 + (pos & 15)), .y = int32_t(y * 16 + ((pos >> 4) & 15))};
+                };
+                if (positions.size() == 1)
+                    *self.assigned_player << api::client::play::block_update{
+                        .location = location(positions.front()),
+                        .block = chunk.get_block(positions.front() >> 8, (positions.front() >> 4) & 15, positions.front() & 15).id
+                    };
+                else {
+                    api::client::play::section_blocks_update update;
+                    update.position = {.x = uint64_t(x), .z = uint64_t(z), .y = uint64_t(y)};
+                    update.block.reserve(positions.size());
+                    for (auto pos : positions)
+                        update.block.push_back({
+                            .block_state = uint32_t(chunk.get_block(pos >> 8, (pos >> 4) & 15, pos & 15).id),
+                            .local_x = uint32_t(pos >> 8),
+                            .local_z = uint32_t(pos & 15),
+                            .local_y = uint32_t((pos >> 4) & 15),
+                        });
+                    *self.assigned_player << std::move(update);
+                }
+                //block states does not carry block entity data
+                for (auto pos : positions) {
+                    auto block_entity = chunk.block_entities.find(pos);
+                    if (block_entity == chunk.block_entities.end())
+                        continue;
+                    auto block = chunk.get_block(pos >> 8, (pos >> 4) & 15, pos & 15);
+                    *self.assigned_player << api::client::play::block_entity_data{
+                        .location = location(pos),
+                        .type = block.block_entity_id(),
+                        .data = block_entity->second
+                    };
                 }
             };
             proc.notify_sub_chunk_light = [](base_objects::entity& self, int64_t x, [[maybe_unused]] int64_t y, int64_t z, [[maybe_unused]] const base_objects::world::sub_chunk_data& chunk) {
@@ -551,21 +580,43 @@ namespace copper_server::build_in_plugins {
             };
 
             proc.on_tick = [](base_objects::entity& self) {
-                if (self.assigned_player) {
-                    if (self.current_world()) {
-                        //TODO implement batching
-                        self.get_syncing_data().for_each_processing([&](int64_t chunk_x, int64_t chunk_z, bool loaded) {
-                            if (!loaded) {
-                                auto chunk = self.current_world()->request_chunk_data_weak(chunk_x, chunk_z);
-                                if (chunk) {
-                                    if ((*chunk)->generator_stage == 0xFF) {
-                                        *self.assigned_player << api::client::play::level_chunk_with_light::create(**chunk, *self.current_world());
-                                        self.get_syncing_data().mark_chunk(chunk_x, chunk_z, true);
-                                    }
-                                }
-                            }
-                        });
+                if (!self.assigned_player || !self.current_world())
+                    return;
+                using chunk_send_queue = base_objects::world::chunk_send_queue;
+                auto& syncing = self.get_syncing_data();
+                auto& queue = syncing.chunk_sending;
+                //processing area is scanned only when it changes, queue keeps every chunk which is not sent yet
+                if (queue.outdated(syncing.processing_revision)) {
+                    std::vector<chunk_send_queue::chunk_pos> pending;
+                    syncing.for_each_not_processed([&](int64_t chunk_x, int64_t chunk_z) {
+                        pending.push_back({chunk_x, chunk_z});
+                    });
+                    queue.rebuild(syncing.processing_revision, syncing.processing_region.center_x, syncing.processing_region.center_z, self.rotation.x, std::move(pending));
+                }
+                if (queue.empty())
+                    return;
+                size_t limit = queue.begin_tick();
+                if (!limit)
+                    return;
+                auto& world = *self.current_world();
+                bool batch_started = false;
+                size_t sent = queue.take(limit, [&](int64_t chunk_x, int64_t chunk_z) {
+                    if (syncing.chunk_processed(chunk_x, chunk_z) || !syncing.chunk_in_bounds(chunk_x, chunk_z))
+                        return chunk_send_queue::result::drop;
+                    auto chunk = world.request_chunk_data_weak(chunk_x, chunk_z);
+                    if (!chunk || (*chunk)->generator_stage != 0xFF)
+                        return chunk_send_queue::result::not_ready;
+                    if (!batch_started) {
+                        *self.assigned_player << api::client::play::chunk_batch_start{};
+                        batch_started = true;
                     }
+                    api::packets::send_chunk(*self.assigned_player, **chunk, world);
+                    syncing.mark_chunk(chunk_x, chunk_z, true);
+                    return chunk_send_queue::result::sent;
+                });
+                if (sent) {
+                    *self.assigned_player << api::client::play::chunk_batch_finished{.batch_size = (int32_t)sent};
+                    queue.batch_sent(sent);
                 }
             };
             return std::make_shared<base_objects::entity_data::world_processor>(std::move(proc));
@@ -13,6 +13,7 @@
 #include <src/api/entity_id_map.hpp>
 #include <src/api/internal/world.hpp>
 #include <src/api/players.hpp>
+#include <src/api/server.hpp>
 #include <src/api/world.hpp>
 #include <src/base_objects/commands.hpp>
 #include <src/base_objects/entity.hpp>
@@ -251,6 +252,7 @@ namespace copper_server::build_in_plugins {
                     } catch (...) {
                         log::error("World", "Error ticking world. Undefined exception.");
                     }
+                    api::server::tick_end_event();
                     tick_next_awoke = std::chrono::high_resolution_clock::now();
                     auto to_tick = tick_next_awoke - current_time;
                     const auto tick_time = second / worlds_storage.ticks_per_second;
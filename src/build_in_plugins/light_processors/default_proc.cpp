@@ -14,12 +14,8 @@ namespace copper_server::build_in_plugins::light_processors {
         void process_chunk(storage::world_data& world, int64_t chunk_x, int64_t chunk_z) override {
             world.get_chunk(chunk_x, chunk_z, [&](storage::chunk_data& chunk) {
                 chunk.for_each_sub_chunk([&](base_objects::world::sub_chunk_data& sub_chunk) {
-                    for (int_fast8_t i = 0; i < 16; ++i)
-                        for (int_fast8_t j = 0; j < 16; ++j)
-                            for (int_fast8_t k = 0; k < 16; ++k) {
-                                sub_chunk.sky_light.light_map[i][j][k].light_point = 15;
-                                sub_chunk.block_light.light_map[i][j][k].light_point = 15;
-                            }
+                    sub_chunk.sky_light.fill(15);
+                    sub_chunk.block_light.fill(15);
                 });
             });
             world.notify_chunk_light(chunk_x, chunk_z);
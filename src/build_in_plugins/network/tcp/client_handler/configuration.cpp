@@ -516,6 +516,7 @@ namespace copper_server::build_in_plugins::network::tcp::client_handler {
                     extra_data_t::get(client).load_state = extra_data_t::load_state_e::await_known_packs;
                     extra_data_t::get(client).ka_solution.set_callback([](int64_t res, base_objects::SharedClientData& client) {
                         client << api::packets::client_bound::configuration::keep_alive{.keep_alive_id = (uint64_t)res};
+                        client.flushPackets(); //keep alive timing should not depend on tick
                     });
                     client << api::packets::client_bound::configuration::select_known_packs{
                         .packs = resources::loaded_packs()
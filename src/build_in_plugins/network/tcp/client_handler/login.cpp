@@ -12,6 +12,7 @@
 #include <src/api/packets.hpp>
 #include <src/api/players.hpp>
 #include <src/base_objects/shared_client_data.hpp>
+#include <src/log.hpp>
 #include <src/mojang/api/hash.hpp>
 #include <src/plugin/main.hpp>
 
@@ -207,17 +208,55 @@ namespace copper_server::build_in_plugins::network::tcp {
                     serverId.update(shs);
                     serverId.update(api::network::tcp::public_key_buffer().data(), api::network::tcp::public_key_buffer().size());
 
-                    client.data = api::mojang::get_session_server().hasJoined(
+                    //client encrypts everything after this packet
+                    client.get_session()->start_symmetric_encryption(shs, shs);
+                    if (api::configuration::get().server.offline_mode) {
+                        client.data = api::mojang::get_session_server().hasJoined(client.name, serverId.hexdigest(), false);
+                        switch_to_plugin_processing_stage(client);
+                        return;
+                    }
+                    //session server answer awaited without blocking, client sends nothing until login finished
+                    extra_data_t::get(client).stage = 4;
+                    auto session = client.get_session()->weak_ref();
+                    api::mojang::get_session_server().hasJoinedAsync(
                         client.name,
                         serverId.hexdigest(),
-                        !api::configuration::get().server.offline_mode
+                        [session](const std::shared_ptr<mojang::api::session_server::player_data>& data) {
+                            auto locked = session.lock();
+                            if (!locked || !locked->is_active())
+                                return;
+                            auto& client = locked->shared_data();
+                            client.data = data;
+                            switch_to_plugin_processing_stage(client);
+                            client.flushPackets();
+                        },
+                        [session, name = client.name](const std::exception_ptr& error) {
+                            try {
+                                std::rethrow_exception(error);
+                            } catch (const std::exception& ex) {
+                                log::debug("Login", "session check of " + name + " failed: " + ex.what());
+                            } catch (...) {
+                            }
+                            auto locked = session.lock();
+                            if (!locked || !locked->is_active())
+                                return;
+                            auto& client = locked->shared_data();
+                            client << api::packets::client_bound::login::login_disconnect{.reason = {Chat("Failed to verify username!").ToStr()}};
+                            client.flushPackets();
+                        }
                     );
-                    client.get_session()->start_symmetric_encryption(shs, shs);
-                    switch_to_plugin_processing_stage(client);
                 } else
                     client << api::packets::client_bound::login::login_disconnect{.reason = {Chat("Invalid protocol state, 1").ToStr()}};
             });
             api::packets::register_server_bound_processor<login_acknowledged>([](login_acknowledged&&, base_objects::SharedClientData&) {});
         }
+
+        void OnPostLoad(const PluginRegistrationPtr&) override {
+            api::mojang::reload_session_server();
+        }
+
+        void OnConfigReload(const PluginRegistrationPtr&) override {
+            api::mojang::reload_session_server();
+        }
     };
 }
\ No newline at end of file
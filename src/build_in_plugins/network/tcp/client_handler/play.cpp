@@ -137,6 +137,7 @@ namespace copper_server::build_in_plugins::network::tcp::client_handler {
             api::packets::register_server_bound_processor<api::packets::server_bound::configuration::finish_configuration>([this](api::packets::server_bound::configuration::finish_configuration&&, base_objects::SharedClientData& client) {
                 extra_data_t::get(client).ka_solution.set_callback([](int64_t res, base_objects::SharedClientData& client) {
                     client << api::packets::client_bound::configuration::keep_alive{.keep_alive_id = (uint64_t)res};
+                    client.flushPackets(); //keep alive timing should not depend on tick
                 });
                 extra_data_t::get(client).ka_solution.make_keep_alive_packet();
 
@@ -314,8 +315,9 @@ namespace copper_server::build_in_plugins::network::tcp::client_handler {
                 //TODO
             });
 
-            api::packets::register_server_bound_processor<chunk_batch_received>([]([[maybe_unused]] chunk_batch_received&& packet, [[maybe_unused]] base_objects::SharedClientData& client) {
-                //TODO
+            api::packets::register_server_bound_processor<chunk_batch_received>([](chunk_batch_received&& packet, base_objects::SharedClientData& client) {
+                if (auto& player_entity = client.player_data.assigned_entity; player_entity && player_entity->world_syncing_data)
+                    player_entity->world_syncing_data->chunk_sending.acknowledge(packet.chunks_per_tick);
             });
 
             api::packets::register_server_bound_processor<client_command>([](client_command&& packet, [[maybe_unused]] base_objects::SharedClientData& client) {
@@ -525,15 +527,13 @@ namespace copper_server::build_in_plugins::network::tcp::client_handler {
             });
             api::packets::register_server_bound_processor<swing>([](swing&& packet, base_objects::SharedClientData& client) {
                 if (client.player_data.assigned_entity)
-                    if (client.player_data.assigned_entity->current_world())
-                        client.player_data.assigned_entity->current_world()->locked([&](auto& world) {
-                            world.entity_animation(
-                                *client.player_data.assigned_entity,
-                                packet.hand == swing::hand_e::main
-                                    ? base_objects::entity_animation::swing_main_arm
-                                    : base_objects::entity_animation::swing_offhand
-                            );
-                        });
+                    if (auto world = client.player_data.assigned_entity->current_world(); world)
+                        world->entity_animation(
+                            *client.player_data.assigned_entity,
+                            packet.hand == swing::hand_e::main
+                                ? base_objects::entity_animation::swing_main_arm
+                                : base_objects::entity_animation::swing_offhand
+                        );
             });
             api::packets::register_server_bound_processor<teleport_to_entity>([]([[maybe_unused]] teleport_to_entity&& packet, [[maybe_unused]] base_objects::SharedClientData& client) {
                 //TODO
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <bit>
+#include <mutex>
+#include <src/api/configuration.hpp>
+#include <src/build_in_plugins/network/tcp/pipeline.hpp>
+
+namespace copper_server::build_in_plugins::network::tcp {
+    const char* to_string(pipeline_stage stage) {
+        switch (stage) {
+        case pipeline_stage::io:
+            return "io";
+        case pipeline_stage::queue:
+            return "queue";
+        case pipeline_stage::dispatch:
+            return "dispatch";
+        case pipeline_stage::send:
+            return "send";
+        case pipeline_stage::flush:
+            return "flush";
+        default:
+            return "undefined";
+        }
+    }
+
+    void latency_histogram::record(std::chrono::steady_clock::duration duration) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        size_t bucket = us > 0 ? std::bit_width(uint64_t(us)) : 0;
+        counts[std::min(bucket, buckets - 1)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::array<uint64_t, latency_histogram::buckets> latency_histogram::snapshot() const {
+        std::array<uint64_t, buckets> res;
+        for (size_t i = 0; i < buckets; i++)
+            res[i] = counts[i].load(std::memory_order_relaxed);
+        return res;
+    }
+
+    void latency_histogram::reset() {
+        for (auto& it : counts)
+            it.store(0, std::memory_order_relaxed);
+    }
+
+    latency_histogram& stage_latency(pipeline_stage stage) {
+        static std::array<latency_histogram, (size_t)pipeline_stage::_count> histograms;
+        return histograms[(size_t)stage];
+    }
+
+    inbound_queue::inbound_queue(std::function<void()>&& on_push)
+        : on_push(std::move(on_push)) {}
+
+    bool inbound_queue::push(std::vector<uint8_t>&& data) {
+        {
+            fast_task::mutex_unify unify(mutex);
+            std::unique_lock lock(unify);
+            while (!closed && entries.size() >= std::max<uint32_t>(api::configuration::get().protocol.inbound_queue_size, 1))
+                not_full.wait(lock);
+            if (closed)
+                return false;
+            entries.push_back({std::move(data), std::chrono::steady_clock::now(), {}});
+        }
+        on_push();
+        return true;
+    }
+
+    bool inbound_queue::try_pop(entry& res) {
+        std::lock_guard guard(mutex);
+        if (entries.empty() || entries.front().not_before > std::chrono::steady_clock::now())
+            return false;
+        res = std::move(entries.front());
+        entries.pop_front();
+        not_full.notify_all();
+        return true;
+    }
+
+    void inbound_queue::defer(entry&& packet, std::chrono::steady_clock::time_point until) {
+        std::lock_guard guard(mutex);
+        if (closed)
+            return;
+        packet.not_before = until;
+        entries.push_front(std::move(packet));
+    }
+
+    bool inbound_queue::ready() {
+        std::lock_guard guard(mutex);
+        return !entries.empty() && entries.front().not_before <= std::chrono::steady_clock::now();
+    }
+
+    void inbound_queue::close() {
+        std::lock_guard guard(mutex);
+        closed = true;
+        entries.clear();
+        not_full.notify_all();
+    }
+
+    bool inbound_queue::empty() {
+        std::lock_guard guard(mutex);
+        return entries.empty();
+    }
+
+    std::vector<uint8_t> inbound_queue::take_buffer() {
+        std::lock_guard guard(mutex);
+        if (spare.empty())
+            return {};
+        auto res = std::move(spare.back());
+        spare.pop_back();
+        return res;
+    }
+
+    void inbound_queue::give_back(std::vector<uint8_t>&& buffer) {
+        std::lock_guard guard(mutex);
+        if (spare.size() < max_spare_buffers) {
+            buffer.clear();
+            spare.push_back(std::move(buffer));
+        }
+    }
+}
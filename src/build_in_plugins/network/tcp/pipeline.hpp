@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_BUILD_IN_PLUGINS_NETWORK_TCP_PIPELINE
+#define SRC_BUILD_IN_PLUGINS_NETWORK_TCP_PIPELINE
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <library/fast_task.hpp>
+#include <vector>
+
+namespace copper_server::build_in_plugins::network::tcp {
+    //connection stages, io is decompression and copy of each framed packet on connection task,
+    //queue is wait for game worker, dispatch is packet handling, send is framing of outgoing packets, flush is encryption and write
+    enum class pipeline_stage : uint8_t {
+        io,
+        queue,
+        dispatch,
+        send,
+        flush,
+        _count
+    };
+
+    const char* to_string(pipeline_stage stage);
+
+    //counts durations in power of two buckets of microseconds, bucket `i` holds durations less than 2^i us
+    class latency_histogram {
+    public:
+        static constexpr size_t buckets = 32;
+
+        void record(std::chrono::steady_clock::duration duration);
+        std::array<uint64_t, buckets> snapshot() const;
+        void reset();
+
+    private:
+        std::array<std::atomic_uint64_t, buckets> counts{};
+    };
+
+    latency_histogram& stage_latency(pipeline_stage stage);
+
+    //bounded queue of framed and decompressed packets between connection task and game workers
+    //`push` blocks connection task while queue full, so client is not read until game workers catch up
+    class inbound_queue {
+    public:
+        struct entry {
+            std::vector<uint8_t> data;
+            std::chrono::steady_clock::time_point queued;
+            std::chrono::steady_clock::time_point not_before; //set for packets delayed by packet limits
+        };
+
+        //`on_push` called after each push, used to start consumer
+        inbound_queue(std::function<void()>&& on_push);
+
+        //returns false when queue closed
+        bool push(std::vector<uint8_t>&& data);
+        //returns false when queue empty or first packet is not due yet
+        bool try_pop(entry& res);
+        //returns popped packet to queue front, packets behind it waits too so order is kept
+        void defer(entry&& packet, std::chrono::steady_clock::time_point until);
+        //true when first packet could be popped now
+        bool ready();
+        //unblocks producer, following pushes fail
+        void close();
+        bool empty();
+
+        //buffers of popped packets are reused for next pushes
+        std::vector<uint8_t> take_buffer();
+        void give_back(std::vector<uint8_t>&& buffer);
+
+    private:
+        static constexpr size_t max_spare_buffers = 16;
+
+        fast_task::task_mutex mutex;
+        fast_task::task_condition_variable not_full;
+        std::deque<entry> entries;
+        std::vector<std::vector<uint8_t>> spare;
+        std::function<void()> on_push;
+        bool closed = false;
+    };
+}
+
+#endif /* SRC_BUILD_IN_PLUGINS_NETWORK_TCP_PIPELINE */
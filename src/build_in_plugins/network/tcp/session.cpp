@@ -6,11 +6,16 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
+#include <algorithm>
+#include <cstring>
+#include <src/api/configuration.hpp>
 #include <src/api/players.hpp>
 #include <src/base_objects/network/tcp/client.hpp>
 #include <src/build_in_plugins/network/tcp/session.hpp>
 #include <src/build_in_plugins/network/tcp/util.hpp>
 #include <src/log.hpp>
+#include <src/util/task_management.hpp>
+#include <unordered_set>
 
 namespace copper_server::build_in_plugins::network::tcp {
     using base_objects::network::tcp::client;
@@ -18,14 +23,24 @@ namespace copper_server::build_in_plugins::network::tcp {
     constexpr bool CONSTEXPR_DEBUG_DATA_TRANSPORT = true;
     std::atomic_uint64_t id_gen(0);
     bool session::do_log_connection_errors = true;
+    std::atomic_bool session::coalesce_sends = false;
+
+    fast_task::task_mutex sessions_mutex;
+    std::unordered_set<session*> sessions;
 
     session::session(fast_task::networking::TcpNetworkStream& s, client* client_handler, float& set_timeout)
-        : api::network::tcp::session(id_gen++), stream(&s), timeout(set_timeout) {
+        : api::network::tcp::session(id_gen++), stream(&s), timeout(set_timeout), idle_timer(connection_timers()), dispatch_timer(connection_timers()), last_received(std::chrono::steady_clock::now().time_since_epoch().count()) {
         chandler = client_handler->define_ourself(this);
-        read_data.resize(1024);
+        attach_pipeline();
+        std::lock_guard guard(sessions_mutex);
+        sessions.insert(this);
     }
 
     session::~session() noexcept {
+        {
+            std::lock_guard guard(sessions_mutex);
+            sessions.erase(this);
+        }
         if (_sharedData) {
             try {
                 api::players::handlers::on_disconnect.await_notify(shared_data_ref());
@@ -46,7 +61,9 @@ namespace copper_server::build_in_plugins::network::tcp {
     }
 
     void session::disconnect() {
+        inbound.close();
         std::lock_guard guard(tc);
+        outbound.clear();
         if (stream) {
             stream->close();
             stream = nullptr;
@@ -60,6 +77,8 @@ namespace copper_server::build_in_plugins::network::tcp {
     bool session::start_symmetric_encryption(const list_array<uint8_t>& encryption_key, const list_array<uint8_t>& encryption_iv) {
         if (!encryption.initialize(encryption_key, encryption_iv))
             return false;
+        std::lock_guard guard(tc);
+        write_outbound(true); //collected packets were framed before encryption
         encryption_enabled = true;
         return true;
     }
@@ -74,11 +93,91 @@ namespace copper_server::build_in_plugins::network::tcp {
     }
 
     void session::send_indirect(base_objects::network::response&& resp) {
-        if ((resp.do_disconnect || resp.do_disconnect_after_send) && resp.data.size())
-            send(base_objects::network::response::disconnect(tcp_client_handle::prepare_send(std::move(resp), this)));
-        if (resp.do_disconnect)
-            send(base_objects::network::response::disconnect());
-        send(base_objects::network::response::answer(tcp_client_handle::prepare_send(std::move(resp), this)));
+        if (resp.do_disconnect || resp.do_disconnect_after_send) {
+            if (resp.data.size())
+                send(base_objects::network::response::disconnect(tcp_client_handle::prepare_send(std::move(resp), this)));
+            else
+                send(base_objects::network::response::disconnect());
+            return;
+        }
+        if (resp.data.empty())
+            return;
+        //<for debug, set CONSTEXPR_DEBUG_DATA_TRANSPORT to false to disable this block>
+        if constexpr (CONSTEXPR_DEBUG_DATA_TRANSPORT)
+            for (auto& it : resp.data)
+                client::log_console("S (" + std::to_string(id) + ")", it.data, it.data.size());
+        //</for debug, set CONSTEXPR_DEBUG_DATA_TRANSPORT to false to disable this block>
+        std::lock_guard guard(tc);
+        auto started = std::chrono::steady_clock::now();
+        //framed directly into outbound buffer, so packets are not copied again until socket write
+        for (auto& it : resp.data)
+            tcp_client_handle::prepare_send(std::move(it), this, outbound);
+        stage_latency(pipeline_stage::send).record(std::chrono::steady_clock::now() - started);
+        uint32_t flush_size = api::configuration::get().protocol.send_buffer_flush_size;
+        if (!coalesce_sends || !flush_size || outbound.size() >= flush_size)
+            write_outbound();
+    }
+
+    void session::flush() {
+        std::lock_guard guard(tc);
+        write_outbound();
+    }
+
+    std::weak_ptr<api::network::tcp::session> session::weak_ref() {
+        return weak_from_this();
+    }
+
+    void session::flush_all() {
+        //encryption and writes are done without `sessions_mutex`, so connecting and closing sessions does not wait for them
+        std::vector<std::weak_ptr<session>> alive;
+        {
+            std::lock_guard guard(sessions_mutex);
+            alive.reserve(sessions.size());
+            for (auto it : sessions)
+                alive.push_back(it->weak_from_this());
+        }
+        for (auto& it : alive)
+            if (auto self = it.lock())
+                self->flush();
+    }
+
+    void session::write_outbound(bool force) {
+        if (outbound.empty())
+            return;
+        auto started = std::chrono::steady_clock::now();
+        size_t size = egress_allowance(started, force);
+        if (!size)
+            return;
+        if (stream) {
+            //encrypted right before write, so bytes held back by rate limit stays in plain and keeps cipher order
+            if (encryption_enabled && !encryption.encrypt(outbound.data(), size))
+                throw std::runtime_error("failed to encrypt packets");
+            stream->write((char*)outbound.data(), size);
+        }
+        stage_latency(pipeline_stage::flush).record(std::chrono::steady_clock::now() - started);
+        if (size < outbound.size()) {
+            outbound.erase(outbound.begin(), outbound.begin() + size);
+            return;
+        }
+        outbound.clear(); //keeps capacity, so next ticks does not allocate
+        if (outbound.capacity() > max_retained_outbound)
+            outbound.shrink_to_fit();
+    }
+
+    size_t session::egress_allowance(std::chrono::steady_clock::time_point now, bool force) {
+        uint32_t rate = api::configuration::get().protocol.rate_limit;
+        if (!rate)
+            return outbound.size();
+        //bucket holds at most one second of traffic, default refill time is zero so first write gets full bucket
+        double elapsed = std::chrono::duration<double>(now - egress_refilled).count();
+        egress_refilled = now;
+        egress_tokens = std::min(egress_tokens + elapsed * rate, double(rate));
+        size_t size = outbound.size();
+        if (!force)
+            size = egress_tokens > 0 ? std::min(size, size_t(egress_tokens)) : 0;
+        //forced write goes into debt, which delays next writes
+        egress_tokens -= double(size);
+        return size;
     }
 
     void session::send(base_objects::network::response&& resp) {
@@ -87,56 +186,101 @@ namespace copper_server::build_in_plugins::network::tcp {
             for (auto& it : resp.data)
                 client::log_console("S (" + std::to_string(id) + ")", it.data, it.data.size());
         //</for debug, set CONSTEXPR_DEBUG_DATA_TRANSPORT to false to disable this block>
-        if (resp.do_disconnect)
+        if (resp.do_disconnect || (resp.data.empty() && resp.do_disconnect_after_send)) {
+            {
+                std::lock_guard guard(tc);
+                write_outbound(true);
+            }
             disconnect();
-        else if (resp.data.size()) {
-            list_array<uint8_t> response_data;
-            for (auto& it : resp.data)
-                response_data.push_back(std::move(it.data));
-
-
+        } else if (resp.data.size()) {
+            //collected packets goes first to keep order
             std::lock_guard guard(tc);
-            if (encryption_enabled)
-                encryption.encrypt(response_data, response_data);
-            if (stream) {
-                std::shared_ptr<std::vector<uint8_t>> send_data = std::make_shared<std::vector<uint8_t>>(response_data.begin(), response_data.end());
-                stream->write((char*)response_data.data(), response_data.size());
-                if (resp.do_disconnect_after_send) {
-                    stream->force_write();
-                    stream->close();
-                }
+            for (auto& it : resp.data)
+                outbound.insert(outbound.end(), it.data.data(), it.data.data() + it.data.size());
+            write_outbound(resp.do_disconnect_after_send);
+            if (stream && resp.do_disconnect_after_send) {
+                stream->force_write();
+                stream->close();
             }
-        } else if (resp.do_disconnect_after_send)
-            disconnect();
+        }
+    }
+
+    size_t session::prepare_read(size_t wanted) {
+        //whole packet must fit, otherwise it never would be processed
+        size_t capacity = std::max<size_t>(api::configuration::get().protocol.buffer, api::configuration::get().protocol.max_accept_packet_size) + 5;
+        if (read_buffer.size() < capacity)
+            read_buffer.resize(capacity);
+        if (read_begin == read_end)
+            read_begin = read_end = 0;
+        else if (read_end == read_buffer.size()) {
+            std::memmove(read_buffer.data(), read_buffer.data() + read_begin, read_end - read_begin);
+            read_end -= read_begin;
+            read_begin = 0;
+        }
+        return std::min(wanted, read_buffer.size() - read_end);
     }
 
     void session::received(std::span<char> readed_data) {
-        list_array<uint8_t> convert_data((uint8_t*)readed_data.data(), readed_data.size());
         //<for debug, set CONSTEXPR_DEBUG_DATA_TRANSPORT to false to disable this block>
         if constexpr (CONSTEXPR_DEBUG_DATA_TRANSPORT)
-            client::log_console("P (" + std::to_string(id) + ")", convert_data, convert_data.size());
+            client::log_console("P (" + std::to_string(id) + ")", list_array<uint8_t>((uint8_t*)readed_data.data(), readed_data.size()), readed_data.size());
         //</for debug, set CONSTEXPR_DEBUG_DATA_TRANSPORT to false to disable this block>
-        if (encryption_enabled) {
-            encryption.decrypt(convert_data, convert_data);
-            //<for debug, set CONSTEXPR_DEBUG_DATA_TRANSPORT to false to disable this block>
-            if constexpr (CONSTEXPR_DEBUG_DATA_TRANSPORT)
-                client::log_console("PD (" + std::to_string(id) + ")", convert_data, convert_data.size());
-            //</for debug, set CONSTEXPR_DEBUG_DATA_TRANSPORT to false to disable this block>
-            read_data_cached.push_back(std::move(convert_data));
-        } else
-            read_data_cached.push_back(list_array<uint8_t>(convert_data.data(), convert_data.size()));
+        last_received = std::chrono::steady_clock::now().time_since_epoch().count();
+        while (!readed_data.empty()) {
+            size_t part = prepare_read(readed_data.size());
+            if (!part)
+                throw std::runtime_error("packet does not fit into receive buffer");
+            uint8_t* target = read_buffer.data() + read_end;
+            std::memcpy(target, readed_data.data(), part);
+            if (encryption_enabled) {
+                if (!encryption.decrypt(target, part))
+                    throw std::runtime_error("failed to decrypt packets");
+                //<for debug, set CONSTEXPR_DEBUG_DATA_TRANSPORT to false to disable this block>
+                if constexpr (CONSTEXPR_DEBUG_DATA_TRANSPORT)
+                    client::log_console("PD (" + std::to_string(id) + ")", list_array<uint8_t>(target, part), part);
+                //</for debug, set CONSTEXPR_DEBUG_DATA_TRANSPORT to false to disable this block>
+            }
+            read_end += part;
+            readed_data = readed_data.subspan(part);
+            send(proceed_data());
+            if (!stream)
+                break;
+        }
+        flush();
+    }
 
-        send(proceed_data());
+    void session::watch_idle() {
+        idle_timer.set_callback([weak = weak_from_this()] {
+            if (auto self = weak.lock())
+                self->check_idle();
+        });
+        dispatch_timer.set_callback([weak = weak_from_this()] {
+            if (auto self = weak.lock())
+                self->schedule_dispatch();
+        });
+        check_idle();
+    }
+
+    void session::check_idle() {
+        if (!is_active() || timeout <= 0)
+            return;
+        auto limit = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeout));
+        auto idle = std::chrono::steady_clock::now() - std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_received.load()));
+        if (idle >= limit)
+            disconnect();
+        else
+            idle_timer.arm(limit - idle);
     }
 
     base_objects::network::response session::proceed_data() {
         while (true) {
-            base_objects::network::response tmp(chandler->work_client(read_data_cached));
-            read_data_cached.erase(0, tmp.valid_till);
+            base_objects::network::response tmp(chandler->work_client(std::span<uint8_t>(read_buffer.data() + read_begin, read_end - read_begin)));
+            read_begin += tmp.valid_till;
             if (auto redefHandler = chandler->redefine_handler(); redefHandler && !tmp.is_disconnect()) {
                 tmp.valid_till = 0;
                 delete chandler;
                 chandler = redefHandler;
+                attach_pipeline();
                 tmp = chandler->on_switch();
                 if (tmp.data.empty() && !tmp.do_disconnect && !tmp.do_disconnect_after_send)
                     continue;
@@ -145,6 +289,59 @@ namespace copper_server::build_in_plugins::network::tcp {
         }
     }
 
+    void session::attach_pipeline() {
+        if (auto handle = dynamic_cast<tcp_client_handle*>(chandler))
+            handle->pipeline = &inbound;
+    }
+
+    void session::schedule_dispatch() {
+        bool expected = false;
+        if (dispatching.compare_exchange_strong(expected, true))
+            Task::start([self = shared_from_this()] { self->dispatch_inbound(); });
+    }
+
+    void session::dispatch_inbound() {
+        //handler is not switched after packets became queued
+        auto handle = dynamic_cast<tcp_client_handle*>(chandler);
+        inbound_queue::entry packet;
+        for (size_t i = 0; i < dispatch_batch && handle && inbound.try_pop(packet); i++) {
+            auto started = std::chrono::steady_clock::now();
+            stage_latency(pipeline_stage::queue).record(started - packet.queued);
+            base_objects::network::response resp;
+            try {
+                ArrayStream data(packet.data.data(), packet.data.size());
+                resp = handle->work_packet(data);
+            } catch (const std::exception& ex) {
+                resp = handle->exception(ex);
+            } catch (...) {
+                resp = handle->unexpected_exception();
+            }
+            stage_latency(pipeline_stage::dispatch).record(std::chrono::steady_clock::now() - started);
+            if (auto until = shared_data().packet_budget.take_delay(); until != std::chrono::steady_clock::time_point()) {
+                //worker is released, packet and everything behind it waits in queue, full queue pauses reads of this client
+                inbound.defer(std::move(packet), until);
+                dispatch_timer.arm(std::max(until - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero()));
+                break;
+            }
+            inbound.give_back(std::move(packet.data));
+            try {
+                send_indirect(std::move(resp));
+            } catch (...) {
+                disconnect();
+            }
+            if (!is_active())
+                break;
+        }
+        try {
+            flush();
+        } catch (...) {
+            disconnect();
+        }
+        dispatching = false;
+        if (is_active() && inbound.ready())
+            schedule_dispatch();
+    }
+
     client& session::handler() {
         return *chandler;
     }
@@ -13,12 +13,17 @@
 #include <src/base_objects/encryption/aes.hpp>
 #include <src/base_objects/network/response.hpp>
 #include <src/base_objects/network/tcp/client.hpp>
+#include <src/base_objects/network/timer_wheel.hpp>
 #include <src/base_objects/shared_client_data.hpp>
+#include <src/build_in_plugins/network/tcp/pipeline.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <vector>
 
 namespace copper_server::build_in_plugins::network::tcp {
 
-    class session final : public api::network::tcp::session {
+    class session final : public api::network::tcp::session, public std::enable_shared_from_this<session> {
         fast_task::task_mutex tc;
         fast_task::networking::TcpNetworkStream* stream;
 
@@ -38,19 +43,55 @@ namespace copper_server::build_in_plugins::network::tcp {
         base_objects::network::tcp::client& handler();
 
         void received(std::span<char> read_data);
+        //disconnects session when nothing received for `all_connections_timeout_seconds`, also binds delayed dispatch timer
+        void watch_idle();
 
         void request_buffer(size_t new_size) override;
 
         void send_indirect(base_objects::network::response&&) override;
+        void flush() override;
+        std::weak_ptr<api::network::tcp::session> weak_ref() override;
+
+        //flushes every session, called at tick end
+        static void flush_all();
+        //when disabled `send_indirect` writes packets immediately
+        static std::atomic_bool coalesce_sends;
+
     private:
         void send(base_objects::network::response&& resp);
+        //writes collected packets, without `force` only as much as `protocol.rate_limit` allows, rest waits for next flush
+        void write_outbound(bool force = false);
+        size_t egress_allowance(std::chrono::steady_clock::time_point now, bool force);
+        size_t prepare_read(size_t wanted);
         base_objects::network::response proceed_data();
+        void attach_pipeline();
+        void schedule_dispatch();
+        void dispatch_inbound();
+        void check_idle();
+
+        //packets handled by one dispatch task, then it reschedules itself so one client does not hold game worker
+        static constexpr size_t dispatch_batch = 64;
 
-        std::vector<uint8_t> read_data;
-        list_array<uint8_t> read_data_cached;
+        //framed packets waiting for flush, guarded by `tc`, reused between flushes
+        std::vector<uint8_t> outbound;
+        static constexpr size_t max_retained_outbound = 1 << 20;
+        //token bucket for `protocol.rate_limit`, in bytes, guarded by `tc`
+        double egress_tokens = 0;
+        std::chrono::steady_clock::time_point egress_refilled;
+        //received and decrypted bytes, not processed part is [read_begin, read_end), moved to start only when end reached
+        std::vector<uint8_t> read_buffer;
+        size_t read_begin = 0;
+        size_t read_end = 0;
         base_objects::client_data_holder _sharedData;
         float& timeout;
+        //rearmed only when it fires, receive just stores time
+        base_objects::network::wheel_timer idle_timer;
+        //restarts dispatch when packet delayed by packet limits becomes due
+        base_objects::network::wheel_timer dispatch_timer;
+        std::atomic<std::chrono::steady_clock::rep> last_received;
         base_objects::network::tcp::client* chandler = nullptr;
+        inbound_queue inbound{[this] { schedule_dispatch(); }};
+        std::atomic_bool dispatching = false;
         bool encryption_enabled : 1 = false;
         bool packet_sent : 1 = false;
     };
@@ -6,15 +6,19 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
+#include <src/api/client.hpp>
 #include <src/api/configuration.hpp>
 #include <src/api/network.hpp>
+#include <src/api/packets.hpp>
 #include <src/api/server.hpp>
+#include <src/base_objects/commands.hpp>
 #include <src/log.hpp>
 #include <src/plugin/main.hpp>
 
 #include <library/fast_task/include/networking.hpp>
 #include <src/build_in_plugins/network/tcp/session.hpp>
 #include <src/build_in_plugins/network/tcp/universal_client_handle.hpp>
+#include <src/build_in_plugins/network/tcp/util.hpp>
 
 #include <stacktrace>
 
@@ -27,6 +31,7 @@ namespace copper_server::build_in_plugins::network::tcp {
             return;
 
         auto session = std::make_shared<tcp::session>(stream, tcp_handler, api::configuration::get().protocol.all_connections_timeout_seconds);
+        session->watch_idle();
         try {
             while (!stream.is_closed()) {
                 auto input = stream.read_available_ref();
@@ -48,10 +53,57 @@ namespace copper_server::build_in_plugins::network::tcp {
         session->disconnect();
     }
 
+    std::string latency_report(pipeline_stage stage) {
+        auto counts = stage_latency(stage).snapshot();
+        uint64_t total = 0;
+        for (auto it : counts)
+            total += it;
+        std::string res = std::string(to_string(stage)) + ": " + std::to_string(total);
+        if (!total)
+            return res;
+        //upper bounds of buckets where 50%, 99% and all records are reached
+        auto bound_of = [&](uint64_t needed) {
+            uint64_t collected = 0;
+            for (size_t i = 0; i < counts.size(); i++) {
+                collected += counts[i];
+                if (collected >= needed)
+                    return uint64_t(1) << i;
+            }
+            return uint64_t(1) << (counts.size() - 1);
+        };
+        res += ", p50 < " + std::to_string(bound_of((total + 1) / 2)) + "us";
+        res += ", p99 < " + std::to_string(bound_of(total - total / 100)) + "us";
+        res += ", max < " + std::to_string(bound_of(total)) + "us";
+        return res;
+    }
+
     class TCPServerPlugin : public PluginAutoRegister<"network/tcp_server", TCPServerPlugin> {
         std::shared_ptr<fast_task::networking::TcpNetworkServer> tcp_server;
+        std::shared_ptr<fast_task::task> timers_ticking;
+
+        //not bound to world ticks, connections are timed out even when no world loaded
+        void start_timers() {
+            if (timers_ticking)
+                return;
+            timers_ticking = std::make_shared<fast_task::task>([]() {
+                auto& timers = connection_timers();
+                while (!fast_task::this_task::is_cancellation_requested()) {
+                    timers.advance(std::chrono::steady_clock::now());
+                    fast_task::this_task::sleep_for(timers.resolution());
+                }
+            });
+            fast_task::scheduler::start(timers_ticking);
+        }
+
+        void stop_timers() {
+            if (timers_ticking) {
+                timers_ticking->await_notify_cancel();
+                timers_ticking = nullptr;
+            }
+        }
 
         void start() {
+            start_timers();
             tcp_server->start();
             if (tcp_server->is_running()) {
                 auto address = tcp_server->server_address();
@@ -66,15 +118,19 @@ namespace copper_server::build_in_plugins::network::tcp {
 
         void stop() {
             tcp_server->stop();
+            stop_timers();
             log::info("Network", "TCP server stopped on " + tcp_server->server_address().to_string());
         }
 
     public:
         TCPServerPlugin() {
             register_event(api::server::shutdown_event, base_objects::events::priority::low, [this]() { if (tcp_server) stop(); return false; });
+            register_event(api::server::tick_end_event, base_objects::events::priority::low, []() { session::flush_all(); return false; });
+            session::coalesce_sends = true;
         }
 
         void OnPostLoad(const PluginRegistrationPtr&) override {
+            api::packets::reload_packet_limits();
             if (!tcp_server) {
                 tcp_server = std::make_shared<fast_task::networking::TcpNetworkServer>(handler, api::configuration::get().server.ip + ":" + std::to_string(api::configuration::get().server.port));
                 tcp_server->set_configuration(fast_task::networking::TcpConfiguration{.buffer_size = api::configuration::get().protocol.new_client_buffer, .allow_ip4 = true});
@@ -83,7 +139,23 @@ namespace copper_server::build_in_plugins::network::tcp {
                 start();
         }
 
+        void OnCommandsLoad(const PluginRegistrationPtr&, base_objects::command_root_browser& browser) override {
+            using predicate = base_objects::parser;
+            auto latency = browser.add_child("network").add_child({"latency", "shows latency of network stages", "/network latency"});
+            latency
+                .set_callback({"command.network.latency", {"console"}}, [](const list_array<predicate>&, base_objects::command_context& context) {
+                    for (size_t i = 0; i < (size_t)pipeline_stage::_count; i++)
+                        context.executor << api::client::play::system_chat{.content = latency_report((pipeline_stage)i)};
+                });
+            latency.add_child({"reset", "clears latency of network stages", "/network latency reset"})
+                .set_callback({"command.network.latency.reset", {"console"}}, [](const list_array<predicate>&, base_objects::command_context&) {
+                    for (size_t i = 0; i < (size_t)pipeline_stage::_count; i++)
+                        stage_latency((pipeline_stage)i).reset();
+                });
+        }
+
         void OnConfigReload(const PluginRegistrationPtr&) override {
+            api::packets::reload_packet_limits();
             if (tcp_server)
                 tcp_server->set_configuration(fast_task::networking::TcpConfiguration{.buffer_size = api::configuration::get().protocol.new_client_buffer, .allow_ip4 = true});
         }
@@ -15,14 +15,20 @@
 #include <src/api/network/tcp.hpp>
 #include <src/base_objects/network/response.hpp>
 #include <src/base_objects/network/tcp/client.hpp>
+#include <src/base_objects/network/timer_wheel.hpp>
 #include <src/base_objects/packets.hpp>
 #include <src/base_objects/ptr_optional.hpp>
+#include <src/build_in_plugins/network/tcp/pipeline.hpp>
 #include <src/util/readers.hpp>
 #include <string>
+#include <vector>
 
 namespace copper_server::build_in_plugins::network::tcp {
     class session;
 
+    //keep alive and idle timeouts of all connections, advanced by tcp server once per tick
+    base_objects::network::timer_wheel& connection_timers();
+
     class keep_alive_solution {
         struct handle_t;
         std::shared_ptr<handle_t> handle;
@@ -47,24 +53,31 @@ namespace copper_server::build_in_plugins::network::tcp {
     protected:
         base_objects::network::tcp::client* next_handler = nullptr;
         api::network::tcp::session* session;
+        std::vector<uint8_t> incoming; //reused for decompressed packets
+        inbound_queue* pipeline = nullptr; //set by session, play packets are pushed to it instead of handling them on connection task
+        bool pipelined = false;
+        static constexpr int32_t max_uncompressed_packet_size = 8388608; //same as vanilla limit
 
         static uint64_t generate_random_int();
-        list_array<uint8_t> prepare_incoming(ArrayStream& packet);
+        //returned stream valid until next call
+        ArrayStream prepare_incoming(ArrayStream& packet);
         static list_array<uint8_t> prepare_send(base_objects::network::response::item&& packet_item, api::network::tcp::session* session);
+        //appends framed packet to `out`, does not allocate when `out` has enough capacity
+        static void prepare_send(base_objects::network::response::item&& packet_item, api::network::tcp::session* session, std::vector<uint8_t>& out);
         static list_array<list_array<uint8_t>> prepare_send(base_objects::network::response&& packet, api::network::tcp::session* session);
         virtual base_objects::network::response work_packet(ArrayStream& packet) = 0;
         virtual base_objects::network::response too_large_packet() = 0;
         virtual base_objects::network::response exception(const std::exception& ex) = 0;
         virtual base_objects::network::response unexpected_exception() = 0;
         virtual base_objects::network::response on_switching();
-        base_objects::network::response work_packets(list_array<uint8_t>& combined);
+        base_objects::network::response work_packets(std::span<uint8_t> combined);
 
 
     public:
         tcp_client_handle(api::network::tcp::session* session);
         ~tcp_client_handle() override;
         base_objects::network::tcp::client* redefine_handler() override;
-        base_objects::network::response work_client(list_array<uint8_t>& clientData) final;
+        base_objects::network::response work_client(std::span<uint8_t> clientData) final;
         base_objects::network::response on_switch() final;
     };
 }
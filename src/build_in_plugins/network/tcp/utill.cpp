@@ -6,6 +6,7 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
+#include <cstring>
 #include <exception>
 #include <functional>
 #include <library/enbt/enbt.hpp>
@@ -16,14 +17,25 @@
 #include <src/registers.hpp>
 #include <string>
 #include <utf8.h>
-#include <zlib.h>
 
 namespace copper_server::build_in_plugins::network::tcp {
 
+    base_objects::network::timer_wheel& connection_timers() {
+        //one tick resolution, one turn covers 51 seconds so usual keep alive and timeouts never wait for next turn
+        static base_objects::network::timer_wheel wheel(std::chrono::milliseconds(50), 1024);
+        return wheel;
+    }
+
+    namespace {
+        std::chrono::steady_clock::duration seconds_of(float seconds) {
+            return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+        }
+    }
+
     struct keep_alive_solution::handle_t {
         std::function<void(int64_t, base_objects::SharedClientData&)> callback;
-        fast_task::deadline_timer timeout_timer;
-        fast_task::deadline_timer next_keep_alive;
+        base_objects::network::wheel_timer timeout_timer{connection_timers()};
+        base_objects::network::wheel_timer next_keep_alive{connection_timers()};
         api::network::tcp::session* session;
         std::chrono::system_clock::time_point last_keep_alive;
 
@@ -32,13 +44,8 @@ namespace copper_server::build_in_plugins::network::tcp {
         }
 
         void _keep_alive_sended() {
-            timeout_timer.expires_from_now(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(api::configuration::get().protocol.timeout_seconds)));
-
             last_keep_alive = std::chrono::system_clock::now();
-            timeout_timer.async_wait([this](fast_task::deadline_timer::status status) {
-                if (status == fast_task::deadline_timer::status::timeouted)
-                    session->disconnect();
-            });
+            timeout_timer.arm(seconds_of(api::configuration::get().protocol.timeout_seconds));
         }
 
         std::chrono::system_clock::duration got_valid_keep_alive(int64_t check) {
@@ -46,12 +53,7 @@ namespace copper_server::build_in_plugins::network::tcp {
             if (check != last_keep_alive.time_since_epoch().count())
                 throw std::runtime_error("got invalid keep alive packet");
             auto res = last_keep_alive - std::chrono::system_clock::now();
-
-            next_keep_alive.expires_from_now(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(api::configuration::get().protocol.keep_alive_send_each_seconds)));
-            next_keep_alive.async_wait([this](fast_task::deadline_timer::status status) {
-                if (status == fast_task::deadline_timer::status::timeouted)
-                    start();
-            });
+            next_keep_alive.arm(seconds_of(api::configuration::get().protocol.keep_alive_send_each_seconds));
             return res;
         }
 
@@ -63,17 +65,26 @@ namespace copper_server::build_in_plugins::network::tcp {
         }
 
         void make_keep_alive_packet() {
-            if (timeout_timer.timed_out() && !next_keep_alive.timed_out()) {
-                if (next_keep_alive.cancel()) {
-                    _keep_alive_sended();
-                    callback(last_keep_alive.time_since_epoch().count(), session->shared_data());
-                }
+            //sends now unless answer for previous keep alive is awaited
+            if (!timeout_timer.armed()) {
+                next_keep_alive.cancel();
+                start();
             }
         }
     };
 
     keep_alive_solution::keep_alive_solution(api::network::tcp::session* session)
-        : handle(std::make_shared<handle_t>(session)) {}
+        : handle(std::make_shared<handle_t>(session)) {
+        //timers fired by wheel could outlive solution, so they does not keep handle alive
+        handle->timeout_timer.set_callback([weak = std::weak_ptr<handle_t>(handle)] {
+            if (auto self = weak.lock())
+                self->session->disconnect();
+        });
+        handle->next_keep_alive.set_callback([weak = std::weak_ptr<handle_t>(handle)] {
+            if (auto self = weak.lock())
+                self->start();
+        });
+    }
 
     keep_alive_solution::~keep_alive_solution() {
         handle->next_keep_alive.cancel();
@@ -142,88 +153,131 @@ namespace copper_server::build_in_plugins::network::tcp {
         return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() ^ gen();
     }
 
-    list_array<uint8_t> tcp_client_handle::prepare_incoming(ArrayStream& packet) {
-        if (session->compression_threshold == -1) {
-            return packet.to_vector();
-        } else {
-            int32_t uncompressed_packet_len = packet.read_var<int32_t>();
-
-            list_array<uint8_t> compressed_packet;
-            z_stream stream;
-            stream.zalloc = Z_NULL;
-            stream.zfree = Z_NULL;
-            stream.opaque = Z_NULL;
-            if ((decltype(stream.avail_in)(-1)) < packet.size_read())
-                throw std::overflow_error("packet size is too large for zlib");
-            stream.avail_in = (decltype(stream.avail_in))packet.size_read();
-            stream.next_in = packet.data_read();
-            int ret = inflateInit(&stream);
-            if (ret != Z_OK)
-                throw std::exception("inflateInit failed");
-            stream.avail_out = uncompressed_packet_len;
-            stream.next_out = (uint8_t*)malloc(stream.avail_out);
-            ret = inflate(&stream, Z_FINISH);
-            if (ret != Z_STREAM_END)
-                throw std::exception("inflate failed");
-            WriteVar<int32_t>(stream.total_out, compressed_packet);
-            compressed_packet.push_back(stream.next_out, stream.total_out);
-            free(stream.next_out);
-            stream.next_out = nullptr;
-            ret = inflateEnd(&stream);
-            if (ret != Z_OK)
-                throw std::exception("inflateEnd failed");
-            return compressed_packet;
+    namespace {
+        //caller holds `session->compression_mutex`
+        base_objects::network::compressor& compressor_of(api::network::tcp::session* session) {
+            if (!session->compression) {
+                auto& backend = api::configuration::get().protocol.compression_backend;
+                if (base_objects::network::has_compressor(backend))
+                    session->compression = base_objects::network::make_compressor(backend);
+                else {
+                    log::warn("Network", "compression backend " + backend + " not found, using zlib");
+                    session->compression = base_objects::network::make_compressor("zlib");
+                }
+            }
+            return *session->compression;
         }
-    }
 
-    list_array<uint8_t> tcp_client_handle::prepare_send(base_objects::network::response::item&& packet_item, api::network::tcp::session* session) {
-        list_array<uint8_t>& packet = packet_item.data;
-        list_array<uint8_t> build_packet;
-        if (session->compression_threshold == -1) {
-            WriteVar<int32_t>(packet.size(), build_packet);
-            build_packet.push_back(std::move(packet));
-        } else {
-            if (packet.size() < (size_t)session->compression_threshold) {
-                build_packet.push_back(0);
-                build_packet.push_back(std::move(packet));
-            } else {
-                list_array<uint8_t> compressed_packet = std::move(packet);
-                z_stream stream;
-                stream.zalloc = Z_NULL;
-                stream.zfree = Z_NULL;
-                stream.opaque = Z_NULL;
-                if ((decltype(stream.avail_in)(-1)) < compressed_packet.size())
-                    throw std::overflow_error("compressed packet size is too large for zlib");
-                stream.avail_in = (decltype(stream.avail_in))compressed_packet.size();
-                stream.next_in = compressed_packet.data();
-                int ret = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
-                if (ret != Z_OK)
-                    throw std::exception("deflateInit failed");
-                auto to_decompress = compressed_packet.size() + compressed_packet.size() / 1000 + 12 + 1;
-                if ((decltype(stream.avail_in)(-1)) < to_decompress)
-                    throw std::overflow_error("packet size is too large for zlib");
-                stream.avail_in = (decltype(stream.avail_in))to_decompress;
-                stream.next_out = (uint8_t*)malloc(stream.avail_out);
-                ret = deflate(&stream, Z_FINISH);
-                if (ret != Z_STREAM_END)
-                    throw std::exception("deflate failed");
-                WriteVar<int32_t>(compressed_packet.size(), build_packet);
-                build_packet.push_back(stream.next_out, stream.total_out);
-                free(stream.next_out);
-                stream.next_out = nullptr;
-                ret = deflateEnd(&stream);
-                if (ret != Z_OK)
-                    throw std::exception("deflateEnd failed");
+        size_t var_int_size(uint32_t value) {
+            size_t res = 1;
+            while (value >= 0x80) {
+                value >>= 7;
+                ++res;
+            }
+            return res;
+        }
+
+        uint8_t* write_var_int(uint32_t value, uint8_t* out) {
+            while (value >= 0x80) {
+                *out++ = uint8_t(value | 0x80);
+                value >>= 7;
+            }
+            *out++ = uint8_t(value);
+            return out;
+        }
+
+        //reads var int without reading past received data, returns false when it is not complete
+        bool try_read_length(ArrayStream& data, int32_t& res) {
+            uint32_t value = 0;
+            size_t available = data.size_read();
+            const uint8_t* it = data.data_read();
+            for (size_t i = 0; i < 5; i++) {
+                if (i == available)
+                    return false;
+                value |= uint32_t(it[i] & 0x7F) << (7 * i);
+                if (!(it[i] & 0x80)) {
+                    data.r += i + 1;
+                    res = (int32_t)value;
+                    return true;
+                }
             }
-            list_array<uint8_t> compressed_size;
-            compressed_size.reserve(5);
-            WriteVar<int32_t>(build_packet.size(), compressed_size);
-            build_packet.push_front(compressed_size);
+            throw std::out_of_range("packet length var int is too big");
+        }
+
+        //writes compressed frame to `out` starting from `start`, returns frame end
+        size_t write_compressed(const list_array<uint8_t>& packet, std::vector<uint8_t>& out, size_t start, api::network::tcp::session* session) {
+            //frame length known only after compression, so frame body written after headroom for length and moved back after it
+            constexpr size_t headroom = 5;
+            std::lock_guard guard(session->compression_mutex);
+            auto& compressor = compressor_of(session);
+            size_t data_length_size = var_int_size((uint32_t)packet.size());
+            size_t bound = compressor.bound(packet.size());
+            out.resize(start + headroom + data_length_size + bound);
+            uint8_t* body = out.data() + start + headroom;
+            write_var_int((uint32_t)packet.size(), body);
+            size_t compressed = compressor.compress(packet.data(), packet.size(), body + data_length_size, bound);
+            size_t frame = data_length_size + compressed;
+            if (frame > INT32_MAX)
+                throw std::overflow_error("compressed packet is too large");
+            size_t frame_length_size = var_int_size((uint32_t)frame);
+            uint8_t* frame_start = body - frame_length_size;
+            write_var_int((uint32_t)frame, frame_start);
+            if (frame_length_size != headroom)
+                std::memmove(out.data() + start, frame_start, frame_length_size + frame);
+            return start + frame_length_size + frame;
+        }
+    }
+
+    ArrayStream tcp_client_handle::prepare_incoming(ArrayStream& packet) {
+        int32_t data_length = packet.read_var<int32_t>();
+        if (data_length == 0) //sent uncompressed because smaller than threshold
+            return packet.read_left();
+        if (data_length < 0 || data_length > max_uncompressed_packet_size)
+            throw std::out_of_range("invalid uncompressed packet size");
+        base_objects::network::compressor* compressor;
+        {
+            std::lock_guard guard(session->compression_mutex);
+            compressor = &compressor_of(session);
+        }
+        incoming.resize((size_t)data_length);
+        compressor->decompress(packet.data_read(), packet.size_read(), incoming.data(), incoming.size());
+        return ArrayStream(incoming.data(), incoming.size());
+    }
+
+    void tcp_client_handle::prepare_send(base_objects::network::response::item&& packet_item, api::network::tcp::session* session, std::vector<uint8_t>& out) {
+        const list_array<uint8_t>& packet = packet_item.data;
+        size_t packet_size = packet.size();
+        if (packet_size > INT32_MAX - 1)
+            throw std::overflow_error("packet is too large");
+        size_t start = out.size();
+        try {
+            if (session->compression_threshold == -1) {
+                out.resize(start + var_int_size((uint32_t)packet_size) + packet_size);
+                uint8_t* it = write_var_int((uint32_t)packet_size, out.data() + start);
+                if (packet_size)
+                    std::memcpy(it, packet.data(), packet_size);
+            } else if (packet_size < (size_t)session->compression_threshold) {
+                size_t frame = packet_size + 1;
+                out.resize(start + var_int_size((uint32_t)frame) + frame);
+                uint8_t* it = write_var_int((uint32_t)frame, out.data() + start);
+                *it++ = 0;
+                if (packet_size)
+                    std::memcpy(it, packet.data(), packet_size);
+            } else
+                out.resize(write_compressed(packet, out, start, session));
+        } catch (...) {
+            out.resize(start);
+            throw;
         }
 
         if (packet_item.apply_compression)
             session->compression_threshold = packet_item.compression_threshold;
-        return build_packet;
+    }
+
+    list_array<uint8_t> tcp_client_handle::prepare_send(base_objects::network::response::item&& packet_item, api::network::tcp::session* session) {
+        std::vector<uint8_t> build_packet;
+        prepare_send(std::move(packet_item), session, build_packet);
+        return list_array<uint8_t>(build_packet.data(), build_packet.size());
     }
 
     list_array<list_array<uint8_t>> tcp_client_handle::prepare_send(base_objects::network::response&& packet, api::network::tcp::session* session) {
@@ -239,7 +293,7 @@ namespace copper_server::build_in_plugins::network::tcp {
         return base_objects::network::response::empty();
     }
 
-    base_objects::network::response tcp_client_handle::work_packets(list_array<uint8_t>& combined) {
+    base_objects::network::response tcp_client_handle::work_packets(std::span<uint8_t> combined) {
         assert(session);
         if (!session->is_not_legacy) {
             if (combined.size() < 2)
@@ -254,12 +308,16 @@ namespace copper_server::build_in_plugins::network::tcp {
             }
         }
         list_array<list_array<uint8_t>> answer;
-        list_array<uint8_t> processed; //incoming packet
         ArrayStream data(combined.data(), combined.size());
         size_t valid_till = 0;
 
         while (!data.empty()) {
-            int32_t packet_len = data.read_var<int32_t>();
+            size_t packet_start = data.r;
+            int32_t packet_len;
+            if (!try_read_length(data, packet_len))
+                break; //length itself not fully received yet
+            if (packet_len < 0)
+                return too_large_packet();
             if (!data.can_read(packet_len)) {
                 if (packet_len > api::configuration::get().protocol.max_accept_packet_size)
                     return too_large_packet();
@@ -267,14 +325,48 @@ namespace copper_server::build_in_plugins::network::tcp {
             }
 
             ArrayStream packet = data.range_read(packet_len);
+            auto framed = std::chrono::steady_clock::now(); //per packet, one read could carry many packets
             base_objects::network::response answer_it = base_objects::network::response::empty();
+            if (pipeline && !pipelined && api::configuration::get().protocol.inbound_queue_size)
+                pipelined = session->shared_data().packets_state.state == base_objects::SharedClientData::packets_state_t::protocol_state::play;
+            if (pipelined) {
+                //framing and decompression stays here, packet handled by game worker, state does not change encryption or compression after login
+                try {
+                    auto buffer = pipeline->take_buffer();
+                    if (session->compression_threshold != -1) {
+                        ArrayStream uncompressed = prepare_incoming(packet);
+                        buffer.assign(uncompressed.data_read(), uncompressed.data_read() + uncompressed.size_read());
+                    } else
+                        buffer.assign(packet.data_read(), packet.data_read() + packet.size_read());
+                    stage_latency(pipeline_stage::io).record(std::chrono::steady_clock::now() - framed);
+                    if (!pipeline->push(std::move(buffer)))
+                        return base_objects::network::response::disconnect();
+                    valid_till = data.r;
+                    continue;
+                } catch (const std::exception& ex) {
+                    answer_it = exception(ex);
+                } catch (...) {
+                    answer_it = unexpected_exception();
+                }
+                answer.push_back(prepare_send(std::move(answer_it), session));
+                if ((answer_it.do_disconnect || answer_it.do_disconnect_after_send) && answer.size())
+                    return base_objects::network::response::disconnect(std::move(answer));
+                if (answer_it.do_disconnect)
+                    return base_objects::network::response::disconnect();
+                continue;
+            }
             try {
                 if (session->compression_threshold != -1) {
-                    list_array<uint8_t> compressed_packet = prepare_incoming(packet);
-                    ArrayStream compressed_data(compressed_packet.data(), compressed_packet.size());
-                    answer_it = work_packet(compressed_data);
+                    ArrayStream uncompressed = prepare_incoming(packet);
+                    answer_it = work_packet(uncompressed);
                 } else
                     answer_it = work_packet(packet);
+                if (auto until = session->shared_data().packet_budget.take_delay(); until != std::chrono::steady_clock::time_point()) {
+                    //handled on connection task, so only this connection stops being read, then same packet is framed again
+                    fast_task::this_task::sleep_for(until - std::chrono::steady_clock::now());
+                    data.r = packet_start;
+                    continue;
+                }
 
                 answer.push_back(prepare_send(std::move(answer_it), session));
                 if ((answer_it.do_disconnect || answer_it.do_disconnect_after_send) && answer.size())
@@ -310,7 +402,7 @@ namespace copper_server::build_in_plugins::network::tcp {
         return next_handler;
     }
 
-    base_objects::network::response tcp_client_handle::work_client(list_array<uint8_t>& clientData) {
+    base_objects::network::response tcp_client_handle::work_client(std::span<uint8_t> clientData) {
         return work_packets(clientData);
     }
 
@@ -15,7 +15,8 @@ namespace copper_server::build_in_plugins {
         void OnCommandsLoad(const PluginRegistrationPtr&, base_objects::command_root_browser& browser) override {
             using predicate = base_objects::parser;
 
-            auto _protocol = browser.add_child("protocol").add_child("debug");
+            auto _protocol_root = browser.add_child("protocol");
+            auto _protocol = _protocol_root.add_child("debug");
             _protocol.add_child({"enable", "enables protocol logging to debug", "/protocol debug enable"})
                 .set_callback("command.protocol.debug.enable", [](const list_array<predicate>&, base_objects::command_context&) {
                     api::packets::set_debug_mode(true);
@@ -24,6 +25,33 @@ namespace copper_server::build_in_plugins {
                 .set_callback("command.protocol.debug.disable", [](const list_array<predicate>&, base_objects::command_context&) {
                     api::packets::set_debug_mode(false);
                 });
+
+            auto _limits = _protocol_root.add_child({"limits", "shows counters of limited packets", "/protocol limits"});
+            _limits.set_callback({"command.protocol.limits", {"console"}}, [](const list_array<predicate>&, base_objects::command_context& context) {
+                auto stats = api::packets::get_packet_limit_stats();
+                if (stats.empty())
+                    context.executor << api::client::play::system_chat{.content = "No packets were limited"};
+                for (auto& it : stats)
+                    context.executor << api::client::play::system_chat{
+                        .content = std::string(it.name)
+                                   + ": received " + std::to_string(it.received)
+                                   + ", dropped " + std::to_string(it.dropped)
+                                   + ", delayed " + std::to_string(it.delayed)
+                                   + ", kicked " + std::to_string(it.kicked)
+                    };
+            });
+            _limits.add_child({"offenders", "shows clients which exceeded packet limits most times", "/protocol limits offenders"})
+                .set_callback({"command.protocol.limits.offenders", {"console"}}, [](const list_array<predicate>&, base_objects::command_context& context) {
+                    auto offenders = api::packets::get_packet_limit_offenders(10);
+                    if (offenders.empty())
+                        context.executor << api::client::play::system_chat{.content = "No clients exceeded packet limits"};
+                    for (auto& [name, count] : offenders)
+                        context.executor << api::client::play::system_chat{.content = name + ": " + std::to_string(count)};
+                });
+            _limits.add_child({"reset", "clears counters of limited packets", "/protocol limits reset"})
+                .set_callback({"command.protocol.limits.reset", {"console"}}, [](const list_array<predicate>&, base_objects::command_context&) {
+                    api::packets::reset_packet_limit_stats();
+                });
         }
     };
 }
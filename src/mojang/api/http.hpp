@@ -95,5 +95,94 @@ namespace mojang::api {
             return request("POST", address, query, port, max_redirects);
         }
     };
+
+    //keeps socket open between requests while server allows it, redirects are not followed
+    //not thread safe, one request at time
+    class http_connection {
+        std::unique_ptr<fast_task::networking::TcpClientSocket> client;
+        std::string address;
+        uint16_t port;
+
+    public:
+        using response = boost::beast::http::response<boost::beast::http::string_body>;
+        static constexpr size_t max_body_size = 1 << 20;
+
+        http_connection(const std::string& address, uint16_t port = 80)
+            : address(address), port(port) {}
+
+        const std::string& host() const {
+            return address;
+        }
+
+        uint16_t host_port() const {
+            return port;
+        }
+
+        bool is_open() const {
+            return (bool)client;
+        }
+
+        void close() {
+            client = nullptr;
+        }
+
+        //throws when connection failed, connection is closed then
+        response request(const std::string& mode, const std::string& query) {
+            try {
+                return request_unsafe(mode, query);
+            } catch (...) {
+                client = nullptr;
+                throw;
+            }
+        }
+
+    private:
+        response request_unsafe(const std::string& mode, const std::string& query) {
+            if (!client)
+                client.reset(fast_task::networking::TcpClientSocket::connect({address, port}));
+            {
+                std::string str = mode + " " + query + " HTTP/1.1\r\n";
+                str += "Host: " + address + (port != 80 ? (":" + std::to_string(port)) : "") + "\r\n";
+                str += "Accept: */*\r\n";
+                str += "Connection: keep-alive\r\n\r\n";
+                client->send((uint8_t*)str.data(), (int32_t)str.size());
+            }
+
+            boost::beast::http::response_parser<boost::beast::http::string_body> parser;
+            parser.eager(true);
+            parser.body_limit(max_body_size);
+            std::string pending;
+            uint8_t recv_buf[1024];
+            while (!parser.is_done()) {
+                auto received = client->recv(recv_buf, sizeof(recv_buf));
+                boost::beast::error_code ec;
+                if (!received) {
+                    //body without length ends with connection
+                    if (!parser.got_some())
+                        throw std::runtime_error("HTTP connection closed");
+                    parser.put_eof(ec);
+                    if (ec)
+                        throw std::runtime_error("HTTP parse error: " + ec.message());
+                    client = nullptr;
+                    break;
+                }
+                pending.append((const char*)recv_buf, received);
+                while (!pending.empty() && !parser.is_done()) {
+                    size_t used = parser.put(boost::asio::buffer(pending), ec);
+                    pending.erase(0, used);
+                    if (ec == boost::beast::http::error::need_more)
+                        break;
+                    if (ec)
+                        throw std::runtime_error("HTTP parse error: " + ec.message());
+                    if (!used)
+                        break;
+                }
+            }
+            response res = parser.release();
+            if (!res.keep_alive())
+                client = nullptr;
+            return res;
+        }
+    };
 }
 #endif /* SRC_MOJANG_API_HTTP */
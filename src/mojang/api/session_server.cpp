@@ -6,40 +6,51 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
+#include <algorithm>
 #include <boost/json.hpp>
+#include <cctype>
+#include <mutex>
 #include <src/mojang/api/http.hpp>
 #include <src/mojang/api/session_server.hpp>
 #include <src/util/conversions.hpp>
 
 namespace mojang::api {
-    const std::shared_ptr<session_server::player_data> session_server::hasJoined(const std::string& username, const std::string& serverId, bool online_mode, bool cache_result) {
-        auto cache_key = cache.find(username);
-        if (cache_key != cache.end()) {
-            if (!cache_key->second->online_data)
-                if (!online_mode)
-                    return cache_key->second;
+    namespace {
+        constexpr size_t prune_cache_after = 1024;
 
-            if (std::chrono::system_clock::now() - cache_key->second->last_check < cache_duration)
-                return cache_key->second;
-            cache.erase(cache_key);
+        //name comes from client, so it could contain anything
+        std::string url_encode(const std::string& value) {
+            static constexpr char hex[] = "0123456789ABCDEF";
+            std::string res;
+            res.reserve(value.size());
+            for (unsigned char it : value) {
+                if (std::isalnum(it) || it == '_' || it == '-' || it == '.')
+                    res.push_back((char)it);
+                else {
+                    res.push_back('%');
+                    res.push_back(hex[it >> 4]);
+                    res.push_back(hex[it & 15]);
+                }
+            }
+            return res;
         }
 
-        if (online_mode) {
-            std::string response = http::get("sessionserver.mojang.com", "/session/minecraft/hasJoined?username=" + username + "&serverId=" + serverId);
+        std::shared_ptr<session_server::player_data> parse_profile(const std::string& response, const std::string& serverId) {
             auto value = boost::json::parse(response).as_object();
-            player_data data;
+            session_server::player_data data;
 
             data.uuid = copper_server::util::conversions::uuid::from(value["id"].as_string());
             data.uuid_str = copper_server::util::conversions::uuid::to(data.uuid);
             data.online_data = true;
+            data.server_id = serverId;
             if (value.contains("properties")) {
-                std::vector<player_data::property> properties;
+                std::vector<session_server::player_data::property> properties;
                 properties.reserve(value["properties"].as_array().size());
                 for (auto& prop : value["properties"].as_array()) {
                     auto& tree = prop.as_object();
-                    player_data::property convert;
+                    session_server::player_data::property convert;
                     convert.name = tree["name"].as_string();
-                    convert.name = tree["value"].as_string();
+                    convert.value = tree["value"].as_string();
                     if (tree.contains("signature"))
                         convert.signature = tree["signature"].as_string();
                     properties.push_back(std::move(convert));
@@ -47,17 +58,180 @@ namespace mojang::api {
                 data.properties = std::move(properties);
             }
             data.last_check = std::chrono::system_clock::now();
-            if (cache_result)
-                return cache[username] = std::make_shared<player_data>(std::move(data));
-            else
-                return std::make_shared<player_data>(std::move(data));
+            return std::make_shared<session_server::player_data>(std::move(data));
+        }
+    }
+
+    session_server::session_server() = default;
+    session_server::~session_server() = default;
+
+    void session_server::configure(const settings& set) {
+        std::lock_guard guard(mutex);
+        if (set.host != current.host || set.port != current.port || set.path != current.path) {
+            idle.clear();
+            cache.clear();
+        }
+        current = set;
+        if (idle.size() > current.max_idle_connections)
+            idle.resize(current.max_idle_connections);
+    }
+
+    session_server::settings session_server::get_settings() {
+        std::lock_guard guard(mutex);
+        return current;
+    }
 
-        } else {
+    void session_server::clear_cache() {
+        std::lock_guard guard(mutex);
+        cache.clear();
+    }
+
+    std::shared_ptr<session_server::player_data> session_server::cached(const std::string& username, const std::string& serverId, bool online_mode) {
+        auto it = cache.find(username);
+        if (it == cache.end())
+            return nullptr;
+        auto& data = it->second;
+        if (!online_mode)
+            return data->online_data ? nullptr : data;
+        //cached join could not be used by other connection with same name
+        if (data->online_data && data->server_id == serverId && std::chrono::system_clock::now() - data->last_check < current.cache_duration)
+            return data;
+        return nullptr;
+    }
+
+    void session_server::store(const std::string& username, const std::shared_ptr<player_data>& data) {
+        if (cache.size() >= prune_cache_after) {
+            auto now = std::chrono::system_clock::now();
+            std::erase_if(cache, [&](auto& it) { return now - it.second->last_check >= current.cache_duration; });
+        }
+        cache[username] = data;
+    }
+
+    std::shared_ptr<session_server::player_data> session_server::request(const std::string& username, const std::string& serverId) {
+        std::unique_ptr<http_connection> connection;
+        std::string query;
+        {
+            std::lock_guard guard(mutex);
+            query = current.path + "?username=" + url_encode(username) + "&serverId=" + url_encode(serverId);
+            if (!idle.empty()) {
+                connection = std::move(idle.back());
+                idle.pop_back();
+            } else
+                connection = std::make_unique<http_connection>(current.host, current.port);
+        }
+        bool reused = connection->is_open();
+        http_connection::response res;
+        try {
+            res = connection->request("GET", query);
+        } catch (...) {
+            //kept connection could be closed by server while idle, so request retried once with new one
+            if (!reused)
+                throw;
+            res = connection->request("GET", query);
+        }
+        if (connection->is_open()) {
+            std::lock_guard guard(mutex);
+            if (idle.size() < current.max_idle_connections && connection->host() == current.host && connection->host_port() == current.port)
+                idle.push_back(std::move(connection));
+        }
+        switch (res.result()) {
+        case boost::beast::http::status::ok:
+            return parse_profile(res.body(), serverId);
+        case boost::beast::http::status::no_content:
+            throw std::runtime_error("player did not join to session server");
+        default:
+            throw std::runtime_error("HTTP" + (std::string)boost::beast::http::obsolete_reason(res.result()));
+        }
+    }
+
+    const std::shared_ptr<session_server::player_data> session_server::hasJoined(const std::string& username, const std::string& serverId, bool online_mode, bool cache_result) {
+        {
+            std::lock_guard guard(mutex);
+            if (auto res = cached(username, serverId, online_mode))
+                return res;
+        }
+        std::shared_ptr<player_data> res;
+        if (online_mode)
+            res = request(username, serverId);
+        else {
             auto uuid = enbt::raw_uuid::from_string(username);
-            if (cache_result)
-                return (cache[username] = std::make_shared<player_data>(copper_server::util::conversions::uuid::to(uuid), uuid, std::chrono::system_clock::now(), false));
-            else
-                return std::make_shared<player_data>(copper_server::util::conversions::uuid::to(uuid), uuid, std::chrono::system_clock::now(), false);
+            res = std::make_shared<player_data>(copper_server::util::conversions::uuid::to(uuid), uuid, std::chrono::system_clock::now(), false);
+        }
+        if (cache_result) {
+            std::lock_guard guard(mutex);
+            store(username, res);
+        }
+        return res;
+    }
+
+    void session_server::hasJoinedAsync(const std::string& username, const std::string& serverId, callback_t&& callback, fault_t&& fault) {
+        std::shared_ptr<player_data> res;
+        {
+            std::lock_guard guard(mutex);
+            res = cached(username, serverId, true);
+            if (!res) {
+                std::string key = username + '\n' + serverId;
+                auto [it, inserted] = in_flight.try_emplace(key);
+                it->second.waiters.emplace_back(std::move(callback), std::move(fault));
+                if (inserted) {
+                    it->second.username = username;
+                    it->second.server_id = serverId;
+                    if (running < std::max<size_t>(current.max_concurrent_requests, 1)) {
+                        ++running;
+                        start_lookup(key);
+                    } else
+                        queued.push_back(std::move(key));
+                }
+                return;
+            }
+        }
+        callback(res);
+    }
+
+    void session_server::start_lookup(const std::string& key) {
+        fast_task::scheduler::start(std::make_shared<fast_task::task>([this, key]() { run_lookup(key); }));
+    }
+
+    void session_server::run_lookup(const std::string& key) {
+        std::string username;
+        std::string server_id;
+        {
+            std::lock_guard guard(mutex);
+            auto& it = in_flight.at(key);
+            username = it.username;
+            server_id = it.server_id;
+        }
+        std::shared_ptr<player_data> res;
+        std::exception_ptr error;
+        try {
+            res = request(username, server_id);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::vector<std::pair<callback_t, fault_t>> waiters;
+        {
+            std::lock_guard guard(mutex);
+            auto it = in_flight.find(key);
+            waiters = std::move(it->second.waiters);
+            in_flight.erase(it);
+            if (res)
+                store(username, res);
+            if (!queued.empty()) {
+                //slot passed to next lookup, so `running` stays same
+                start_lookup(queued.front());
+                queued.pop_front();
+            } else
+                --running;
+        }
+        for (auto& [callback, fault] : waiters) {
+            try {
+                if (error) {
+                    if (fault)
+                        fault(error);
+                } else if (callback)
+                    callback(res);
+            } catch (...) {
+            }
         }
     }
-}
\ No newline at end of file
+}
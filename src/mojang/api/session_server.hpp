@@ -9,11 +9,20 @@
 #ifndef SRC_MOJANG_API_SESSION_SERVER
 #define SRC_MOJANG_API_SESSION_SERVER
 #include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <library/enbt/enbt.hpp>
+#include <library/fast_task.hpp>
+#include <memory>
 #include <random>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace mojang::api {
+    class http_connection;
+
     class session_server {
     public:
         struct player_data {
@@ -29,12 +38,56 @@ namespace mojang::api {
             bool online_data;
 
             std::vector<property> properties;
+            std::string server_id; //online data is valid only for connection with same server id
         };
 
-        std::unordered_map<std::string, std::shared_ptr<player_data>> cache;
-        std::chrono::system_clock::duration cache_duration = std::chrono::minutes(20);
+        struct settings {
+            std::string host = "sessionserver.mojang.com";
+            uint16_t port = 80;
+            std::string path = "/session/minecraft/hasJoined";
+            std::chrono::system_clock::duration cache_duration = std::chrono::minutes(20);
+            size_t max_concurrent_requests = 8; //other lookups wait in queue
+            size_t max_idle_connections = 4;
+        };
+
+        using callback_t = std::function<void(const std::shared_ptr<player_data>&)>;
+        using fault_t = std::function<void(const std::exception_ptr&)>;
+
+        session_server();
+        ~session_server();
+
+        //drops idle connections and cached results when endpoint changed
+        void configure(const settings& set);
+        settings get_settings();
+        void clear_cache();
 
+        //blocks caller until answer received
         const std::shared_ptr<player_data> hasJoined(const std::string& username, const std::string& serverId, bool online_mode, bool cache_result = true);
+
+        //online check which does not block caller, same concurrent lookups share one request
+        //`callback` or `fault` called from lookup task or from caller when result is cached
+        void hasJoinedAsync(const std::string& username, const std::string& serverId, callback_t&& callback, fault_t&& fault);
+
+    private:
+        struct lookup {
+            std::string username;
+            std::string server_id;
+            std::vector<std::pair<callback_t, fault_t>> waiters;
+        };
+
+        std::shared_ptr<player_data> cached(const std::string& username, const std::string& serverId, bool online_mode);
+        void store(const std::string& username, const std::shared_ptr<player_data>& data);
+        std::shared_ptr<player_data> request(const std::string& username, const std::string& serverId);
+        void start_lookup(const std::string& key);
+        void run_lookup(const std::string& key);
+
+        fast_task::task_mutex mutex;
+        settings current;
+        std::unordered_map<std::string, std::shared_ptr<player_data>> cache;
+        std::unordered_map<std::string, lookup> in_flight; //by username and server id
+        std::deque<std::string> queued;
+        std::vector<std::unique_ptr<http_connection>> idle;
+        size_t running = 0;
     };
 }
 #endif /* SRC_MOJANG_API_SESSION_SERVER */
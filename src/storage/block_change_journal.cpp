@@ -0,0 +1,37 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <src/storage/block_change_journal.hpp>
+
+namespace copper_server::storage {
+    void block_change_journal::mark(int64_t chunk_x, int64_t section_y, int64_t chunk_z, uint8_t local_x, uint8_t local_y, uint8_t local_z) {
+        auto& chunk = chunks(chunk_x, chunk_z);
+        if (chunk.whole)
+            return;
+        auto& section = chunk.sections[section_y];
+        auto pos = pack(local_x, local_y, local_z);
+        if (section.marked.test(pos))
+            return;
+        section.marked.set(pos);
+        section.positions.push_back(pos);
+        ++chunk.count;
+    }
+
+    void block_change_journal::mark_chunk(int64_t chunk_x, int64_t chunk_z) {
+        auto& chunk = chunks(chunk_x, chunk_z);
+        chunk.whole = true;
+        chunk.sections.clear();
+        chunk.count = 0;
+    }
+
+    chunk_map<block_change_journal::chunk_changes> block_change_journal::take() {
+        chunk_map<chunk_changes> res = std::move(chunks);
+        chunks.clear();
+        return res;
+    }
+}
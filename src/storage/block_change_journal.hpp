@@ -0,0 +1,53 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_STORAGE_BLOCK_CHANGE_JOURNAL
+#define SRC_STORAGE_BLOCK_CHANGE_JOURNAL
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <src/storage/chunk_map.hpp>
+
+namespace copper_server::storage {
+    //changed block positions collected during tick, grouped by section
+    //positions are stored as 0xXYZ local index like keys of sub_chunk_data::block_entities, each position is stored once
+    //does not lock anything, owner guards it
+    class block_change_journal {
+    public:
+        struct chunk_changes {
+            struct section_changes {
+                std::bitset<4096> marked;
+                std::vector<uint16_t> positions;
+            };
+
+            std::map<int64_t, section_changes> sections; //by section y in world coordinates
+            size_t count = 0;
+            bool whole = false; //chunk must be resent entirely, sections are not collected
+        };
+
+        static uint16_t pack(uint8_t local_x, uint8_t local_y, uint8_t local_z) {
+            return uint16_t((local_x & 15) << 8 | (local_y & 15) << 4 | (local_z & 15));
+        }
+
+        void mark(int64_t chunk_x, int64_t section_y, int64_t chunk_z, uint8_t local_x, uint8_t local_y, uint8_t local_z);
+        void mark_chunk(int64_t chunk_x, int64_t chunk_z);
+
+        bool empty() const {
+            return chunks.empty();
+        }
+
+        //moves all collected changes out, journal stays empty
+        chunk_map<chunk_changes> take();
+
+    private:
+        chunk_map<chunk_changes> chunks;
+    };
+}
+#endif /* SRC_STORAGE_BLOCK_CHANGE_JOURNAL */
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_STORAGE_CHUNK_MAP
+#define SRC_STORAGE_CHUNK_MAP
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace copper_server::storage {
+    //flat map for chunk columns, key is packed (x, z) pair
+    //chunks are stored in 4x4 tiles found by open addressing index, so neighbor chunks shares tile and cache lines
+    //chunk coordinates must fit in int32, which is 30M blocks from the center
+    //erase never moves entries, so erasing while iterating is allowed, insertion while iterating is not
+    template <class T>
+    class chunk_map {
+    public:
+        struct entry {
+            uint64_t key;
+            T value;
+
+            int64_t x() const {
+                return int32_t(uint32_t(key));
+            }
+
+            int64_t z() const {
+                return int32_t(uint32_t(key >> 32));
+            }
+        };
+
+    private:
+        static constexpr int tile_shift = 2;
+        static constexpr size_t tile_cells = 1 << (tile_shift * 2);
+
+        struct tile {
+            uint16_t occupied = 0; //bit per cell
+            entry cells[tile_cells]{};
+        };
+
+        struct slot {
+            uint64_t key = 0;
+            uint32_t tile = 0; //index + 1, zero is empty slot
+        };
+
+        static constexpr uint32_t erased_slot = UINT32_MAX;
+
+        //empty tiles are reused from `free_tiles`, their cells are reset on erase
+        std::vector<tile> tiles;
+        std::vector<uint32_t> free_tiles;
+        std::vector<slot> index;
+        size_t used = 0;
+        size_t index_used = 0;
+        size_t index_erased = 0;
+
+        static size_t hash(uint64_t key) {
+            //splitmix64 finalizer, neighbor tiles does not cluster in one probe sequence
+            key ^= key >> 30;
+            key *= 0xbf58476d1ce4e5b9ull;
+            key ^= key >> 27;
+            key *= 0x94d049bb133111ebull;
+            key ^= key >> 31;
+            return size_t(key);
+        }
+
+        static uint64_t tile_key(int64_t x, int64_t z) {
+            return pack(x >> tile_shift, z >> tile_shift);
+        }
+
+        static size_t cell_of(int64_t x, int64_t z) {
+            constexpr int64_t mask = (1 << tile_shift) - 1;
+            return size_t(x & mask) | (size_t(z & mask) << tile_shift);
+        }
+
+        size_t find_slot(uint64_t key) const {
+            if (index.empty())
+                return SIZE_MAX;
+            size_t mask = index.size() - 1;
+            for (size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+                if (!index[i].tile)
+                    return SIZE_MAX;
+                if (index[i].tile != erased_slot && index[i].key == key)
+                    return i;
+            }
+        }
+
+        const tile* find_tile(int64_t x, int64_t z) const {
+            size_t slot = find_slot(tile_key(x, z));
+            return slot == SIZE_MAX ? nullptr : &tiles[index[slot].tile - 1];
+        }
+
+        void rehash(size_t new_capacity) {
+            std::vector<slot> old_index(new_capacity);
+            old_index.swap(index);
+            index_erased = 0;
+            size_t mask = new_capacity - 1;
+            for (auto& it : old_index) {
+                if (!it.tile || it.tile == erased_slot)
+                    continue;
+                size_t i = hash(it.key) & mask;
+                while (index[i].tile)
+                    i = (i + 1) & mask;
+                index[i] = it;
+            }
+        }
+
+        tile& insert_tile(uint64_t key) {
+            //keep load factor including tombstones under 3/4
+            if ((index_used + index_erased + 1) * 4 > index.size() * 3)
+                rehash(index.empty() ? 16 : (index_used + 1) * 4 > index.size() * 2 ? index.size() * 2 : index.size());
+            uint32_t id;
+            if (free_tiles.empty()) {
+                id = uint32_t(tiles.size());
+                tiles.emplace_back();
+            } else {
+                id = free_tiles.back();
+                free_tiles.pop_back();
+            }
+            size_t mask = index.size() - 1;
+            size_t i = hash(key) & mask;
+            while (index[i].tile && index[i].tile != erased_slot)
+                i = (i + 1) & mask;
+            if (index[i].tile == erased_slot)
+                --index_erased;
+            index[i] = {key, id + 1};
+            ++index_used;
+            return tiles[id];
+        }
+
+    public:
+        template <bool is_const>
+        class basic_iterator {
+            using map_t = std::conditional_t<is_const, const chunk_map, chunk_map>;
+            map_t* map;
+            size_t pos; //tile index * tile_cells + cell
+
+            void skip() {
+                size_t end = map->tiles.size() * tile_cells;
+                while (pos < end) {
+                    uint16_t occupied = map->tiles[pos / tile_cells].occupied >> (pos % tile_cells);
+                    if (occupied) {
+                        pos += std::countr_zero(occupied);
+                        return;
+                    }
+                    pos = (pos / tile_cells + 1) * tile_cells;
+                }
+            }
+
+        public:
+            basic_iterator(map_t* map, size_t pos)
+                : map(map), pos(pos) {
+                skip();
+            }
+
+            auto& operator*() const {
+                return map->tiles[pos / tile_cells].cells[pos % tile_cells];
+            }
+
+            auto* operator->() const {
+                return &map->tiles[pos / tile_cells].cells[pos % tile_cells];
+            }
+
+            basic_iterator& operator++() {
+                ++pos;
+                skip();
+                return *this;
+            }
+
+            bool operator==(const basic_iterator& other) const {
+                return pos == other.pos;
+            }
+
+            bool operator!=(const basic_iterator& other) const {
+                return pos != other.pos;
+            }
+        };
+
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+        static uint64_t pack(int64_t x, int64_t z) {
+            return uint64_t(uint32_t(int32_t(x))) | (uint64_t(uint32_t(int32_t(z))) << 32);
+        }
+
+        T* find(int64_t x, int64_t z) {
+            return const_cast<T*>(std::as_const(*this).find(x, z));
+        }
+
+        const T* find(int64_t x, int64_t z) const {
+            auto found = find_tile(x, z);
+            size_t cell = cell_of(x, z);
+            return found && (found->occupied >> cell & 1) ? &found->cells[cell].value : nullptr;
+        }
+
+        bool contains(int64_t x, int64_t z) const {
+            return find(x, z);
+        }
+
+        //inserts default value if not exists
+        T& operator()(int64_t x, int64_t z) {
+            uint64_t key = tile_key(x, z);
+            size_t slot = find_slot(key);
+            tile& target = slot == SIZE_MAX ? insert_tile(key) : tiles[index[slot].tile - 1];
+            size_t cell = cell_of(x, z);
+            if (!(target.occupied >> cell & 1)) {
+                target.occupied |= uint16_t(1 << cell);
+                target.cells[cell].key = pack(x, z);
+                ++used;
+            }
+            return target.cells[cell].value;
+        }
+
+        bool erase(int64_t x, int64_t z) {
+            size_t slot = find_slot(tile_key(x, z));
+            if (slot == SIZE_MAX)
+                return false;
+            tile& target = tiles[index[slot].tile - 1];
+            size_t cell = cell_of(x, z);
+            if (!(target.occupied >> cell & 1))
+                return false;
+            target.occupied &= uint16_t(~(1 << cell));
+            target.cells[cell].value = T();
+            --used;
+            if (!target.occupied) {
+                free_tiles.push_back(index[slot].tile - 1);
+                index[slot].tile = erased_slot;
+                --index_used;
+                ++index_erased;
+            }
+            return true;
+        }
+
+        //calls `func(x, z, value)` for each existing of 8 neighbors
+        template <class FN>
+        void for_each_neighbor(int64_t x, int64_t z, FN&& func) {
+            for (int64_t dx = -1; dx <= 1; dx++)
+                for (int64_t dz = -1; dz <= 1; dz++)
+                    if (dx || dz)
+                        if (auto value = find(x + dx, z + dz); value)
+                            func(x + dx, z + dz, *value);
+        }
+
+        size_t size() const {
+            return used;
+        }
+
+        bool empty() const {
+            return !used;
+        }
+
+        void clear() {
+            tiles.clear();
+            free_tiles.clear();
+            index.clear();
+            used = 0;
+            index_used = 0;
+            index_erased = 0;
+        }
+
+        iterator begin() {
+            return iterator(this, 0);
+        }
+
+        iterator end() {
+            return iterator(this, tiles.size() * tile_cells);
+        }
+
+        const_iterator begin() const {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(this, tiles.size() * tile_cells);
+        }
+    };
+}
+#endif /* SRC_STORAGE_CHUNK_MAP */
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <src/storage/entity_index.hpp>
+
+namespace copper_server::storage {
+    void entity_index::erase_item(chunk_map<std::vector<item>>& map, int64_t x, int64_t z, uint64_t id) {
+        auto items = map.find(x, z);
+        if (!items)
+            return;
+        for (auto it = items->begin(); it != items->end(); ++it) {
+            if (it->id == id) {
+                *it = items->back();
+                items->pop_back();
+                break;
+            }
+        }
+        if (items->empty())
+            map.erase(x, z);
+    }
+
+    void entity_index::update(uint64_t id, base_objects::entity* entity, const base_objects::cubic_bounds_chunk_radius& view, int64_t chunk_x, int64_t chunk_z) {
+        auto [it, inserted] = placed.try_emplace(id, placement{entity, view, chunk_x, chunk_z});
+        auto& place = it->second;
+        if (!inserted) {
+            bool view_changed = place.view != view;
+            bool chunk_changed = place.chunk_x != chunk_x || place.chunk_z != chunk_z;
+            if (!view_changed && !chunk_changed)
+                return;
+            //view changes only when entity crosses chunk border, so reinserting all cells is cheap enough
+            if (view_changed) {
+                for_each_cell(place.view, [&](int64_t x, int64_t z) { erase_item(viewers, x, z, id); });
+                for_each_cell(view, [&](int64_t x, int64_t z) { viewers(x, z).push_back({id, entity}); });
+            }
+            if (chunk_changed) {
+                erase_item(occupants, place.chunk_x, place.chunk_z, id);
+                occupants(chunk_x, chunk_z).push_back({id, entity});
+            }
+            place = placement{entity, view, chunk_x, chunk_z};
+            return;
+        }
+        for_each_cell(view, [&](int64_t x, int64_t z) { viewers(x, z).push_back({id, entity}); });
+        occupants(chunk_x, chunk_z).push_back({id, entity});
+    }
+
+    void entity_index::remove(uint64_t id) {
+        auto it = placed.find(id);
+        if (it == placed.end())
+            return;
+        for_each_cell(it->second.view, [&](int64_t x, int64_t z) { erase_item(viewers, x, z, id); });
+        erase_item(occupants, it->second.chunk_x, it->second.chunk_z, id);
+        placed.erase(it);
+    }
+
+    void entity_index::clear() {
+        placed.clear();
+        viewers.clear();
+        occupants.clear();
+    }
+}
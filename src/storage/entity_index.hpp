@@ -0,0 +1,84 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_STORAGE_ENTITY_INDEX
+#define SRC_STORAGE_ENTITY_INDEX
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <src/base_objects/bounds.hpp>
+#include <src/storage/chunk_map.hpp>
+
+namespace copper_server::base_objects {
+    struct entity;
+}
+
+namespace copper_server::storage {
+    //spatial hash of world entities
+    //viewers are indexed by processing region in cells of 8x8 chunks, lookup returns candidates which region may cover the chunk
+    //occupants are indexed by chunk of their position
+    //does not lock anything, owner guards it
+    class entity_index {
+    public:
+        struct item {
+            uint64_t id;
+            base_objects::entity* entity;
+        };
+
+        static constexpr int64_t cell_shift = 3;
+
+        //inserts entity or moves it, unchanged entity is not touched
+        void update(uint64_t id, base_objects::entity* entity, const base_objects::cubic_bounds_chunk_radius& view, int64_t chunk_x, int64_t chunk_z);
+        void remove(uint64_t id);
+
+        //calls `func(const item&)` for entities which view cells contain chunk, caller checks exact region
+        template <class FN>
+        void for_each_viewer(int64_t chunk_x, int64_t chunk_z, FN&& func) const {
+            if (auto cell = viewers.find(chunk_x >> cell_shift, chunk_z >> cell_shift); cell)
+                for (auto& it : *cell)
+                    func(it);
+        }
+
+        //calls `func(const item&)` for entities which position is in chunk
+        template <class FN>
+        void for_each_occupant(int64_t chunk_x, int64_t chunk_z, FN&& func) const {
+            if (auto chunk = occupants.find(chunk_x, chunk_z); chunk)
+                for (auto& it : *chunk)
+                    func(it);
+        }
+
+        size_t size() const {
+            return placed.size();
+        }
+
+        void clear();
+
+    private:
+        struct placement {
+            base_objects::entity* entity;
+            base_objects::cubic_bounds_chunk_radius view;
+            int64_t chunk_x;
+            int64_t chunk_z;
+        };
+
+        template <class FN>
+        static void for_each_cell(const base_objects::cubic_bounds_chunk_radius& view, FN&& func) {
+            for (int64_t x = (view.center_x - view.radius) >> cell_shift; x <= (view.center_x + view.radius) >> cell_shift; x++)
+                for (int64_t z = (view.center_z - view.radius) >> cell_shift; z <= (view.center_z + view.radius) >> cell_shift; z++)
+                    func(x, z);
+        }
+
+        static void erase_item(chunk_map<std::vector<item>>& map, int64_t x, int64_t z, uint64_t id);
+
+        std::unordered_map<uint64_t, placement> placed;
+        chunk_map<std::vector<item>> viewers;
+        chunk_map<std::vector<item>> occupants;
+    };
+}
+#endif /* SRC_STORAGE_ENTITY_INDEX */
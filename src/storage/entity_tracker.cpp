@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <cmath>
+#include <src/base_objects/entity.hpp>
+#include <src/storage/entity_tracker.hpp>
+
+namespace copper_server::storage {
+    int64_t entity_tracker::encode(double value) {
+        return std::llround(value * units_per_block);
+    }
+
+    void entity_tracker::track(uint64_t id, base_objects::entity* entity, util::VECTOR position, int32_t interval) {
+        states[id] = state{
+            .entity = entity,
+            .sent_x = encode(position.x),
+            .sent_y = encode(position.y),
+            .sent_z = encode(position.z),
+            .interval = uint32_t(std::max(interval, 1)),
+        };
+    }
+
+    void entity_tracker::remove(uint64_t id) {
+        states.erase(id);
+    }
+
+    void entity_tracker::mark(uint64_t id, uint8_t changes) {
+        auto it = states.find(id);
+        if (it == states.end())
+            return;
+        if (!it->second.changes)
+            dirty.push_back(id);
+        it->second.changes |= changes;
+    }
+
+    void entity_tracker::flush(uint64_t tick, std::vector<update>& res) {
+        size_t kept = 0;
+        for (size_t i = 0; i < dirty.size(); i++) {
+            auto it = states.find(dirty[i]);
+            //removed or already flushed through duplicated entry of re-tracked id
+            if (it == states.end() || !it->second.changes)
+                continue;
+            auto& st = it->second;
+            //teleports are not delayed, client would show entity at old place until next interval
+            if (!(st.changes & teleport) && tick - st.last_flush < st.interval) {
+                dirty[kept++] = dirty[i];
+                continue;
+            }
+            update upd{dirty[i], st.entity, {}, st.changes, std::move(st.viewers)};
+            if (upd.changes & (position | teleport)) {
+                auto& pos = st.entity->position;
+                int64_t x = encode(pos.x);
+                int64_t y = encode(pos.y);
+                int64_t z = encode(pos.z);
+                int64_t dx = x - st.sent_x;
+                int64_t dy = y - st.sent_y;
+                int64_t dz = z - st.sent_z;
+                auto fits = [](int64_t d) { return d >= INT16_MIN && d <= INT16_MAX; };
+                if (!(upd.changes & teleport) && !(fits(dx) && fits(dy) && fits(dz)))
+                    upd.changes |= teleport;
+                if (upd.changes & teleport)
+                    upd.changes &= ~position;
+                else if (dx || dy || dz)
+                    upd.move = {double(dx) / units_per_block, double(dy) / units_per_block, double(dz) / units_per_block};
+                else
+                    upd.changes &= ~position;
+                st.sent_x = x;
+                st.sent_y = y;
+                st.sent_z = z;
+            }
+            st.changes = 0;
+            st.last_flush = tick;
+            if (upd.changes)
+                res.push_back(std::move(upd));
+            else
+                st.viewers = std::move(upd.viewers);
+        }
+        dirty.resize(kept);
+    }
+
+    void entity_tracker::set_viewers(uint64_t id, std::vector<uint64_t>&& viewers) {
+        if (auto it = states.find(id); it != states.end())
+            it->second.viewers = std::move(viewers);
+    }
+
+    void entity_tracker::clear() {
+        states.clear();
+        dirty.clear();
+    }
+}
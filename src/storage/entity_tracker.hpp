@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_STORAGE_ENTITY_TRACKER
+#define SRC_STORAGE_ENTITY_TRACKER
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <src/util/calculations.hpp>
+
+namespace copper_server::base_objects {
+    struct entity;
+}
+
+namespace copper_server::storage {
+    //accumulates entity changes during tick, so viewers receive one update per entity per track interval
+    //positions are kept in protocol units (1/4096 block), relative moves are computed from last sent position and does not drift
+    //does not lock anything, owner guards it
+    class entity_tracker {
+    public:
+        enum change : uint8_t {
+            position = 1,
+            teleport = 2,
+            rotation = 4,
+            head_rotation = 8,
+            motion = 16,
+        };
+
+        struct update {
+            uint64_t id;
+            base_objects::entity* entity;
+            util::VECTOR move; //relative move, exact multiply of 1/4096
+            uint8_t changes;   //`teleport` is also set when move does not fit relative packet
+            //ids of viewers which received entity state before, sorted
+            //owner replaces it with actual viewers and returns it through `set_viewers`
+            std::vector<uint64_t> viewers;
+        };
+
+        static constexpr int64_t units_per_block = 4096;
+
+        //starts tracking entity from its current position
+        void track(uint64_t id, base_objects::entity* entity, util::VECTOR position, int32_t interval);
+        void remove(uint64_t id);
+        //untracked ids are ignored
+        void mark(uint64_t id, uint8_t changes);
+
+        //collects entities which have changes and which interval elapsed, their changes are reset
+        void flush(uint64_t tick, std::vector<update>& res);
+        void set_viewers(uint64_t id, std::vector<uint64_t>&& viewers);
+
+        size_t size() const {
+            return states.size();
+        }
+
+        void clear();
+
+    private:
+        struct state {
+            base_objects::entity* entity;
+            int64_t sent_x;
+            int64_t sent_y;
+            int64_t sent_z;
+            uint64_t last_flush = 0;
+            uint32_t interval;
+            uint8_t changes = 0;
+            std::vector<uint64_t> viewers;
+        };
+
+        static int64_t encode(double value);
+
+        std::unordered_map<uint64_t, state> states;
+        std::vector<uint64_t> dirty;
+    };
+}
+#endif /* SRC_STORAGE_ENTITY_TRACKER */
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <src/storage/loading_levels.hpp>
+
+namespace copper_server::storage {
+    loading_levels::area loading_levels::bounds_of(const source& src) {
+        return {src.point.center_x - src.point.radius, src.point.center_z - src.point.radius, src.point.center_x + src.point.radius, src.point.center_z + src.point.radius};
+    }
+
+    uint8_t loading_levels::seed_of(int64_t x, int64_t z) const {
+        auto seed = seeds.find(x, z);
+        return seed ? *seed : unloaded_level;
+    }
+
+    void loading_levels::reseed(const area& changed) {
+        std::vector<uint8_t> old;
+        old.reserve(size_t(changed.max_x - changed.min_x + 1) * size_t(changed.max_z - changed.min_z + 1));
+        for (int64_t x = changed.min_x; x <= changed.max_x; x++)
+            for (int64_t z = changed.min_z; z <= changed.max_z; z++) {
+                old.push_back(seed_of(x, z));
+                seeds.erase(x, z);
+            }
+        for (auto& [id, src] : sources) {
+            auto bounds = bounds_of(src);
+            if (!bounds.intersects(changed))
+                continue;
+            for (int64_t x = std::max(bounds.min_x, changed.min_x); x <= std::min(bounds.max_x, changed.max_x); x++)
+                for (int64_t z = std::max(bounds.min_z, changed.min_z); z <= std::min(bounds.max_z, changed.max_z); z++) {
+                    if (auto seed = seeds.find(x, z); seed)
+                        *seed = std::min(*seed, src.level);
+                    else
+                        seeds(x, z) = src.level;
+                }
+        }
+        size_t i = 0;
+        for (int64_t x = changed.min_x; x <= changed.max_x; x++)
+            for (int64_t z = changed.min_z; z <= changed.max_z; z++)
+                if (auto seed = old[i++]; seed_of(x, z) != seed)
+                    changed_seeds.emplace_back(x, z, seed);
+    }
+
+    void loading_levels::set(size_t id, const base_objects::cubic_bounds_chunk_radius& point, int64_t level) {
+        if (level >= max_level) {
+            remove(id);
+            return;
+        }
+        source src{point, uint8_t(std::max<int64_t>(level, 0))};
+        auto it = sources.find(id);
+        if (it == sources.end()) {
+            sources.emplace(id, src);
+            reseed(bounds_of(src));
+            return;
+        }
+        if (it->second.point == src.point && it->second.level == src.level)
+            return;
+        auto old_area = bounds_of(it->second);
+        auto new_area = bounds_of(src);
+        it->second = src;
+        //moved ticket usually overlaps old position, so single box is cheaper than two
+        if (old_area.intersects(new_area))
+            reseed({
+                std::min(old_area.min_x, new_area.min_x),
+                std::min(old_area.min_z, new_area.min_z),
+                std::max(old_area.max_x, new_area.max_x),
+                std::max(old_area.max_z, new_area.max_z),
+            });
+        else {
+            reseed(old_area);
+            reseed(new_area);
+        }
+    }
+
+    void loading_levels::remove(size_t id) {
+        if (auto it = sources.find(id); it != sources.end()) {
+            auto old_area = bounds_of(it->second);
+            sources.erase(it);
+            reseed(old_area);
+        }
+    }
+
+    uint8_t loading_levels::level_of(int64_t x, int64_t z) const {
+        auto level = levels.find(x, z);
+        return level ? *level : unloaded_level;
+    }
+
+    void loading_levels::flush(const std::function<void(int64_t x, int64_t z, uint8_t old_level, uint8_t new_level)>& func) {
+        std::vector<std::tuple<int64_t, int64_t, uint8_t>> changed;
+        changed.swap(changed_seeds);
+        chunk_map<uint8_t> old_levels; //first level of every touched chunk
+        auto assign = [&](int64_t x, int64_t z, uint8_t level) {
+            uint8_t old_level = level_of(x, z);
+            if (!old_levels.contains(x, z))
+                old_levels(x, z) = old_level;
+            if (level == unloaded_level)
+                levels.erase(x, z);
+            else
+                levels(x, z) = level;
+        };
+
+        //levels are ordered from strongest, so lower levels are propagated first and every chunk settles once
+        std::vector<std::vector<std::pair<int64_t, int64_t>>> buckets(unloaded_level);
+        auto offer = [&](int64_t x, int64_t z, uint8_t level) {
+            if (level < level_of(x, z)) {
+                assign(x, z, level);
+                buckets[level].emplace_back(x, z);
+            }
+        };
+
+        //chunks which level came from raised seed are cleared with everything that could be derived from them,
+        //then not derived neighbors and seeds in cleared area are propagated again
+        std::vector<std::tuple<int64_t, int64_t, uint8_t>> cleared;
+        for (auto [x, z, old_seed] : changed) {
+            uint8_t level = level_of(x, z);
+            uint8_t seed = seed_of(x, z);
+            if (seed <= level)
+                offer(x, z, seed);
+            else if (old_seed == level) {
+                assign(x, z, unloaded_level);
+                cleared.emplace_back(x, z, level);
+            }
+        }
+        std::vector<std::pair<int64_t, int64_t>> reseeded;
+        for (size_t i = 0; i < cleared.size(); i++) {
+            auto [x, z, level] = cleared[i];
+            reseeded.emplace_back(x, z);
+            for (int64_t dx = -1; dx <= 1; dx++)
+                for (int64_t dz = -1; dz <= 1; dz++) {
+                    if (!dx && !dz)
+                        continue;
+                    uint8_t neighbor = level_of(x + dx, z + dz);
+                    if (neighbor == unloaded_level)
+                        continue;
+                    if (neighbor > level) {
+                        assign(x + dx, z + dz, unloaded_level);
+                        cleared.emplace_back(x + dx, z + dz, neighbor);
+                    } else
+                        buckets[neighbor].emplace_back(x + dx, z + dz);
+                }
+        }
+        for (auto [x, z] : reseeded)
+            offer(x, z, seed_of(x, z));
+
+        for (uint8_t level = 0; level < unloaded_level; level++) {
+            for (auto [x, z] : buckets[level]) {
+                if (level_of(x, z) != level)
+                    continue;
+                if (level + 1 >= unloaded_level)
+                    continue;
+                for (int64_t dx = -1; dx <= 1; dx++)
+                    for (int64_t dz = -1; dz <= 1; dz++)
+                        if (dx || dz)
+                            offer(x + dx, z + dz, uint8_t(level + 1));
+            }
+            std::vector<std::pair<int64_t, int64_t>>().swap(buckets[level]);
+        }
+
+        for (auto& entry : old_levels) {
+            uint8_t new_level = level_of(entry.x(), entry.z());
+            if (new_level != entry.value)
+                func(entry.x(), entry.z(), entry.value, new_level);
+        }
+    }
+
+    void loading_levels::clear() {
+        sources.clear();
+        seeds.clear();
+        levels.clear();
+        changed_seeds.clear();
+    }
+}
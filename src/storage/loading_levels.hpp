@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_STORAGE_LOADING_LEVELS
+#define SRC_STORAGE_LOADING_LEVELS
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <src/base_objects/bounds.hpp>
+#include <src/storage/chunk_map.hpp>
+
+namespace copper_server::storage {
+    //chunk load levels produced by loading tickets
+    //chunk inside ticket bounds gets ticket level, outside it grows by one per chunk until `max_level`
+    //ticket bounds seeds levels, added, moved or removed tickets changes only seeds under their bounds
+    //and `flush` propagates changed seeds outward, so work is proportional to chunks which level changed
+    class loading_levels {
+    public:
+        static constexpr uint8_t max_level = 44;
+        static constexpr uint8_t unloaded_level = max_level + 1;
+
+        //adds or moves ticket, unchanged ticket does not mark anything
+        //tickets with level `max_level` or higher does not produce levels
+        void set(size_t id, const base_objects::cubic_bounds_chunk_radius& point, int64_t level);
+        void remove(size_t id);
+
+        uint8_t level_of(int64_t x, int64_t z) const;
+
+        bool has_changes() const {
+            return !changed_seeds.empty();
+        }
+
+        //propagates changed seeds and calls `func(x, z, old_level, new_level)` for every chunk which level changed
+        void flush(const std::function<void(int64_t x, int64_t z, uint8_t old_level, uint8_t new_level)>& func);
+
+        //chunks with level lower than `unloaded_level`
+        size_t size() const {
+            return levels.size();
+        }
+
+        void clear();
+
+    private:
+        struct source {
+            base_objects::cubic_bounds_chunk_radius point;
+            uint8_t level;
+        };
+
+        struct area {
+            int64_t min_x;
+            int64_t min_z;
+            int64_t max_x;
+            int64_t max_z;
+
+            bool intersects(const area& other) const {
+                return min_x <= other.max_x && other.min_x <= max_x && min_z <= other.max_z && other.min_z <= max_z;
+            }
+        };
+
+        static area bounds_of(const source& src);
+        uint8_t seed_of(int64_t x, int64_t z) const;
+        //recomputes seeds in `changed` from every ticket which bounds overlaps it
+        void reseed(const area& changed);
+
+        std::unordered_map<size_t, source> sources;
+        chunk_map<uint8_t> seeds;  //lowest level of tickets which bounds contains chunk
+        chunk_map<uint8_t> levels;
+        std::vector<std::tuple<int64_t, int64_t, uint8_t>> changed_seeds; //x, z, seed before change
+    };
+}
+#endif /* SRC_STORAGE_LOADING_LEVELS */
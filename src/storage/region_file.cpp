@@ -0,0 +1,281 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <src/log.hpp>
+#include <src/storage/region_file.hpp>
+
+namespace copper_server::storage {
+    static void write_u32(uint8_t* out, uint32_t value) {
+        out[0] = uint8_t(value);
+        out[1] = uint8_t(value >> 8);
+        out[2] = uint8_t(value >> 16);
+        out[3] = uint8_t(value >> 24);
+    }
+
+    static uint32_t read_u32(const uint8_t* in) {
+        return uint32_t(in[0]) | (uint32_t(in[1]) << 8) | (uint32_t(in[2]) << 16) | (uint32_t(in[3]) << 24);
+    }
+
+    region_file::region_file(const std::filesystem::path& path)
+        : path(path) {
+        bool is_new = !std::filesystem::exists(path);
+        if (is_new)
+            std::filesystem::create_directories(path.parent_path());
+        file = std::make_unique<fast_task::files::async_iofstream>(
+            path,
+            fast_task::files::open_mode::read_write,
+            is_new ? fast_task::files::on_open_action::always_new : fast_task::files::on_open_action::open,
+            fast_task::files::_sync_flags{}
+        );
+        if (!file->is_open())
+            throw std::runtime_error("Can't open region file: " + path.string());
+        if (is_new) {
+            std::vector<char> empty(header_size, 0);
+            file->seekp(0);
+            file->write(empty.data(), empty.size());
+            file->flush();
+        }
+        load_header();
+    }
+
+    region_file::~region_file() {
+        if (file)
+            file->flush();
+    }
+
+    void region_file::load_header() {
+        std::array<uint8_t, header_size> raw{};
+        file->seekg(0);
+        file->read((char*)raw.data(), raw.size());
+        if (file->gcount() != std::streamsize(raw.size())) {
+            file->clear();
+            throw std::runtime_error("Region file header is corrupted: " + path.string());
+        }
+
+        uint64_t file_sectors = (std::filesystem::file_size(path) + sector_size - 1) / sector_size;
+        used_sectors.assign(std::max<uint64_t>(file_sectors, header_sectors), false);
+        mark(0, header_sectors, true);
+        for (size_t i = 0; i < chunks_count; i++) {
+            auto& it = header[i];
+            it.sector_offset = read_u32(raw.data() + i * 8);
+            it.length = read_u32(raw.data() + i * 8 + 4);
+            if (!it.length)
+                continue;
+            if (it.sector_offset < header_sectors || it.sector_offset + it.sectors() > used_sectors.size()) {
+                log::warn("storage:region_file", "Got corrupted chunk entry " + std::to_string(i) + " in " + path.string() + ", entry ignored");
+                it = {};
+                continue;
+            }
+            mark(it.sector_offset, it.sectors(), true);
+        }
+    }
+
+    void region_file::write_entry(size_t index) {
+        uint8_t raw[8];
+        write_u32(raw, header[index].sector_offset);
+        write_u32(raw + 4, header[index].length);
+        file->seekp(index * 8);
+        file->write((const char*)raw, 8);
+    }
+
+    void region_file::mark(uint32_t offset, uint32_t count, bool used) {
+        if (offset + count > used_sectors.size())
+            used_sectors.resize(offset + count, false);
+        for (uint32_t i = 0; i < count; i++)
+            used_sectors[offset + i] = used;
+    }
+
+    uint32_t region_file::allocate(uint32_t count) {
+        uint32_t run_begin = 0;
+        uint32_t run_length = 0;
+        for (uint32_t i = header_sectors; i < used_sectors.size(); i++) {
+            if (used_sectors[i]) {
+                run_length = 0;
+                continue;
+            }
+            if (!run_length)
+                run_begin = i;
+            if (++run_length == count)
+                return run_begin;
+        }
+        //extend file, reuse free tail if exists
+        return run_length ? run_begin : uint32_t(used_sectors.size());
+    }
+
+    bool region_file::contains(uint8_t local_x, uint8_t local_z) {
+        std::unique_lock lock(mutex);
+        return header[index_of(local_x, local_z)].length;
+    }
+
+    std::optional<std::string> region_file::read(uint8_t local_x, uint8_t local_z) {
+        std::unique_lock lock(mutex);
+        auto& it = header[index_of(local_x, local_z)];
+        if (!it.length)
+            return std::nullopt;
+        std::string res;
+        res.resize(it.length);
+        file->seekg(uint64_t(it.sector_offset) * sector_size);
+        file->read(res.data(), res.size());
+        if (file->gcount() != std::streamsize(res.size())) {
+            file->clear();
+            return std::nullopt;
+        }
+        return res;
+    }
+
+    bool region_file::write(uint8_t local_x, uint8_t local_z, std::string_view data) {
+        if (data.empty()) {
+            erase(local_x, local_z);
+            return true;
+        }
+        std::unique_lock lock(mutex);
+        size_t index = index_of(local_x, local_z);
+        auto& it = header[index];
+        uint32_t required = uint32_t((data.size() + sector_size - 1) / sector_size);
+        uint32_t offset;
+        if (it.length && required <= it.sectors()) {
+            //in-place rewrite, free unused tail
+            offset = it.sector_offset;
+            mark(offset + required, it.sectors() - required, false);
+        } else {
+            if (it.length)
+                mark(it.sector_offset, it.sectors(), false);
+            offset = allocate(required);
+        }
+        mark(offset, required, true);
+
+        file->seekp(uint64_t(offset) * sector_size);
+        file->write(data.data(), data.size());
+        if (size_t pad = size_t(required) * sector_size - data.size(); pad) {
+            static const std::array<char, sector_size> zeroes{};
+            file->write(zeroes.data(), pad);
+        }
+        //entry is updated only after payload is written
+        file->flush();
+        it.sector_offset = offset;
+        it.length = uint32_t(data.size());
+        write_entry(index);
+        file->flush();
+        return !file->fail();
+    }
+
+    void region_file::erase(uint8_t local_x, uint8_t local_z) {
+        std::unique_lock lock(mutex);
+        size_t index = index_of(local_x, local_z);
+        auto& it = header[index];
+        if (!it.length)
+            return;
+        mark(it.sector_offset, it.sectors(), false);
+        it = {};
+        write_entry(index);
+        file->flush();
+    }
+
+    size_t region_file::stored_chunks() {
+        std::unique_lock lock(mutex);
+        size_t count = 0;
+        for (auto& it : header)
+            count += it.length != 0;
+        return count;
+    }
+
+    region_storage::region_storage(const std::filesystem::path& path)
+        : path(path) {}
+
+    std::shared_ptr<region_file> region_storage::get_region(int64_t chunk_x, int64_t chunk_z, bool create) {
+        util::XY<int64_t> region_pos{chunk_x >> 5, chunk_z >> 5};
+        std::unique_lock lock(mutex);
+        if (auto it = regions.find(region_pos); it != regions.end())
+            if (it->second || !create)
+                return it->second;
+
+        auto region_path = path / ("r." + std::to_string(region_pos.x) + "." + std::to_string(region_pos.y) + ".region");
+        if (!create && !std::filesystem::exists(region_path))
+            return regions[region_pos] = nullptr;
+        return regions[region_pos] = std::make_shared<region_file>(region_path);
+    }
+
+    bool region_storage::exists(int64_t chunk_x, int64_t chunk_z) {
+        if (auto region = get_region(chunk_x, chunk_z, false); region)
+            return region->contains(uint8_t(chunk_x & 31), uint8_t(chunk_z & 31));
+        return false;
+    }
+
+    std::optional<std::string> region_storage::read(int64_t chunk_x, int64_t chunk_z) {
+        if (auto region = get_region(chunk_x, chunk_z, false); region)
+            return region->read(uint8_t(chunk_x & 31), uint8_t(chunk_z & 31));
+        return std::nullopt;
+    }
+
+    bool region_storage::write(int64_t chunk_x, int64_t chunk_z, std::string_view data) {
+        return get_region(chunk_x, chunk_z, true)->write(uint8_t(chunk_x & 31), uint8_t(chunk_z & 31), data);
+    }
+
+    void region_storage::erase(int64_t chunk_x, int64_t chunk_z) {
+        if (auto region = get_region(chunk_x, chunk_z, false); region)
+            region->erase(uint8_t(chunk_x & 31), uint8_t(chunk_z & 31));
+    }
+
+    size_t region_storage::convert_legacy(const std::filesystem::path& legacy_path) {
+        if (!std::filesystem::is_directory(legacy_path))
+            return 0;
+        size_t converted = 0;
+        std::vector<std::filesystem::directory_entry> x_entries(std::filesystem::directory_iterator{legacy_path}, std::filesystem::directory_iterator{});
+        for (auto& x_entry : x_entries) {
+            if (!x_entry.is_directory())
+                continue;
+            int64_t chunk_x;
+            try {
+                chunk_x = std::stoll(x_entry.path().filename().string());
+            } catch (const std::exception&) {
+                log::warn("storage:region_storage", "Got corrupted file path: " + x_entry.path().string());
+                continue;
+            }
+            //collect entries first, directory is modified while converting
+            std::vector<std::filesystem::directory_entry> z_entries(std::filesystem::directory_iterator{x_entry.path()}, std::filesystem::directory_iterator{});
+            for (auto& z_entry : z_entries) {
+                if (!z_entry.is_regular_file() || z_entry.path().extension() != ".dat")
+                    continue;
+                int64_t chunk_z;
+                try {
+                    chunk_z = std::stoll(z_entry.path().stem().string());
+                } catch (const std::exception&) {
+                    log::warn("storage:region_storage", "Got corrupted file path: " + z_entry.path().string());
+                    continue;
+                }
+                std::string data;
+                {
+                    fast_task::files::async_iofstream file(
+                        z_entry.path(),
+                        fast_task::files::open_mode::read,
+                        fast_task::files::on_open_action::open,
+                        fast_task::files::_sync_flags{}
+                    );
+                    if (!file.is_open())
+                        continue;
+                    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                }
+                if (!data.empty() && !write(chunk_x, chunk_z, data))
+                    continue;
+                std::filesystem::remove(z_entry.path());
+                ++converted;
+            }
+            if (std::filesystem::is_empty(x_entry.path()))
+                std::filesystem::remove(x_entry.path());
+        }
+        if (std::filesystem::is_empty(legacy_path))
+            std::filesystem::remove(legacy_path);
+        return converted;
+    }
+
+    void region_storage::close() {
+        std::unique_lock lock(mutex);
+        regions.clear();
+    }
+}
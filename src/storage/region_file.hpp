@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_STORAGE_REGION_FILE
+#define SRC_STORAGE_REGION_FILE
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <library/fast_task.hpp>
+#include <library/fast_task/include/files.hpp>
+#include <src/util/calculations.hpp>
+
+namespace copper_server::storage {
+    //stores 32x32 chunks in one file
+    //layout: [header: 1024 * {uint32 sector_offset, uint32 byte_length}][sectors...]
+    //chunk payload is the same bytes that was stored in legacy `chunks/<x>/<z>.dat` files
+    class region_file {
+    public:
+        static constexpr size_t chunks_per_side = 32;
+        static constexpr size_t chunks_count = chunks_per_side * chunks_per_side;
+        static constexpr size_t sector_size = 4096;
+        static constexpr size_t header_size = chunks_count * 8;
+        static constexpr size_t header_sectors = header_size / sector_size;
+
+        region_file(const std::filesystem::path& path);
+        ~region_file();
+
+        bool contains(uint8_t local_x, uint8_t local_z);
+        std::optional<std::string> read(uint8_t local_x, uint8_t local_z);
+        bool write(uint8_t local_x, uint8_t local_z, std::string_view data);
+        void erase(uint8_t local_x, uint8_t local_z);
+        size_t stored_chunks();
+
+    private:
+        struct entry {
+            uint32_t sector_offset = 0;
+            uint32_t length = 0; //in bytes, 0 == not present
+
+            uint32_t sectors() const {
+                return uint32_t((length + sector_size - 1) / sector_size);
+            }
+        };
+
+        static size_t index_of(uint8_t local_x, uint8_t local_z) {
+            return size_t(local_x & 31) | (size_t(local_z & 31) << 5);
+        }
+
+        void load_header();
+        void write_entry(size_t index);
+        void mark(uint32_t offset, uint32_t count, bool used);
+        uint32_t allocate(uint32_t count);
+
+        std::filesystem::path path;
+        std::array<entry, chunks_count> header;
+        std::vector<bool> used_sectors;
+        fast_task::task_mutex mutex;
+        std::unique_ptr<fast_task::files::async_iofstream> file;
+    };
+
+    //region index for one world, chunk coordinates are mapped to `r.<x>.<z>.region` files
+    class region_storage {
+    public:
+        region_storage(const std::filesystem::path& path);
+
+        bool exists(int64_t chunk_x, int64_t chunk_z);
+        std::optional<std::string> read(int64_t chunk_x, int64_t chunk_z);
+        bool write(int64_t chunk_x, int64_t chunk_z, std::string_view data);
+        void erase(int64_t chunk_x, int64_t chunk_z);
+
+        //moves legacy `<legacy_path>/<x>/<z>.dat` chunk files into region files, returns count of moved chunks
+        size_t convert_legacy(const std::filesystem::path& legacy_path);
+        //closes all opened region files
+        void close();
+
+        std::filesystem::path get_path() const {
+            return path;
+        }
+
+    private:
+        std::shared_ptr<region_file> get_region(int64_t chunk_x, int64_t chunk_z, bool create);
+
+        std::filesystem::path path;
+        fast_task::task_mutex mutex;
+        //nullptr == region file does not exists
+        std::unordered_map<util::XY<int64_t>, std::shared_ptr<region_file>> regions;
+    };
+}
+#endif /* SRC_STORAGE_REGION_FILE */
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <bit>
+#include <src/storage/tick_schedule.hpp>
+
+namespace copper_server::storage {
+    tick_schedule::tick_schedule(const tick_schedule& copy)
+        : wheel(copy.wheel ? std::make_unique<wheel_t>(*copy.wheel) : nullptr),
+          occupied(copy.occupied),
+          ready(copy.ready),
+          overflow(copy.overflow),
+          current(copy.current),
+          next_order(copy.next_order),
+          count(copy.count),
+          in_wheel(copy.in_wheel) {}
+
+    tick_schedule& tick_schedule::operator=(const tick_schedule& copy) {
+        if (this != &copy)
+            *this = tick_schedule(copy);
+        return *this;
+    }
+
+    void tick_schedule::schedule(uint64_t due, base_objects::chunk_block_pos pos, uint8_t priority) {
+        place(entry{due, pos, priority, next_order++});
+        ++count;
+    }
+
+    void tick_schedule::place(entry&& it) {
+        if (it.due <= current) {
+            ready.push_back(std::move(it));
+            return;
+        }
+        //level is selected by highest bit which differs from current tick, so slot index at that level is always ahead of current
+        unsigned level = unsigned(std::bit_width(it.due ^ current) - 1) / slot_bits;
+        if (level >= levels) {
+            overflow.push_back(std::move(it));
+            return;
+        }
+        if (!wheel)
+            wheel = std::make_unique<wheel_t>();
+        size_t slot = (it.due >> (level * slot_bits)) & slot_mask;
+        (*wheel)[level][slot].push_back(std::move(it));
+        occupied[level] |= uint64_t(1) << slot;
+        ++in_wheel;
+    }
+
+    void tick_schedule::move_to(uint64_t tick) {
+        bool crossed = (tick >> (levels * slot_bits)) != (current >> (levels * slot_bits));
+        current = tick;
+        //overflow ticks of reached range now fits into wheel
+        if (crossed && !overflow.empty()) {
+            std::vector<entry> moved;
+            moved.swap(overflow);
+            for (auto& it : moved)
+                place(std::move(it));
+        }
+    }
+
+    void tick_schedule::advance(uint64_t now) {
+        while (current < now) {
+            if (!in_wheel) {
+                if (overflow.empty()) {
+                    current = now;
+                    return;
+                }
+                uint64_t nearest = std::min_element(overflow.begin(), overflow.end(), [](auto& a, auto& b) { return a.due < b.due; })->due;
+                if (nearest > now) {
+                    move_to(now);
+                    return;
+                }
+                move_to(nearest - 1);
+                continue;
+            }
+
+            //nearest non empty slot, lower levels are always earlier than higher ones
+            uint64_t next = 0;
+            unsigned level = 0;
+            for (; level < levels; level++) {
+                unsigned shift = level * slot_bits;
+                uint64_t pos = (current >> shift) & slot_mask;
+                uint64_t ahead = pos == slot_mask ? 0 : occupied[level] & (~uint64_t(0) << (pos + 1));
+                if (ahead) {
+                    uint64_t block = current >> (shift + slot_bits) << (shift + slot_bits);
+                    next = block | (uint64_t(std::countr_zero(ahead)) << shift);
+                    break;
+                }
+            }
+            if (level == levels || next > now) {
+                move_to(now);
+                return;
+            }
+
+            move_to(next);
+            size_t slot = (next >> (level * slot_bits)) & slot_mask;
+            std::vector<entry> moved;
+            moved.swap((*wheel)[level][slot]);
+            occupied[level] &= ~(uint64_t(1) << slot);
+            in_wheel -= moved.size();
+            if (!level)
+                ready.insert(ready.end(), std::make_move_iterator(moved.begin()), std::make_move_iterator(moved.end()));
+            else
+                for (auto& it : moved)
+                    place(std::move(it));
+        }
+    }
+
+    void tick_schedule::sort_by_priority(std::vector<entry>& entries) {
+        std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) {
+            return a.priority != b.priority ? a.priority < b.priority : a.order < b.order;
+        });
+    }
+
+    void tick_schedule::clear() {
+        wheel = nullptr;
+        occupied = {};
+        ready.clear();
+        overflow.clear();
+        count = 0;
+        in_wheel = 0;
+    }
+}
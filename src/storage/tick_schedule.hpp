@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef SRC_STORAGE_TICK_SCHEDULE
+#define SRC_STORAGE_TICK_SCHEDULE
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <src/base_objects/block.hpp>
+
+namespace copper_server::storage {
+    //hierarchical timing wheel for scheduled block ticks
+    //4 levels of 64 slots covers 2^24 ticks ahead, farther ticks are kept in overflow list
+    //wheel is allocated only when first tick is scheduled
+    class tick_schedule {
+    public:
+        struct entry {
+            uint64_t due;
+            base_objects::chunk_block_pos pos;
+            uint8_t priority; //lower value == higher priority
+            uint64_t order;   //schedule order, keeps ticks with same due and priority in sequence
+        };
+
+        tick_schedule() = default;
+        tick_schedule(const tick_schedule& copy);
+        tick_schedule(tick_schedule&&) = default;
+        tick_schedule& operator=(const tick_schedule& copy);
+        tick_schedule& operator=(tick_schedule&&) = default;
+
+        //ticks scheduled in past or current tick are returned by next `pop_due`
+        void schedule(uint64_t due, base_objects::chunk_block_pos pos, uint8_t priority = 0);
+
+        //calls `func(const entry&)` for every tick due at `now` or earlier, by priority then in schedule order
+        //`func` may schedule new ticks, ticks due not later than `now` are returned by next call
+        template <class FN>
+        void pop_due(uint64_t now, FN&& func) {
+            if (!count)
+                return;
+            advance(now);
+            if (ready.empty())
+                return;
+            std::vector<entry> due;
+            due.swap(ready);
+            count -= due.size();
+            sort_by_priority(due);
+            for (auto& it : due)
+                func(it);
+        }
+
+        //calls `func(const entry&)` for every scheduled tick in unspecified order
+        template <class FN>
+        void for_each(FN&& func) const {
+            for (auto& it : ready)
+                func(it);
+            if (wheel)
+                for (auto& level : *wheel)
+                    for (auto& slot : level)
+                        for (auto& it : slot)
+                            func(it);
+            for (auto& it : overflow)
+                func(it);
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return !count;
+        }
+
+        void clear();
+
+    private:
+        static constexpr unsigned slot_bits = 6;
+        static constexpr uint64_t slot_mask = (uint64_t(1) << slot_bits) - 1;
+        static constexpr unsigned levels = 4;
+        using wheel_t = std::array<std::array<std::vector<entry>, size_t(1) << slot_bits>, levels>;
+
+        void place(entry&& it);
+        void move_to(uint64_t tick);
+        void advance(uint64_t now);
+        static void sort_by_priority(std::vector<entry>& entries);
+
+        std::unique_ptr<wheel_t> wheel;
+        std::array<uint64_t, levels> occupied{}; //bit per non empty slot
+        std::vector<entry> ready;
+        std::vector<entry> overflow;
+        uint64_t current = 0; //last processed tick, every entry in wheel is due later
+        uint64_t next_order = 0;
+        size_t count = 0;
+        size_t in_wheel = 0;
+    };
+}
+#endif /* SRC_STORAGE_TICK_SCHEDULE */
@@ -6,6 +6,9 @@
  * in the file LICENSE in the source distribution or at
  * http://www.apache.org/licenses/LICENSE-2.0
  */
+#include <algorithm>
+#include <map>
+
 #include <boost/iostreams/filter/zstd.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <library/enbt/io.hpp>
@@ -40,19 +43,6 @@ namespace enbt::io_helper {
         }
     };
 
-    template <>
-    struct serialization_simple_cast<light_data::light_item> {
-        static std::uint8_t write_cast(const light_data::light_item& value) {
-            return value.light_point;
-        }
-
-        static light_data::light_item read_cast(std::uint8_t value) {
-            light_data::light_item lit;
-            lit.light_point = value;
-            return lit;
-        }
-    };
-
     template <>
     struct serialization<height_maps> {
         static height_maps read(enbt::io_helper::value_read_stream& self) {
@@ -101,29 +91,27 @@ namespace enbt::io_helper {
             return light_data;
         }
 
+        //stored as byte per block to keep chunk file format
         static void read(light_data& light_data, enbt::io_helper::value_read_stream& self) {
-            serialization_read(light_data.light_map, self);
+            std::uint8_t light_map[16][16][16];
+            serialization_read(light_map, self);
+            light_data::packed_t packed{};
+            for (std::uint8_t x = 0; x < 16; x++)
+                for (std::uint8_t y = 0; y < 16; y++)
+                    for (std::uint8_t z = 0; z < 16; z++) {
+                        auto index = light_data::index_of(x, y, z);
+                        packed[index >> 1] |= std::uint8_t((light_map[x][y][z] & 0xF) << ((index & 1) << 2));
+                    }
+            light_data.assign(packed.data());
         }
 
         static void write(const light_data& light_data, enbt::io_helper::value_write_stream& write_stream) {
-            serialization_write(light_data.light_map, write_stream);
-        }
-    };
-
-    template <>
-    struct serialization<light_data::light_item> {
-        static light_data::light_item read(enbt::io_helper::value_read_stream& self) {
-            light_data::light_item light_item;
-            read(light_item, self);
-            return light_item;
-        }
-
-        static void read(light_data::light_item& light_data, enbt::io_helper::value_read_stream& self) {
-            light_data.light_point = self.read();
-        }
-
-        static void write(const light_data::light_item& light_data, enbt::io_helper::value_write_stream& write_stream) {
-            write_stream.write(light_data.light_point);
+            std::uint8_t light_map[16][16][16];
+            for (std::uint8_t x = 0; x < 16; x++)
+                for (std::uint8_t y = 0; y < 16; y++)
+                    for (std::uint8_t z = 0; z < 16; z++)
+                        light_map[x][y][z] = light_data.get(x, y, z);
+            serialization_write(light_map, write_stream);
         }
     };
 
@@ -203,21 +191,47 @@ namespace copper_server::storage {
     class world_data;
     class worlds_data;
 
-    bool chunk_data::load(const std::filesystem::path& path, uint64_t tick_counter, world_data& world) {
+    //dense form of section blocks, used to keep chunk file format same as before palette storage
+    struct dense_section_blocks {
+        base_objects::block blocks[16][16][16];
+
+        void load_from(const base_objects::world::block_storage& storage) {
+            storage.for_each([&](uint16_t index, base_objects::block_id_t id) {
+                blocks[index >> 8][(index >> 4) & 0xF][index & 0xF] = base_objects::block(id);
+            });
+        }
+
+        void store_to(base_objects::world::block_storage& storage) const {
+            std::vector<base_objects::block_id_t> values(base_objects::world::block_storage::entries_count);
+            for (uint8_t x = 0; x < 16; x++)
+                for (uint8_t y = 0; y < 16; y++)
+                    for (uint8_t z = 0; z < 16; z++) {
+                        auto& block = blocks[x][y][z];
+                        values[base_objects::world::block_storage::index_of(x, y, z)] = block.id;
+                    }
+            storage.assign(values.data());
+        }
+    };
+
+    //storage keeps only block ids, so block is ticked as copy and written back if tick changed it in place
+    //most ticks changes nothing, so section revision moved only when tick changed section
+    void tick_block(world_data& world, base_objects::world::sub_chunk_handle& handle, int64_t chunk_x, uint64_t sub_chunk_y, int64_t chunk_z, uint8_t local_x, uint8_t local_y, uint8_t local_z, bool random_ticked) {
+        auto tick_in = [&](sub_chunk_data& sub_chunk) {
+            auto tick = [&](base_objects::block& block) {
+                block.tick(world, sub_chunk, chunk_x, sub_chunk_y, chunk_z, local_x, local_y, local_z, random_ticked);
+            };
+            sub_chunk.get_block(local_x, local_y, local_z, tick, [&](base_objects::block& block, enbt::value&) { tick(block); });
+        };
+        //block entity data could be changed in place, which `update` does not detect
+        if (handle->get_block(local_x, local_y, local_z).is_block_entity())
+            tick_in(handle.edit());
+        else
+            handle.update(tick_in);
+    }
+
+    bool chunk_data::load(std::istream& file, uint64_t tick_counter, world_data& world) {
         if (api::configuration::get().server.world_debug_mode)
             return false;
-        if (!std::filesystem::exists(path))
-            return false;
-        if (std::filesystem::file_size(path) == 0)
-            return false;
-        fast_task::files::async_iofstream file(
-            path,
-            fast_task::files::open_mode::read,
-            fast_task::files::on_open_action::open,
-            fast_task::files::_sync_flags{}
-        );
-        if (!file.is_open())
-            return false;
         std::string mode = enbt::io_helper::read_token(file);
 
         boost::iostreams::filtering_istream filter;
@@ -244,18 +258,9 @@ namespace copper_server::storage {
                             bool need_recalculate_light_sky_light = true;
                             self.iterate([&](std::string_view name, enbt::io_helper::value_read_stream& self) {
                                 if (name == "blocks") {
-                                    enbt::io_helper::serialization_read(sub_chunk_data->blocks, self);
-                                    for (auto& x : sub_chunk_data->blocks) {
-                                        for (auto& y : x) {
-                                            for (auto& z : y)
-                                                if (bool is_tickable = sub_chunk_data->has_tickable_blocks |= z.is_tickable(); is_tickable)
-                                                    break;
-                                            if (sub_chunk_data->has_tickable_blocks)
-                                                break;
-                                        }
-                                        if (sub_chunk_data->has_tickable_blocks)
-                                            break;
-                                    }
+                                    auto dense = std::make_unique<dense_section_blocks>();
+                                    enbt::io_helper::serialization_read(dense->blocks, self);
+                                    dense->store_to(sub_chunk_data->blocks);
                                 } else if (name == "block_light") {
                                     try {
                                         enbt::io_helper::serialization_read(sub_chunk_data->block_light, self);
@@ -265,7 +270,7 @@ namespace copper_server::storage {
                                 } else if (name == "sky_light") {
                                     try {
                                         enbt::io_helper::serialization_read(sub_chunk_data->sky_light, self);
-                                        need_recalculate_light_block_light = false;
+                                        need_recalculate_light_sky_light = false;
                                     } catch (...) {
                                     }
                                 } else if (name == "entities") {
@@ -302,9 +307,7 @@ namespace copper_server::storage {
                                                     local_pos.z = self.read();
                                                     is_set.z_set = true;
                                                 } else if (name == "id") {
-                                                    sub_chunk_data->blocks[local_pos.x][local_pos.y][local_pos.z] = base_objects::block{
-                                                        (base_objects::block_id_t)self.read()
-                                                    };
+                                                    sub_chunk_data->blocks.set(local_pos.x, local_pos.y, local_pos.z, (base_objects::block_id_t)self.read());
                                                     is_set.id_set = true;
                                                 }
                                             });
@@ -317,20 +320,16 @@ namespace copper_server::storage {
                                     enbt::io_helper::serialization_read(sub_chunk_data->biomes, self);
                             });
                             sub_chunk_data->need_to_recalculate_light = need_recalculate_light_block_light || need_recalculate_light_sky_light;
-                            sub_chunks.push_back(std::move(*sub_chunk_data));
+                            sub_chunks.emplace_back(std::move(*sub_chunk_data));
                         }
                     );
                 } else if (name == "queried_for_tick") {
+                    uint8_t priority = 0;
                     self.iterate(
-                        [&](std::uint64_t len) {
-                            queried_for_tick.reserve(len);
-                        },
+                        [&](std::uint64_t) {},
                         [&](enbt::io_helper::value_read_stream& self) {
-                            list_array<std::pair<uint64_t, base_objects::chunk_block_pos>> queried_for_tick_tmp;
                             self.iterate(
-                                [&](std::uint64_t len) {
-                                    queried_for_tick_tmp.reserve(len);
-                                },
+                                [&](std::uint64_t) {},
                                 [&](enbt::io_helper::value_read_stream& self) {
                                     struct {
                                         bool x_set = false;
@@ -357,10 +356,10 @@ namespace copper_server::storage {
                                     });
                                     if (!is_set.x_set || !is_set.y_set || !is_set.z_set || !is_set.dur_set)
                                         throw std::runtime_error("Invalid queried_for_tick data");
-                                    queried_for_tick_tmp.push_back({tick_counter + duration, block_pos});
+                                    queried_for_tick.schedule(tick_counter + duration, block_pos, priority);
                                 }
                             );
-                            queried_for_tick.push_back(std::move(queried_for_tick_tmp));
+                            ++priority;
                         }
                     );
                 } else if (name == "height_maps") {
@@ -401,34 +400,41 @@ namespace copper_server::storage {
             return;
         }
 
+        base_objects::world::light_data::packed_t packed{};
         size_t x_ = 0;
         for (auto& x : chunk.as_array()) {
             size_t y_ = 0;
             for (auto& y : x.as_array()) {
                 size_t z_ = 0;
-                for (auto& z : y.as_ui8_array())
-                    data.light_map[x_][y_][z_++].light_point = z;
+                for (auto& z : y.as_ui8_array()) {
+                    auto index = base_objects::world::light_data::index_of(x_, y_, z_++);
+                    packed[index >> 1] |= uint8_t((z & 0xF) << ((index & 1) << 2));
+                }
                 ++y_;
             }
             ++x_;
         }
+        data.assign(packed.data());
     }
 
-    void load_block_data(const enbt::value& chunk, base_objects::block (&data)[16][16][16], bool& has_tickable_blocks) {
+    void load_block_data(const enbt::value& chunk, base_objects::world::block_storage& data) {
+        std::vector<base_objects::block_id_t> values(base_objects::world::block_storage::entries_count);
         size_t x_ = 0;
         for (auto& x : chunk.as_array()) {
             size_t y_ = 0;
             for (auto& y : x.as_array()) {
                 size_t z_ = 0;
                 for (auto z : y.as_ui32_array()) {
-                    data[x_][y_][z_].set_raw(z);
-                    has_tickable_blocks = data[x_][y_][z_].is_tickable();
+                    base_objects::block block;
+                    block.set_raw(z);
+                    values[base_objects::world::block_storage::index_of(x_, y_, z_)] = block.id;
                     ++z_;
                 }
                 ++y_;
             }
             ++x_;
         }
+        data.assign(values.data());
     }
 
     bool chunk_data::load(const enbt::compound_const_ref& chunk_data, uint64_t tick_counter, world_data& world) {
@@ -443,7 +449,7 @@ namespace copper_server::storage {
                 auto& blocks = sub_chunk["blocks"];
                 if (!valid_sub_chunk_size(blocks))
                     return false;
-                load_block_data(blocks, sub_chunk_data->blocks, sub_chunk_data->has_tickable_blocks);
+                load_block_data(blocks, sub_chunk_data->blocks);
             }
             if (sub_chunk.contains("entities")) {
                 for (auto& entity : sub_chunk["entities"].as_fixed_array()) {
@@ -458,9 +464,7 @@ namespace copper_server::storage {
                     local_pos.x = block_entity["x"];
                     local_pos.y = block_entity["y"];
                     local_pos.z = block_entity["z"];
-                    sub_chunk_data->blocks[local_pos.x][local_pos.y][local_pos.z] = base_objects::block{
-                        (base_objects::block_id_t)block_entity["id"]
-                    };
+                    sub_chunk_data->blocks.set(local_pos.x, local_pos.y, local_pos.z, (base_objects::block_id_t)block_entity["id"]);
                     sub_chunk_data->block_entities[local_pos.z | (local_pos.y << 4) | (local_pos.x << 8)] = nbt;
                 }
             }
@@ -468,22 +472,20 @@ namespace copper_server::storage {
                 load_light_data(sub_chunk["block_light"], sub_chunk_data->block_light, sub_chunk_data->need_to_recalculate_light);
             } else
                 sub_chunk_data->need_to_recalculate_light = true;
-            sub_chunks.push_back(std::move(*sub_chunk_data));
+            sub_chunks.emplace_back(std::move(*sub_chunk_data));
         }
 
         sub_chunks.resize(world.get_chunk_y_count());
         if (chunk_data.contains("queried_for_tick")) {
             auto queried_for_tick_ref = chunk_data["queried_for_tick"].as_fixed_array();
-            queried_for_tick.reserve(queried_for_tick_ref.size());
+            uint8_t priority = 0;
             for (auto& inner : queried_for_tick_ref) {
-                list_array<std::pair<uint64_t, base_objects::chunk_block_pos>> queried_for_tick_tmp;
-                queried_for_tick_tmp.reserve(inner.size());
                 for (auto& item : inner.as_array()) {
                     base_objects::chunk_block_pos block_pos{item.at("x"), item.at("y"), item.at("z")};
                     uint32_t duration = item.at("duration");
-                    queried_for_tick_tmp.push_back({duration + tick_counter, block_pos});
+                    queried_for_tick.schedule(duration + tick_counter, block_pos, priority);
                 }
-                queried_for_tick.push_back(queried_for_tick_tmp.take());
+                ++priority;
             }
         }
 
@@ -496,18 +498,9 @@ namespace copper_server::storage {
         return true;
     }
 
-    bool chunk_data::save(const std::filesystem::path& path, uint64_t tick_counter, world_data& _) {
+    bool chunk_data::save(std::ostream& file, uint64_t tick_counter, world_data& _) {
         if (api::configuration::get().server.world_debug_mode)
             return false;
-        std::filesystem::create_directories(path.parent_path());
-        fast_task::files::async_iofstream file(
-            path,
-            fast_task::files::open_mode::write,
-            fast_task::files::on_open_action::always_new,
-            fast_task::files::_sync_flags{}
-        );
-        if (!file.is_open())
-            return false;
         auto mode = api::configuration::get().world.saving_mode;
         enbt::io_helper::write_token(file, mode);
         boost::iostreams::filtering_ostream filter;
@@ -521,10 +514,13 @@ namespace copper_server::storage {
             auto comp
                 = stream.write_compound()
                       .write("sub_chunks", [&](enbt::io_helper::value_write_stream& stream) {
-                          stream.write_array(sub_chunks.size()).iterable(sub_chunks, [&](const storage::sub_chunk_data& sub_chunk, enbt::io_helper::value_write_stream& stream) {
+                          stream.write_array(sub_chunks.size()).iterable(sub_chunks, [&](const base_objects::world::sub_chunk_handle& sub_chunk_handle, enbt::io_helper::value_write_stream& stream) {
+                              auto& sub_chunk = *sub_chunk_handle;
                               auto compound = stream.write_compound();
                               compound.write("blocks", [&](enbt::io_helper::value_write_stream& stream) {
-                                  enbt::io_helper::serialization_write(sub_chunk.blocks, stream);
+                                  auto dense = std::make_unique<dense_section_blocks>();
+                                  dense->load_from(sub_chunk.blocks);
+                                  enbt::io_helper::serialization_write(dense->blocks, stream);
                               });
                               compound.write("block_entities", [&](enbt::io_helper::value_write_stream& stream) {
                                   stream.write_array(sub_chunk.block_entities.size()).iterable(sub_chunk.block_entities, [&](auto& item, enbt::io_helper::value_write_stream& stream) {
@@ -535,8 +531,9 @@ namespace copper_server::storage {
                                       pos.z = _pos & 0xF;
 
                                       auto compound = stream.write_compound();
-                                      compound.write("id", sub_chunk.blocks[pos.x][pos.y][pos.z].id);
-                                      compound.write("state", sub_chunk.blocks[pos.x][pos.y][pos.z].block_state_data);
+                                      auto block = sub_chunk.get_block(pos.x, pos.y, pos.z);
+                                      compound.write("id", block.id);
+                                      compound.write("state", block.block_state_data);
                                       compound.write("nbt", data);
                                       compound.write("x", pos.x);
                                       compound.write("y", pos.y);
@@ -548,10 +545,10 @@ namespace copper_server::storage {
                               });
                               if (!sub_chunk.need_to_recalculate_light) {
                                   compound.write("block_light", [&](enbt::io_helper::value_write_stream& stream) {
-                                      enbt::io_helper::serialization_write(sub_chunk.block_light.light_map, stream);
+                                      enbt::io_helper::serialization_write(sub_chunk.block_light, stream);
                                   });
                                   compound.write("sky_light", [&](enbt::io_helper::value_write_stream& stream) {
-                                      enbt::io_helper::serialization_write(sub_chunk.block_light.light_map, stream);
+                                      enbt::io_helper::serialization_write(sub_chunk.sky_light, stream);
                                   });
                               }
                               compound.write("entities", [&](enbt::io_helper::value_write_stream& stream) {
@@ -564,14 +561,20 @@ namespace copper_server::storage {
                           });
                       })
                       .write("queried_for_tick", [&](enbt::io_helper::value_write_stream& stream) {
-                          stream.write_array(queried_for_tick.size()).iterable(queried_for_tick, [&](auto& item, enbt::io_helper::value_write_stream& stream) {
+                          //saved grouped by priority, same as before timing wheel
+                          list_array<list_array<tick_schedule::entry>> by_priority;
+                          queried_for_tick.for_each([&](const tick_schedule::entry& it) {
+                              if (it.priority >= by_priority.size())
+                                  by_priority.resize(it.priority + 1);
+                              by_priority[it.priority].push_back(it);
+                          });
+                          stream.write_array(by_priority.size()).iterable(by_priority, [&](auto& item, enbt::io_helper::value_write_stream& stream) {
                               stream.write_array(item.size()).iterable(item, [&](auto& item, enbt::io_helper::value_write_stream& stream) {
-                                  auto& [till_tick, block_pos] = item;
                                   auto compound = stream.write_compound();
-                                  compound.write("x", block_pos.x);
-                                  compound.write("y", block_pos.y);
-                                  compound.write("z", block_pos.z);
-                                  compound.write("duration", till_tick - tick_counter);
+                                  compound.write("x", item.pos.x);
+                                  compound.write("y", item.pos.y);
+                                  compound.write("z", item.pos.z);
+                                  compound.write("duration", item.due > tick_counter ? item.due - tick_counter : 0);
                               });
                           });
                       })
@@ -587,12 +590,34 @@ namespace copper_server::storage {
 
         auto tmp = ss.str();
         filter.write(tmp.c_str(), tmp.size());
+        filter.reset();
         return true;
     }
 
+    chunk_packet_cache::encoded chunk_packet_cache::get(uint64_t key, const std::function<base_objects::network::response::item()>& build) const {
+        std::unique_lock lock(mutex);
+        if (!cached || cached_key != key) {
+            cached = std::make_shared<const base_objects::network::response::item>(build());
+            cached_key = key;
+        }
+        return cached;
+    }
+
+    void chunk_packet_cache::reset() {
+        std::unique_lock lock(mutex);
+        cached = nullptr;
+    }
+
     chunk_data::chunk_data(int64_t chunk_x, int64_t chunk_z)
         : chunk_x(chunk_x), chunk_z(chunk_z) {}
 
+    uint64_t chunk_data::revision() const {
+        uint64_t res = 0;
+        for (auto& section : sub_chunks)
+            res = std::max(res, section.revision());
+        return res;
+    }
+
     void chunk_data::update_height_map_on(uint8_t local_x, uint64_t local_y, uint8_t local_z) {
         uint64_t to_skip = local_y;
         uint64_t local_y_block = local_y * 16;
@@ -604,9 +629,9 @@ namespace copper_server::storage {
                 --to_skip;
                 continue;
             }
-            auto& schunk = *beg;
+            auto& schunk = **beg;
             for (int8_t y = 15; y >= 0; y--) {
-                auto block = schunk.blocks[local_x][y][local_z];
+                auto block = schunk.get_block(local_x, y, local_z);
                 if (!block.is_air()) {
                     auto y_pos = y + local_y_block;
 
@@ -636,11 +661,11 @@ namespace copper_server::storage {
         auto& leaves = api::tags::unfold_tag(api::tags::builtin_entry::block, "minecraft:block/leaves");
         auto end = sub_chunks.rend();
         for (auto beg = sub_chunks.rbegin(); beg != end; beg++) {
-            auto& schunk = *beg;
+            auto& schunk = **beg;
             for (uint8_t x = 0; x < 16; x++) {
                 for (int8_t y = 15; y >= 0; y--) {
                     for (uint8_t z = 0; z < 16; z++) {
-                        auto block = schunk.blocks[x][y][z];
+                        auto block = schunk.get_block(x, y, z);
                         if (!block.is_air()) {
                             auto y_pos = y + local_y_block;
 
@@ -666,140 +691,152 @@ namespace copper_server::storage {
         }
     }
 
-    void chunk_data::for_each_entity(std::function<void(base_objects::entity_ref& entity)> func) {
+    void chunk_data::for_each_entity(std::function<void(const base_objects::entity_ref& entity)> func) {
         for (auto& sub_chunk : sub_chunks)
-            for (auto& [id, entity] : sub_chunk.stored_entities)
+            for (auto& [id, entity] : sub_chunk->stored_entities)
                 func(entity);
     }
 
+    //shared sections never contains block entities, so they skipped without copying
+
     void chunk_data::for_each_block_entity(std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
         for (auto& sub_chunk : sub_chunks)
-            for (auto& [_pos, data] : sub_chunk.block_entities) {
-                base_objects::local_block_pos pos;
-                pos.x = _pos >> 8;
-                pos.y = (_pos >> 4) & 0xF;
-                pos.z = _pos & 0xF;
-                func(sub_chunk.blocks[pos.x][pos.y][pos.z], data);
-            }
+            if (!sub_chunk.is_shared())
+                sub_chunk.edit().for_each_block_entity([&](uint8_t, uint8_t, uint8_t, base_objects::block& block, enbt::value& data) {
+                    func(block, data);
+                });
     }
 
     void chunk_data::for_each_block_entity(uint64_t local_y, std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
-        if (local_y < sub_chunks.size())
-            for (auto& [_pos, data] : sub_chunks[local_y].block_entities) {
-                base_objects::local_block_pos pos;
-                pos.x = _pos >> 8;
-                pos.y = (_pos >> 4) & 0xF;
-                pos.z = _pos & 0xF;
-                func(sub_chunks[local_y].blocks[pos.x][pos.y][pos.z], data);
-            }
+        if (local_y < sub_chunks.size() && !sub_chunks[local_y].is_shared())
+            sub_chunks[local_y].edit().for_each_block_entity([&](uint8_t, uint8_t, uint8_t, base_objects::block& block, enbt::value& data) {
+                func(block, data);
+            });
     }
 
-    void chunk_data::for_each_entity(uint64_t sub_chunk_y, std::function<void(base_objects::entity_ref& entity)> func) {
+    void chunk_data::for_each_entity(uint64_t sub_chunk_y, std::function<void(const base_objects::entity_ref& entity)> func) {
         if (sub_chunk_y < sub_chunks.size())
-            for (auto& [id, entity] : sub_chunks[sub_chunk_y].stored_entities)
+            for (auto& [id, entity] : sub_chunks[sub_chunk_y]->stored_entities)
                 func(entity);
     }
 
+    //shared section is uniform, so it given as cheap copy which kept only when `func` changed it
+    //private section could get in place changes of block entity data, so its revision always moved
+    static void modify_sub_chunk(base_objects::world::sub_chunk_handle& sub_chunk, const std::function<void(sub_chunk_data& sub_chunk)>& func) {
+        if (sub_chunk.is_shared())
+            sub_chunk.update(func);
+        else
+            func(sub_chunk.edit());
+    }
+
     void chunk_data::for_each_sub_chunk(std::function<void(sub_chunk_data& sub_chunk)> func) {
         for (auto& sub_chunk : sub_chunks)
-            func(sub_chunk);
+            modify_sub_chunk(sub_chunk, func);
     }
 
     void chunk_data::get_sub_chunk(uint64_t sub_chunk_y, std::function<void(sub_chunk_data& sub_chunk)> func) {
         if (sub_chunk_y < sub_chunks.size())
-            func(sub_chunks[sub_chunk_y]);
+            modify_sub_chunk(sub_chunks[sub_chunk_y], func);
+    }
+
+    void chunk_data::view_sub_chunk(uint64_t sub_chunk_y, std::function<void(const sub_chunk_data& sub_chunk)> func) const {
+        if (sub_chunk_y < sub_chunks.size())
+            func(*sub_chunks[sub_chunk_y]);
+    }
+
+    void chunk_data::share_uniform_sections() {
+        for (auto& sub_chunk : sub_chunks)
+            sub_chunk.try_share();
     }
 
     void chunk_data::query_for_tick(uint8_t local_x, uint64_t global_y, uint8_t local_z, uint64_t on_tick, int8_t priority) {
         if (priority > 0)
             throw std::runtime_error("Priority must be negative");
-        uint8_t real_priority = +priority;
-        if (real_priority >= queried_for_tick.size())
-            queried_for_tick.resize(real_priority + 1);
-        queried_for_tick[real_priority].push_back({on_tick, base_objects::chunk_block_pos{local_x, uint8_t(global_y & 15), local_z}});
+        queried_for_tick.schedule(on_tick, base_objects::chunk_block_pos{local_x, uint32_t(global_y), local_z}, uint8_t(-priority));
     }
 
     void chunk_data::query_for_liquid_tick(uint8_t local_x, uint64_t global_y, uint8_t local_z, uint64_t on_tick) {
-        queried_for_liquid_tick.push_back({on_tick, base_objects::chunk_block_pos{local_x, uint8_t(global_y & 15), local_z}});
+        queried_for_liquid_tick.schedule(on_tick, base_objects::chunk_block_pos{local_x, uint32_t(global_y), local_z});
     }
 
-    void chunk_data::tick(world_data& world, size_t random_tick_speed, std::mt19937& random_engine, [[maybe_unused]] std::chrono::high_resolution_clock::time_point current_time) {
+    bool chunk_data::tick(world_data& world, size_t random_tick_speed, std::mt19937& random_engine, [[maybe_unused]] std::chrono::high_resolution_clock::time_point current_time, list_array<base_objects::entity_ref>& ticking_entities) {
         if (load_level > 32)
-            return;
-
-        for (auto& priority : queried_for_tick) {
-            for (
-                auto& [till, block_pos] :
-                priority.take([&world](auto& it) {
-                    return it.first >= world.tick_counter;
-                })
-            ) {
-                auto sub_chunk_y = convert_chunk_global_pos(block_pos.y);
-                auto local = convert_chunk_local_pos(block_pos.y);
-                auto& sub_chunk = sub_chunks.at(sub_chunk_y);
-
-                sub_chunk.blocks[block_pos.x][local][block_pos.z].tick(world, sub_chunk, chunk_x, sub_chunk_y, chunk_z, block_pos.x, (uint8_t)local, block_pos.z, false);
-            }
-        }
+            return false;
 
-        for (
-            auto& [till, block_pos] :
-            queried_for_liquid_tick.take([&world](auto& it) {
-                return it.first >= world.tick_counter;
-            })
-        ) {
-            auto sub_chunk_y = convert_chunk_global_pos(block_pos.y);
-            auto local = convert_chunk_local_pos(block_pos.y);
-            auto& sub_chunk = sub_chunks.at(sub_chunk_y);
+        auto tick_scheduled = [&](const tick_schedule::entry& it) {
+            auto sub_chunk_y = convert_chunk_global_pos(it.pos.y);
+            auto local = convert_chunk_local_pos(it.pos.y);
 
-            sub_chunk.blocks[block_pos.x][local][block_pos.z].tick(world, sub_chunk, chunk_x, sub_chunk_y, chunk_z, block_pos.x, (uint8_t)local, block_pos.z, false);
-        }
+            tick_block(world, sub_chunks.at(sub_chunk_y), chunk_x, sub_chunk_y, chunk_z, it.pos.x, (uint8_t)local, it.pos.z, false);
+        };
+        queried_for_tick.pop_due(world.tick_counter, tick_scheduled);
+        queried_for_liquid_tick.pop_due(world.tick_counter, tick_scheduled);
 
+        bool has_work = false;
         uint64_t sub_chunk_y = 0;
         for (auto& sub_chunk : sub_chunks) {
-            if (load_level <= 31)
-                for (auto& [id, entity] : sub_chunk.stored_entities)
-                    entity->tick();
-
-
-            auto max_random_tick_per_sub_chunk = random_tick_speed;
-            while (sub_chunk.has_tickable_blocks && max_random_tick_per_sub_chunk) {
-                union {
-                    struct {
-                        uint8_t x;
-                        uint8_t y;
-                        uint8_t z;
-                    } dec;
-
-                    uint32_t value;
-                } pos;
-
-                pos.value = random_engine();
-                if (sub_chunk.blocks[pos.dec.x][pos.dec.y][pos.dec.z].tickable != base_objects::block::tick_opt::no_tick)
-                    sub_chunk.blocks[pos.dec.x][pos.dec.y][pos.dec.z].tick(world, sub_chunk, chunk_x, sub_chunk_y, chunk_z, pos.dec.x, pos.dec.y, pos.dec.z, true);
-                --max_random_tick_per_sub_chunk;
+            if (load_level <= 31 && !sub_chunk->stored_entities.empty()) {
+                has_work = true;
+                for (auto& [id, entity] : sub_chunk->stored_entities)
+                    ticking_entities.push_back(entity);
+            }
+
+            if (sub_chunk->blocks.tickable_count()) {
+                has_work = true;
+                auto max_random_tick_per_sub_chunk = random_tick_speed;
+                while (max_random_tick_per_sub_chunk) {
+                    union {
+                        struct {
+                            uint8_t x;
+                            uint8_t y;
+                            uint8_t z;
+                        } dec;
+
+                        uint32_t value;
+                    } pos;
+
+                    pos.value = random_engine();
+                    pos.dec.x &= 15;
+                    pos.dec.y &= 15;
+                    pos.dec.z &= 15;
+                    if (sub_chunk->get_block(pos.dec.x, pos.dec.y, pos.dec.z).is_tickable())
+                        tick_block(world, sub_chunk, chunk_x, sub_chunk_y, chunk_z, pos.dec.x, pos.dec.y, pos.dec.z, true);
+                    --max_random_tick_per_sub_chunk;
+                }
             }
             sub_chunk_y++;
         }
+        return has_work || !queried_for_tick.empty() || !queried_for_liquid_tick.empty();
+    }
+
+    bool chunk_data::has_tick_work() const {
+        if (!queried_for_tick.empty() || !queried_for_liquid_tick.empty())
+            return true;
+        for (auto& sub_chunk : sub_chunks)
+            if (sub_chunk->blocks.tickable_count() || (load_level <= 31 && !sub_chunk->stored_entities.empty()))
+                return true;
+        return false;
     }
 
     //generator functions
     void chunk_data::gen_set_block(const base_objects::full_block_data& block, uint8_t local_x, uint64_t local_y, uint8_t local_z) {
-        sub_chunks.at(local_y >> 4).set_block(local_x, local_y & 15, local_z, block);
+        sub_chunks.at(local_y >> 4).edit().set_block(local_x, local_y & 15, local_z, block);
     }
 
     void chunk_data::gen_set_block(base_objects::full_block_data&& block, uint8_t local_x, uint64_t local_y, uint8_t local_z) {
-        sub_chunks.at(local_y >> 4).set_block(local_x, local_y & 15, local_z, std::move(block));
+        sub_chunks.at(local_y >> 4).edit().set_block(local_x, local_y & 15, local_z, std::move(block));
     }
 
     void chunk_data::gen_remove_block(uint8_t local_x, uint64_t local_y, uint8_t local_z) {
-        sub_chunks.at(local_y >> 4).set_block(local_x, local_y & 15, local_z, base_objects::block());
+        sub_chunks.at(local_y >> 4).edit().set_block(local_x, local_y & 15, local_z, base_objects::block());
     }
 
-    base_objects::full_block_data_ref chunk_data::gen_get_block(uint8_t local_x, uint64_t local_y, uint8_t local_z) {
-        std::optional<base_objects::full_block_data_ref> res;
-        sub_chunks.at(local_y >> 4).get_block(local_x, local_y & 15, local_z, [&res](auto& block) { res = block; }, [&res](auto& block, auto& enbt) { res.emplace(base_objects::block_entity_ref(block, enbt)); });
-        return *res;
+    base_objects::full_block_data chunk_data::gen_get_block(uint8_t local_x, uint64_t local_y, uint8_t local_z) const {
+        auto& sub_chunk = *sub_chunks.at(local_y >> 4);
+        auto block = sub_chunk.get_block(local_x, local_y & 15, local_z);
+        if (auto it = sub_chunk.block_entities.find(base_objects::world::block_storage::index_of(local_x, local_y & 15, local_z)); it != sub_chunk.block_entities.end())
+            return base_objects::block_entity{block, it->second};
+        return block;
     }
 
     fast_task::protected_value<std::unordered_map<std::string, base_objects::atomic_holder<chunk_generator>>> chunk_generators;
@@ -842,28 +879,75 @@ namespace copper_server::storage {
         });
     }
 
+    size_t world_data::shard_index(int64_t chunk_x, int64_t chunk_z) {
+        uint64_t region_x = uint64_t(chunk_x >> chunk_shard_region_shift);
+        uint64_t region_z = uint64_t(chunk_z >> chunk_shard_region_shift);
+        //high bits of product are well mixed, low bits depends only from low bits of region position
+        uint64_t hash = (region_x * 0x9E3779B97F4A7C15ull) ^ (region_z * 0xC2B2AE3D27D4EB4Full);
+        return size_t(hash >> 32) % chunk_shards_count;
+    }
+
+    std::optional<base_objects::atomic_holder<chunk_data>> world_data::find_chunk(int64_t chunk_x, int64_t chunk_z) {
+        auto& shard = shard_of(chunk_x, chunk_z);
+        std::unique_lock lock(shard.mutex);
+        if (auto chunk = shard.chunks.find(chunk_x, chunk_z); chunk)
+            return *chunk;
+        return std::nullopt;
+    }
+
+    void world_data::store_chunk(int64_t chunk_x, int64_t chunk_z, const base_objects::atomic_holder<chunk_data>& chunk) {
+        auto& shard = shard_of(chunk_x, chunk_z);
+        std::unique_lock lock(shard.mutex);
+        shard.chunks(chunk_x, chunk_z) = chunk;
+        shard.active(chunk_x, chunk_z) = true;
+    }
+
+    bool world_data::remove_chunk(int64_t chunk_x, int64_t chunk_z) {
+        ticking_chunks.erase(chunk_x, chunk_z);
+        if (ticket_levels.level_of(chunk_x, chunk_z) <= 33)
+            pending_ticket_loads(chunk_x, chunk_z) = true;
+        auto& shard = shard_of(chunk_x, chunk_z);
+        std::unique_lock lock(shard.mutex);
+        shard.active.erase(chunk_x, chunk_z);
+        return shard.chunks.erase(chunk_x, chunk_z);
+    }
+
+    void world_data::mark_active(int64_t chunk_x, int64_t chunk_z) {
+        auto& shard = shard_of(chunk_x, chunk_z);
+        std::unique_lock lock(shard.mutex);
+        if (shard.chunks.contains(chunk_x, chunk_z))
+            shard.active(chunk_x, chunk_z) = true;
+    }
+
     void world_data::make_save(int64_t chunk_x, int64_t chunk_z, bool also_unload) {
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto y_axis = x_axis->second.find(chunk_z); y_axis != x_axis->second.end())
-                make_save(chunk_x, chunk_z, y_axis, also_unload);
+        if (auto chunk = find_chunk(chunk_x, chunk_z); chunk)
+            make_save(chunk_x, chunk_z, *chunk, also_unload);
     }
 
-    void world_data::make_save(int64_t chunk_x, int64_t chunk_z, chunk_row::iterator item, bool also_unload) {
+    void world_data::make_save(int64_t chunk_x, int64_t chunk_z, const base_objects::atomic_holder<chunk_data>& chunk, bool also_unload) {
         if (auto process = on_save_process.find({chunk_x, chunk_z}); process == on_save_process.end()) {
-            auto& chunk = item->second;
             on_save_process[{chunk_x, chunk_z}] = Future<bool>::start(
                 [this, chunk, chunk_x, chunk_z, also_unload] {
                     try {
-                        if (chunk)
-                            chunk->save(path / "chunks" / std::to_string(chunk_x) / (std::to_string(chunk_z) + ".dat"), tick_counter, *this);
+                        if (chunk) {
+                            std::stringstream ss;
+                            bool saved;
+                            {
+                                std::unique_lock shard_lock(shard_of(chunk_x, chunk_z).mutex);
+                                //sections could become uniform again after edits, content stays same so revision is kept
+                                chunk->share_uniform_sections();
+                                saved = chunk->save(ss, tick_counter, *this);
+                            }
+                            if (saved)
+                                regions.write(chunk_x, chunk_z, ss.view());
+                        }
                     } catch (...) {
                         return false;
                     }
                     std::unique_lock lock(mutex);
                     on_save_process.erase({chunk_x, chunk_z});
                     if (also_unload) {
-                        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end()) {
-                            x_axis->second.erase(chunk_z);
+                        if (remove_chunk(chunk_x, chunk_z)) {
                             if (profiling.enable_world_profiling) {
                                 if (profiling.chunk_total_loaded)
                                     --profiling.chunk_total_loaded;
@@ -933,7 +1017,12 @@ namespace copper_server::storage {
     base_objects::atomic_holder<chunk_data> world_data::load_chunk_sync(int64_t chunk_x, int64_t chunk_z) {
         try {
             auto chunk = base_objects::atomic_holder<chunk_data>(new chunk_data(chunk_x, chunk_z));
-            if (!chunk->load(path / "chunks" / std::to_string(chunk_x) / (std::to_string(chunk_z) + ".dat"), tick_counter, *this)) {
+            bool loaded = false;
+            if (auto data = regions.read(chunk_x, chunk_z); data) {
+                std::stringstream ss(std::move(*data));
+                loaded = chunk->load(ss, tick_counter, *this);
+            }
+            if (!loaded) {
                 if (!chunk->load(get_generator()->generate_chunk(*this, chunk_x, chunk_z), tick_counter, *this))
                     return nullptr;
             }
@@ -941,7 +1030,7 @@ namespace copper_server::storage {
                 chunk->load_level = 31;
                 std::unique_lock lock(mutex);
                 if (auto process = on_generate_process.find({chunk_x, chunk_z}); process == on_generate_process.end()) {
-                    chunks[chunk_x][chunk_z] = chunk;
+                    store_chunk(chunk_x, chunk_z, chunk);
                     auto it = on_generate_process[{chunk_x, chunk_z}] = create_chunk_generate_future(chunk);
                     it->wait_with(lock);
                     on_generate_process.erase({chunk_x, chunk_z});
@@ -959,13 +1048,14 @@ namespace copper_server::storage {
                 bool done_process = false;
                 for (auto beg = chunk->sub_chunks.rbegin(); beg != end; beg++) {
                     --y;
-                    if (beg->need_to_recalculate_light || done_process) {
+                    if ((*beg)->need_to_recalculate_light || done_process) {
                         light_processor->process_sub_chunk(*this, chunk_x, y, chunk_z);
                         done_process = true;
                     }
                 }
                 chunk->update_height_map();
             }
+            chunk->share_uniform_sections();
             return chunk;
         } catch (...) {
             return nullptr;
@@ -982,377 +1072,453 @@ namespace copper_server::storage {
 
     base_objects::atomic_holder<chunk_light_processor>& world_data::get_light_processor() {
         if (!light_processor) {
-            light_processor = chunk_light_processor::get_it(light_processor_id);
-            enable_entity_light_source_updates = light_processor->enable_entity_light_source_updates;
-            enable_entity_light_source_updates_include_rot = light_processor->enable_entity_light_source_updates_include_rot;
+            //leaf lock, can be called from any lock level
+            std::unique_lock lock(light_processor_mutex);
+            if (!light_processor) {
+                light_processor = chunk_light_processor::get_it(light_processor_id);
+                enable_entity_light_source_updates = light_processor->enable_entity_light_source_updates;
+                enable_entity_light_source_updates_include_rot = light_processor->enable_entity_light_source_updates_include_rot;
+            }
         }
         return light_processor;
     }
 
     template <auto fun, class... Args>
-    inline void entity_notify_block(auto& entities, auto& self, auto x, auto y, auto z, Args&&... args) {
-        auto chunk_x = convert_chunk_global_pos(x);
-        auto chunk_z = convert_chunk_global_pos(z);
-        for (auto& [id, entity] : entities) {
-            if (&*entity != &self) {
-                auto processor = entity->const_data().processor;
-                if (entity->world_syncing_data && processor)
-                    if (entity->world_syncing_data->processing_region.in_bounds(chunk_x, chunk_z))
-                        ((*processor).*fun)(*entity, self, x, y, z, std::forward<Args>(args)...);
-            }
-        }
+    inline void entity_notify_block(const list_array<base_objects::entity*>& viewers, auto& self, auto x, auto y, auto z, Args&&... args) {
+        for (auto entity : viewers)
+            if (entity != &self)
+                ((*entity->const_data().processor).*fun)(*entity, self, x, y, z, std::forward<Args>(args)...);
     }
 
     template <auto fun, class... Args>
-    inline void entity_notify_change(auto& entities, auto& self, Args&&... args) {
-        auto chunk_x = convert_chunk_global_pos(self.position.x);
-        auto chunk_z = convert_chunk_global_pos(self.position.z);
-        for (auto& [id, entity] : entities) {
-            if (&*entity != &self) {
-                auto processor = entity->const_data().processor;
-                if (entity->world_syncing_data && processor)
-                    if (entity->world_syncing_data->processing_region.in_bounds((int64_t)chunk_x, (int64_t)chunk_z))
-                        ((*processor).*fun)(*entity, self, std::forward<Args>(args)...);
-            }
-        }
+    inline void entity_notify_change(const list_array<base_objects::entity*>& viewers, auto& self, Args&&... args) {
+        for (auto entity : viewers)
+            if (entity != &self)
+                ((*entity->const_data().processor).*fun)(*entity, self, std::forward<Args>(args)...);
     }
 
     template <auto fun, class... Args>
-    inline void entity_notify_change_all(auto& entities, auto& self, Args&&... args) {
-        auto chunk_x = convert_chunk_global_pos(self.position.x);
-        auto chunk_z = convert_chunk_global_pos(self.position.z);
-        for (auto& [id, entity] : entities) {
-            auto processor = entity->const_data().processor;
-            if (entity->world_syncing_data && processor)
-                if (entity->world_syncing_data->processing_region.in_bounds((int64_t)chunk_x, (int64_t)chunk_z))
-                    ((*processor).*fun)(*entity, self, std::forward<Args>(args)...);
-        }
+    inline void entity_notify_change_all(const list_array<base_objects::entity*>& viewers, auto& self, Args&&... args) {
+        for (auto entity : viewers)
+            ((*entity->const_data().processor).*fun)(*entity, self, std::forward<Args>(args)...);
     }
 
     template <auto fun, class... Args>
-    void entity_notify_change_w_e(auto& entities, auto& self, auto other_entity_id, Args&&... args) {
+    void entity_notify_change_w_e(const list_array<base_objects::entity*>& viewers, auto& entities, auto& self, auto other_entity_id, Args&&... args) {
         auto other_entity_it = entities.find(other_entity_id);
         if (other_entity_it == entities.end())
             throw std::runtime_error("Entity not registered on world");
-        auto chunk_x = convert_chunk_global_pos(self.position.x);
-        auto chunk_z = convert_chunk_global_pos(self.position.z);
         auto& other_entity = other_entity_it->second;
-        for (auto& [id, entity] : entities) {
-            auto processor = entity->const_data().processor;
-            if (entity->world_syncing_data && processor)
-                if (entity->world_syncing_data->processing_region.in_bounds((int64_t)chunk_x, (int64_t)chunk_z))
-                    ((*processor).*fun)(*entity, self, other_entity, std::forward<Args>(args)...);
-        }
+        for (auto entity : viewers)
+            ((*entity->const_data().processor).*fun)(*entity, self, other_entity, std::forward<Args>(args)...);
     }
 
     template <auto fun, class... Args>
-    void world_notify(auto& entities, auto x, auto z, Args&&... args) {
-        auto chunk_x = convert_chunk_global_pos(x);
-        auto chunk_z = convert_chunk_global_pos(z);
-        for (auto& [id, entity] : entities) {
-            auto processor = entity->const_data().processor;
-            if (entity->world_syncing_data && processor) {
-                if (entity->world_syncing_data->processing_region.in_bounds(chunk_x, chunk_z))
-                    ((*processor).*fun)(*entity, std::forward<Args>(args)...);
-            }
-        }
+    void world_notify(const list_array<base_objects::entity*>& viewers, Args&&... args) {
+        for (auto entity : viewers)
+            ((*entity->const_data().processor).*fun)(*entity, std::forward<Args>(args)...);
     }
 
 #define WORLD_ASYNC_RUN(function, ...) \
     fast_task::task::run([=, this] { api::world::get(world_id, [&](auto& world) { world.function(__VA_ARGS__); }); })
 
+    list_array<base_objects::entity*> world_data::viewers_of(int64_t chunk_x, int64_t chunk_z) {
+        list_array<base_objects::entity*> res;
+        std::unique_lock lock(entity_index_mutex);
+        entities_index.for_each_viewer(chunk_x, chunk_z, [&](const entity_index::item& it) {
+            auto& syncing = it.entity->world_syncing_data;
+            if (syncing && it.entity->const_data().processor)
+                if (syncing->processing_region.in_bounds(chunk_x, chunk_z))
+                    res.push_back(it.entity);
+        });
+        return res;
+    }
+
+    list_array<base_objects::entity*> world_data::viewers_of(const base_objects::entity& self) {
+        return viewers_of((int64_t)convert_chunk_global_pos(self.position.x), (int64_t)convert_chunk_global_pos(self.position.z));
+    }
+
+    list_array<base_objects::entity*> world_data::viewers_of_block(int64_t x, int64_t z) {
+        return viewers_of(convert_chunk_global_pos(x), convert_chunk_global_pos(z));
+    }
+
+    void world_data::index_entity(base_objects::entity& entity, util::VECTOR position) {
+        std::unique_lock lock(entity_index_mutex);
+        entities_index.update(
+            entity.world_syncing_data->assigned_world_id,
+            &entity,
+            entity.world_syncing_data->processing_region,
+            (int64_t)convert_chunk_global_pos(position.x),
+            (int64_t)convert_chunk_global_pos(position.z)
+        );
+    }
+
+    void world_data::collect_entities(int64_t chunk_x, int64_t chunk_z, list_array<base_objects::entity_ref>& res) {
+        std::unique_lock lock(entity_index_mutex);
+        entities_index.for_each_occupant(chunk_x, chunk_z, [&](const entity_index::item& it) {
+            if (auto entity = entities.find(it.id); entity != entities.end())
+                res.push_back(entity->second);
+        });
+    }
+
     void world_data::entity_init(base_objects::entity& self) {
-        std::unique_lock lock(mutex);
-        auto chunk_x = convert_chunk_global_pos(self.position.x);
-        auto chunk_z = convert_chunk_global_pos(self.position.z);
-        for (auto& [id, entity] : entities) {
-            auto processor = entity->const_data().processor;
-            if (entity->world_syncing_data && processor) {
-                if (entity->world_syncing_data->processing_region.in_bounds((int64_t)chunk_x, (int64_t)chunk_z))
-                    processor->entity_init(*entity, self);
-            }
-        }
+        fast_task::read_lock lock(entities_mutex);
+        viewers_of(self).for_each([&](base_objects::entity* entity) {
+            entity->const_data().processor->entity_init(*entity, self);
+        });
     }
 
     using ew_processor = base_objects::entity_data::world_processor;
 
+    void world_data::track_entity(base_objects::entity& entity, uint8_t changes) {
+        if (!entity.world_syncing_data)
+            return;
+        std::unique_lock lock(entity_tracker_mutex);
+        entities_tracker.mark(entity.world_syncing_data->assigned_world_id, changes);
+    }
+
+    void world_data::flush_entity_tracker() {
+        fast_task::read_lock lock(entities_mutex);
+        std::vector<entity_tracker::update> updates;
+        {
+            std::unique_lock tracker_lock(entity_tracker_mutex);
+            entities_tracker.flush(tick_counter, updates);
+        }
+        for (auto& update : updates) {
+            auto& self = *update.entity;
+            int64_t chunk_x = convert_chunk_global_pos(self.position.x);
+            int64_t chunk_z = convert_chunk_global_pos(self.position.z);
+            int64_t track_distance = self.const_data().max_track_distance;
+            std::vector<uint64_t> known;
+            known.swap(update.viewers);
+            viewers_of(chunk_x, chunk_z).for_each([&](base_objects::entity* viewer) {
+                if (viewer == &self)
+                    return;
+                if (track_distance > 0) {
+                    int64_t viewer_x = convert_chunk_global_pos(viewer->position.x);
+                    int64_t viewer_z = convert_chunk_global_pos(viewer->position.z);
+                    if (std::abs(viewer_x - chunk_x) > track_distance || std::abs(viewer_z - chunk_z) > track_distance)
+                        return;
+                }
+                uint64_t viewer_id = viewer->world_syncing_data->assigned_world_id;
+                update.viewers.push_back(viewer_id);
+                auto& proc = *viewer->const_data().processor;
+                //viewer which did not track entity can not apply relative changes, so it gets full position sync
+                bool is_new = !std::binary_search(known.begin(), known.end(), viewer_id);
+                if (is_new || (update.changes & entity_tracker::teleport)) {
+                    proc.entity_teleport(*viewer, self, self.position);
+                    if (is_new || (update.changes & entity_tracker::head_rotation))
+                        proc.entity_look_changes(*viewer, self, self.head_rotation);
+                    return;
+                }
+                bool moved = update.changes & entity_tracker::position;
+                bool rotated = update.changes & entity_tracker::rotation;
+                if (moved && rotated && proc.entity_move_rotate)
+                    proc.entity_move_rotate(*viewer, self, update.move, self.rotation);
+                else {
+                    if (moved)
+                        proc.entity_move(*viewer, self, update.move);
+                    if (rotated)
+                        proc.entity_rotation_changes(*viewer, self, self.rotation);
+                }
+                if (update.changes & entity_tracker::head_rotation)
+                    proc.entity_look_changes(*viewer, self, self.head_rotation);
+                if (update.changes & entity_tracker::motion)
+                    proc.entity_motion_changes(*viewer, self, self.motion);
+            });
+            std::sort(update.viewers.begin(), update.viewers.end());
+        }
+        std::unique_lock tracker_lock(entity_tracker_mutex);
+        for (auto& update : updates)
+            entities_tracker.set_viewers(update.id, std::move(update.viewers));
+    }
+
+    //movement notifications are accumulated and sent by `flush_entity_tracker`, light sources are updated immediately
     void world_data::entity_teleport(base_objects::entity& self, util::VECTOR new_pos) {
-        std::unique_lock lock(mutex);
-        entity_notify_change<&ew_processor::entity_teleport>(entities, self, new_pos);
+        fast_task::read_lock lock(entities_mutex);
+        track_entity(self, entity_tracker::teleport);
+        if (self.world_syncing_data)
+            index_entity(self, new_pos);
         if (enable_entity_light_source_updates)
             get_light_processor()->process_entity_light_source(*this, self, new_pos);
     }
 
     void world_data::entity_move(base_objects::entity& self, util::VECTOR move) {
-        std::unique_lock lock(mutex);
-        entity_notify_change<&ew_processor::entity_move>(entities, self, move);
+        fast_task::read_lock lock(entities_mutex);
+        track_entity(self, entity_tracker::position);
         if (enable_entity_light_source_updates)
             get_light_processor()->process_entity_light_source(*this, self, move);
     }
 
     void world_data::entity_look_changes(base_objects::entity& self, util::ANGLE_DEG new_rotation) {
-        std::unique_lock lock(mutex);
-        entity_notify_change<&ew_processor::entity_look_changes>(entities, self, new_rotation);
+        fast_task::read_lock lock(entities_mutex);
+        track_entity(self, entity_tracker::head_rotation);
         if (enable_entity_light_source_updates_include_rot)
             get_light_processor()->process_entity_light_source_rot(*this, self, new_rotation);
     }
 
-    void world_data::entity_rotation_changes(base_objects::entity& self, util::ANGLE_DEG new_rotation) {
-        std::unique_lock lock(mutex);
-        entity_notify_change<&ew_processor::entity_rotation_changes>(entities, self, new_rotation);
+    void world_data::entity_rotation_changes(base_objects::entity& self, [[maybe_unused]] util::ANGLE_DEG new_rotation) {
+        fast_task::read_lock lock(entities_mutex);
+        track_entity(self, entity_tracker::rotation);
     }
 
-    void world_data::entity_motion_changes(base_objects::entity& self, util::VECTOR new_motion) {
-        std::unique_lock lock(mutex);
-        entity_notify_change<&ew_processor::entity_motion_changes>(entities, self, new_motion);
+    void world_data::entity_motion_changes(base_objects::entity& self, [[maybe_unused]] util::VECTOR new_motion) {
+        fast_task::read_lock lock(entities_mutex);
+        track_entity(self, entity_tracker::motion);
     }
 
     void world_data::entity_rides(base_objects::entity& self, size_t other_entity_id) {
-        std::unique_lock lock(mutex);
+        fast_task::write_lock lock(entities_mutex);
         entities.at(other_entity_id)->ride_by_entity.push_back(entities.at(self.world_syncing_data->assigned_world_id));
-        entity_notify_change_w_e<&ew_processor::entity_rides>(entities, self, other_entity_id);
+        entity_notify_change_w_e<&ew_processor::entity_rides>(viewers_of(self), entities, self, other_entity_id);
     }
 
     void world_data::entity_leaves_ride(base_objects::entity& self, size_t other_entity_id) {
-        std::unique_lock lock(mutex);
+        fast_task::write_lock lock(entities_mutex);
         entities.at(other_entity_id)->ride_by_entity.remove_if([&self](auto& it) {
             return &*it == &self;
         });
-        entity_notify_change_w_e<&ew_processor::entity_leaves_ride>(entities, self, other_entity_id);
+        entity_notify_change_w_e<&ew_processor::entity_leaves_ride>(viewers_of(self), entities, self, other_entity_id);
     }
 
     void world_data::entity_attach(base_objects::entity& self, size_t other_entity_id) {
-        std::unique_lock lock(mutex);
-        entity_notify_change_w_e<&ew_processor::entity_attach>(entities, self, other_entity_id);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change_w_e<&ew_processor::entity_attach>(viewers_of(self), entities, self, other_entity_id);
     }
 
     void world_data::entity_detach(base_objects::entity& self, size_t other_entity_id) {
-        std::unique_lock lock(mutex);
-        entity_notify_change_w_e<&ew_processor::entity_detach>(entities, self, other_entity_id);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change_w_e<&ew_processor::entity_detach>(viewers_of(self), entities, self, other_entity_id);
     }
 
     void world_data::entity_damage(base_objects::entity& self, float health, int32_t type_id, std::optional<util::VECTOR> pos) {
-        entity_notify_change_all<&ew_processor::entity_damage>(entities, self, health, type_id, pos);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change_all<&ew_processor::entity_damage>(viewers_of(self), self, health, type_id, pos);
     }
 
     void world_data::entity_damage(base_objects::entity& self, float health, int32_t type_id, base_objects::entity_ref& source, std::optional<util::VECTOR> pos) {
-        entity_notify_change_all<&ew_processor::entity_damage_with_source>(entities, self, health, type_id, source, pos);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change_all<&ew_processor::entity_damage_with_source>(viewers_of(self), self, health, type_id, source, pos);
     }
 
     void world_data::entity_damage(base_objects::entity& self, float health, int32_t type_id, base_objects::entity_ref& source, base_objects::entity_ref& source_direct, std::optional<util::VECTOR> pos) {
-        entity_notify_change_all<&ew_processor::entity_damage_with_sources>(entities, self, health, type_id, source, source_direct, pos);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change_all<&ew_processor::entity_damage_with_sources>(viewers_of(self), self, health, type_id, source, source_direct, pos);
     }
 
     void world_data::entity_attack(base_objects::entity& self, size_t other_entity_id) {
-        std::unique_lock lock(mutex);
-        entity_notify_change_w_e<&ew_processor::entity_attack>(entities, self, other_entity_id);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change_w_e<&ew_processor::entity_attack>(viewers_of(self), entities, self, other_entity_id);
     }
 
     void world_data::entity_iteract(base_objects::entity& self, size_t other_entity_id) {
-        std::unique_lock lock(mutex);
-        entity_notify_change_w_e<&ew_processor::entity_iteract>(entities, self, other_entity_id);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change_w_e<&ew_processor::entity_iteract>(viewers_of(self), entities, self, other_entity_id);
     }
 
     void world_data::entity_iteract(base_objects::entity& self, int64_t x, int64_t y, int64_t z) {
-        std::unique_lock lock(mutex);
-        entity_notify_block<&ew_processor::entity_iteract_block>(entities, self, x, y, z);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_block<&ew_processor::entity_iteract_block>(viewers_of_block(x, z), self, x, y, z);
     }
 
     void world_data::entity_break(base_objects::entity& self, int64_t x, int64_t y, int64_t z, uint8_t state) {
         if (state > 9)
             return;
-        std::unique_lock lock(mutex);
-        entity_notify_block<&ew_processor::entity_break>(entities, self, x, y, z, state);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_block<&ew_processor::entity_break>(viewers_of_block(x, z), self, x, y, z, state);
     }
 
     void world_data::entity_cancel_break(base_objects::entity& self, int64_t x, int64_t y, int64_t z) {
-        std::unique_lock lock(mutex);
-        entity_notify_block<&ew_processor::entity_cancel_break>(entities, self, x, y, z);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_block<&ew_processor::entity_cancel_break>(viewers_of_block(x, z), self, x, y, z);
     }
 
     void world_data::entity_finish_break(base_objects::entity& self, int64_t x, int64_t y, int64_t z) {
-        std::unique_lock lock(mutex);
-        entity_notify_block<&ew_processor::entity_finish_break>(entities, self, x, y, z);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_block<&ew_processor::entity_finish_break>(viewers_of_block(x, z), self, x, y, z);
     }
 
     void world_data::entity_place(base_objects::entity& self, bool is_main_hand, int64_t x, int64_t y, int64_t z, base_objects::block block) {
-        std::unique_lock lock(mutex);
-        for (auto& [id, entity] : entities)
-            if (&*entity != &self) {
-                auto processor = entity->const_data().processor;
-                if (entity->world_syncing_data && processor) {
-                    if (entity->world_syncing_data->processing_region.in_bounds(convert_chunk_global_pos(x), convert_chunk_global_pos(z)))
-                        processor->entity_place_block(*entity, self, is_main_hand, x, y, z, block);
-                }
-            }
+        fast_task::read_lock lock(entities_mutex);
+        viewers_of_block(x, z).for_each([&](base_objects::entity* entity) {
+            if (entity != &self)
+                entity->const_data().processor->entity_place_block(*entity, self, is_main_hand, x, y, z, block);
+        });
     }
 
     void world_data::entity_place(base_objects::entity& self, bool is_main_hand, int64_t x, int64_t y, int64_t z, base_objects::const_block_entity_ref block) {
-        std::unique_lock lock(mutex);
-        for (auto& [id, entity] : entities)
-            if (&*entity != &self) {
-                auto processor = entity->const_data().processor;
-                if (entity->world_syncing_data && processor) {
-                    if (entity->world_syncing_data->processing_region.in_bounds(convert_chunk_global_pos(x), convert_chunk_global_pos(z)))
-                        processor->entity_place_block_entity(self, *entity, is_main_hand, x, y, z, block);
-                }
-            }
+        fast_task::read_lock lock(entities_mutex);
+        viewers_of_block(x, z).for_each([&](base_objects::entity* entity) {
+            if (entity != &self)
+                entity->const_data().processor->entity_place_block_entity(self, *entity, is_main_hand, x, y, z, block);
+        });
     }
 
     void world_data::entity_animation(base_objects::entity& self, base_objects::entity_animation animation) {
-        std::unique_lock lock(mutex);
-        entity_notify_change<&ew_processor::entity_animation>(entities, self, animation);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change<&ew_processor::entity_animation>(viewers_of(self), self, animation);
     }
 
     void world_data::entity_event(base_objects::entity& self, base_objects::entity_event status) {
-        entity_notify_change<&ew_processor::entity_event>(entities, self, status);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change<&ew_processor::entity_event>(viewers_of(self), self, status);
     }
 
     void world_data::entity_add_effect(base_objects::entity& self, uint32_t effect_id, uint32_t duration, uint8_t amplifier, bool ambient, bool show_particles, bool show_icon, bool use_blend) {
-        entity_notify_change_all<&ew_processor::entity_add_effect>(entities, self, effect_id, duration, amplifier, ambient, show_particles, show_icon, use_blend);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change_all<&ew_processor::entity_add_effect>(viewers_of(self), self, effect_id, duration, amplifier, ambient, show_particles, show_icon, use_blend);
     }
 
     void world_data::entity_remove_effect(base_objects::entity& self, uint32_t effect_id) {
-        entity_notify_change_all<&ew_processor::entity_remove_effect>(entities, self, effect_id);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change_all<&ew_processor::entity_remove_effect>(viewers_of(self), self, effect_id);
     }
 
     void world_data::entity_death(base_objects::entity& self) {
-        std::unique_lock lock(mutex);
-        entity_notify_change<&ew_processor::entity_death>(entities, self);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change<&ew_processor::entity_death>(viewers_of(self), self);
     }
 
     void world_data::entity_deinit(base_objects::entity& self) {
-        std::unique_lock lock(mutex);
-        entity_notify_change<&ew_processor::entity_deinit>(entities, self);
+        fast_task::read_lock lock(entities_mutex);
+        entity_notify_change<&ew_processor::entity_deinit>(viewers_of(self), self);
     }
 
     void world_data::notify_block_event(const base_objects::world::block_action& action, int64_t x, int64_t y, int64_t z) {
-        std::unique_lock lock(mutex);
-        world_notify<&ew_processor::notify_block_event>(entities, x, z, action, x, y, z);
+        fast_task::read_lock lock(entities_mutex);
+        world_notify<&ew_processor::notify_block_event>(viewers_of_block(x, z), action, x, y, z);
     }
 
     void world_data::notify_block_change(int64_t x, int64_t y, int64_t z, base_objects::block block) {
-        std::unique_lock lock(mutex);
-        world_notify<&ew_processor::notify_block_change>(entities, x, z, x, y, z, block);
+        fast_task::read_lock lock(entities_mutex);
+        world_notify<&ew_processor::notify_block_change>(viewers_of_block(x, z), x, y, z, block);
     }
 
     void world_data::notify_block_change(int64_t x, int64_t y, int64_t z, base_objects::const_block_entity_ref block) {
-        std::unique_lock lock(mutex);
-        world_notify<&ew_processor::notify_block_entity_change>(entities, x, z, x, y, z, block);
+        fast_task::read_lock lock(entities_mutex);
+        world_notify<&ew_processor::notify_block_entity_change>(viewers_of_block(x, z), x, y, z, block);
     }
 
     void world_data::notify_block_destroy_change(int64_t x, int64_t y, int64_t z, base_objects::block block) {
-        std::unique_lock lock(mutex);
-        world_notify<&ew_processor::notify_block_destroy_change>(entities, x, z, x, y, z, block);
+        fast_task::read_lock lock(entities_mutex);
+        world_notify<&ew_processor::notify_block_destroy_change>(viewers_of_block(x, z), x, y, z, block);
     }
 
     void world_data::notify_block_destroy_change(int64_t x, int64_t y, int64_t z, base_objects::const_block_entity_ref block) {
-        std::unique_lock lock(mutex);
-        world_notify<&ew_processor::notify_block_entity_destroy_change>(entities, x, z, x, y, z, block);
+        fast_task::read_lock lock(entities_mutex);
+        world_notify<&ew_processor::notify_block_entity_destroy_change>(viewers_of_block(x, z), x, y, z, block);
     }
 
     void world_data::notify_biome_change(int64_t x, int64_t y, int64_t z, uint32_t biome_id) {
-        std::unique_lock lock(mutex);
-        world_notify<&ew_processor::notify_biome_change>(entities, x, z, x, y, z, biome_id);
+        fast_task::read_lock lock(entities_mutex);
+        world_notify<&ew_processor::notify_biome_change>(viewers_of_block(x, z), x, y, z, biome_id);
     }
 
     void world_data::notify_sub_chunk(int64_t chunk_x, int64_t chunk_y, int64_t chunk_z) {
-        get_sub_chunk(
+        fast_task::read_lock lock(entities_mutex);
+        auto viewers = viewers_of(chunk_x, chunk_z);
+        view_sub_chunk(
             chunk_x,
             chunk_y,
             chunk_z,
-            [this, chunk_x, chunk_y, chunk_z](auto& sub_chunk) {
-                for (auto& [id, entity] : entities) {
-                    auto processor = entity->const_data().processor;
-                    if (entity->world_syncing_data && processor) {
-                        if (entity->world_syncing_data->processing_region.in_bounds(chunk_x, chunk_z))
-                            processor->notify_sub_chunk(*entity, chunk_x, chunk_y, chunk_z, sub_chunk);
-                    }
-                }
+            [&](auto& sub_chunk) {
+                viewers.for_each([&](base_objects::entity* entity) {
+                    entity->const_data().processor->notify_sub_chunk(*entity, chunk_x, chunk_y, chunk_z, sub_chunk);
+                });
             }
         );
     }
 
     void world_data::notify_chunk(int64_t chunk_x, int64_t chunk_z) {
+        fast_task::read_lock lock(entities_mutex);
+        auto viewers = viewers_of(chunk_x, chunk_z);
         get_chunk(
             chunk_x,
             chunk_z,
-            [this, chunk_x, chunk_z](auto& chunk) {
-                for (auto& [id, entity] : entities) {
-                    auto processor = entity->const_data().processor;
-                    if (entity->world_syncing_data && processor) {
-                        if (entity->world_syncing_data->processing_region.in_bounds(chunk_x, chunk_z))
-                            processor->notify_chunk(*entity, chunk_x, chunk_z, chunk);
-                    }
-                }
+            [&](auto& chunk) {
+                viewers.for_each([&](base_objects::entity* entity) {
+                    entity->const_data().processor->notify_chunk(*entity, chunk_x, chunk_z, chunk);
+                });
             }
         );
     }
 
     void world_data::notify_sub_chunk_light(int64_t chunk_x, int64_t chunk_y, int64_t chunk_z) {
-        get_sub_chunk(
+        fast_task::read_lock lock(entities_mutex);
+        auto viewers = viewers_of(chunk_x, chunk_z);
+        view_sub_chunk(
             chunk_x,
             chunk_y,
             chunk_z,
-            [this, chunk_x, chunk_y, chunk_z](auto& sub_chunk) {
-                for (auto& [id, entity] : entities) {
-                    auto processor = entity->const_data().processor;
-                    if (entity->world_syncing_data && processor) {
-                        if (entity->world_syncing_data->processing_region.in_bounds(chunk_x, chunk_z))
-                            processor->notify_sub_chunk_light(*entity, chunk_x, chunk_y, chunk_z, sub_chunk);
-                    }
-                }
+            [&](auto& sub_chunk) {
+                viewers.for_each([&](base_objects::entity* entity) {
+                    entity->const_data().processor->notify_sub_chunk_light(*entity, chunk_x, chunk_y, chunk_z, sub_chunk);
+                });
             }
         );
     }
 
     void world_data::notify_chunk_light(int64_t chunk_x, int64_t chunk_z) {
+        fast_task::read_lock lock(entities_mutex);
+        auto viewers = viewers_of(chunk_x, chunk_z);
         get_chunk(
             chunk_x,
             chunk_z,
-            [this, chunk_x, chunk_z](auto& chunk) {
-                for (auto& [id, entity] : entities) {
-                    auto processor = entity->const_data().processor;
-                    if (entity->world_syncing_data && processor) {
-                        if (entity->world_syncing_data->processing_region.in_bounds(chunk_x, chunk_z))
-                            processor->notify_chunk_light(*entity, chunk_x, chunk_z, chunk);
-                    }
-                }
+            [&](auto& chunk) {
+                viewers.for_each([&](base_objects::entity* entity) {
+                    entity->const_data().processor->notify_chunk_light(*entity, chunk_x, chunk_z, chunk);
+                });
             }
         );
     }
 
-    void world_data::notify_sub_chunk_blocks(int64_t chunk_x, int64_t chunk_y, int64_t chunk_z) {
-        get_sub_chunk(
-            chunk_x,
-            chunk_y,
-            chunk_z,
-            [this, chunk_x, chunk_y, chunk_z](auto& sub_chunk) {
-                for (auto& [id, entity] : entities) {
-                    auto processor = entity->const_data().processor;
-                    if (entity->world_syncing_data && processor) {
-                        if (entity->world_syncing_data->processing_region.in_bounds(chunk_x, chunk_z))
-                            processor->notify_sub_chunk_blocks(*entity, chunk_x, chunk_y, chunk_z, sub_chunk);
-                    }
-                }
-            }
-        );
+    //protocol has no packet for whole section, so both resends chunk on next flush
+    void world_data::notify_sub_chunk_blocks(int64_t chunk_x, [[maybe_unused]] int64_t chunk_y, int64_t chunk_z) {
+        std::unique_lock lock(block_changes_mutex);
+        block_changes.mark_chunk(chunk_x, chunk_z);
     }
 
     void world_data::notify_chunk_blocks(int64_t chunk_x, int64_t chunk_z) {
-        get_chunk(
-            chunk_x,
-            chunk_z,
-            [this, chunk_x, chunk_z](auto& chunk) {
-                for (auto& [id, entity] : entities) {
-                    auto processor = entity->const_data().processor;
-                    if (entity->world_syncing_data && processor) {
-                        if (entity->world_syncing_data->processing_region.in_bounds(chunk_x, chunk_z))
-                            processor->notify_chunk_blocks(*entity, chunk_x, chunk_z, chunk);
-                    }
-                }
+        std::unique_lock lock(block_changes_mutex);
+        block_changes.mark_chunk(chunk_x, chunk_z);
+    }
+
+    void world_data::mark_block_changed(int64_t global_x, int64_t global_y_raw, int64_t global_z) {
+        block_changes.mark(global_x >> 4, global_y_raw >> 4, global_z >> 4, uint8_t(global_x & 15), uint8_t(global_y_raw & 15), uint8_t(global_z & 15));
+    }
+
+    void world_data::flush_block_changes() {
+        chunk_map<block_change_journal::chunk_changes> changes;
+        {
+            std::unique_lock lock(block_changes_mutex);
+            if (block_changes.empty())
+                return;
+            changes = block_changes.take();
+        }
+        fast_task::read_lock lock(entities_mutex);
+        for (auto& entry : changes) {
+            int64_t chunk_x = entry.x();
+            int64_t chunk_z = entry.z();
+            auto& chunk_changes = entry.value;
+            auto viewers = viewers_of(chunk_x, chunk_z);
+            if (viewers.empty())
+                continue;
+            if (chunk_changes.whole || chunk_changes.count > block_changes_resend_threshold) {
+                with_chunk(chunk_x, chunk_z, [&](chunk_data& chunk) {
+                    if (chunk.generator_stage == 0xFF)
+                        viewers.for_each([&](base_objects::entity* entity) {
+                            entity->const_data().processor->notify_chunk_blocks(*entity, chunk_x, chunk_z, chunk);
+                        });
+                });
+                continue;
             }
-        );
+            for (auto& [section_y, section] : chunk_changes.sections)
+                view_sub_chunk(chunk_x, section_y, chunk_z, [&](const sub_chunk_data& sub_chunk) {
+                    viewers.for_each([&](base_objects::entity* entity) {
+                        entity->const_data().processor->notify_sub_chunk_blocks(*entity, chunk_x, section_y, chunk_z, sub_chunk, section.positions);
+                    });
+                });
+        }
     }
 
     void world_data::__set_block_silent(const base_objects::full_block_data& block, int64_t global_x, int64_t global_y_raw, int64_t global_z, block_set_mode mode) {
@@ -1390,9 +1556,9 @@ namespace copper_server::storage {
     void world_data::__update_block(int64_t global_x, int64_t global_y_raw, int64_t global_z, block_set_mode mode, base_objects::block_id_t b) {
         if (mode != block_set_mode::keep) {
             if (base_objects::block::get_general_block(b).is_liquid && general_world_data.liquid.contains(b))
-                query_for_liquid_tick(global_x, global_y_raw, global_z, tick_counter + general_world_data.liquid.at(b).spread_ticks);
+                query_for_liquid_tick(global_x, global_y_raw, global_z, general_world_data.liquid.at(b).spread_ticks);
             else
-                query_for_tick(global_x, global_y_raw, global_z, tick_counter);
+                query_for_tick(global_x, global_y_raw, global_z, 0);
         }
     }
 
@@ -1487,6 +1653,12 @@ namespace copper_server::storage {
         ticks_per_second = load_from_nbt.at("ticks_per_second");
         portal_teleport_boundary = load_from_nbt.at("portal_teleport_boundary");
         ticking_frozen = load_from_nbt.at("ticking_frozen");
+        if (load_from_nbt.contains("block_changes_resend_threshold"))
+            block_changes_resend_threshold = load_from_nbt.at("block_changes_resend_threshold");
+        if (load_from_nbt.contains("parallel_ticking"))
+            parallel_ticking = load_from_nbt.at("parallel_ticking");
+        if (load_from_nbt.contains("parallel_tick_determinism_check"))
+            parallel_tick_determinism_check = load_from_nbt.at("parallel_tick_determinism_check");
 
         chunk_lifetime = std::chrono::milliseconds((long long)load_from_nbt.at("chunk_lifetime"));
         world_lifetime = std::chrono::milliseconds((long long)load_from_nbt.at("world_lifetime"));
@@ -1518,6 +1690,9 @@ namespace copper_server::storage {
             throw std::runtime_error("Can't open world file");
         std::string res((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
         load(senbt::parse(res).as_compound());
+        if (!api::configuration::get().server.world_debug_mode)
+            if (size_t converted = regions.convert_legacy(path / "chunks"); converted)
+                log::info("storage:world_data", "Converted " + std::to_string(converted) + " legacy chunk files of world " + world_name + " to region files");
     }
 
     void world_data::save() {
@@ -1568,9 +1743,12 @@ namespace copper_server::storage {
         world_data_file["day_time"] = day_time;
         world_data_file["time"] = time;
         world_data_file["random_tick_speed"] = random_tick_speed;
+        world_data_file["block_changes_resend_threshold"] = block_changes_resend_threshold;
         world_data_file["ticks_per_second"] = ticks_per_second;
         world_data_file["portal_teleport_boundary"] = portal_teleport_boundary;
         world_data_file["ticking_frozen"] = ticking_frozen;
+        world_data_file["parallel_ticking"] = parallel_ticking;
+        world_data_file["parallel_tick_determinism_check"] = parallel_tick_determinism_check;
 
         world_data_file["chunk_lifetime"] = chunk_lifetime.count();
         world_data_file["world_lifetime"] = world_lifetime.count();
@@ -1617,7 +1795,7 @@ namespace copper_server::storage {
     }
 
     world_data::world_data(int32_t world_id, const std::filesystem::path& path)
-        : path(path), world_id(world_id) {
+        : path(path), regions(path / "region"), world_id(world_id) {
         world_game_rules["reducedDebugInfo"] = api::configuration::get().game_play.reduced_debug_screen;
         if (!std::filesystem::exists(path))
             std::filesystem::create_directories(path);
@@ -1649,6 +1827,29 @@ namespace copper_server::storage {
         });
     }
 
+    void world_data::apply_ticket_level(int64_t chunk_x, int64_t chunk_z, uint8_t level) {
+        base_objects::atomic_holder<chunk_data> chunk;
+        if (auto column = find_chunk(chunk_x, chunk_z); column)
+            chunk = *column;
+        //chunks left without ticket keeps their level, it decays in `collect_unused_data` until unload
+        if (chunk && level != loading_levels::unloaded_level)
+            chunk->load_level = level;
+        bool loaded = chunk && chunk->generator_stage == 0xFF;
+        if (level <= 33 && !loaded) {
+            pending_ticket_loads(chunk_x, chunk_z) = true;
+            request_chunk_data(chunk_x, chunk_z);
+        } else
+            pending_ticket_loads.erase(chunk_x, chunk_z);
+        if (level > 33 && level <= loading_levels::max_level)
+            request_chunk_gen(chunk_x, chunk_z);
+        if (loaded && level <= 32) {
+            ticking_chunks(chunk_x, chunk_z) = chunk;
+            //level change may enable entity ticking
+            mark_active(chunk_x, chunk_z);
+        } else
+            ticking_chunks.erase(chunk_x, chunk_z);
+    }
+
     size_t world_data::add_loading_ticket(base_objects::world::loading_point_ticket&& ticket) {
         std::unique_lock lock(mutex);
         size_t id = loading_tickets.size();
@@ -1661,34 +1862,34 @@ namespace copper_server::storage {
     void world_data::remove_loading_ticket(size_t id) {
         std::unique_lock lock(mutex);
         loading_tickets.erase(id);
+        ticket_levels.remove(id);
     }
 
     size_t world_data::loaded_chunks_count() {
-        std::unique_lock lock(mutex);
         size_t count = 0;
-        for (auto& x_axis : chunks)
-            for (auto& z_axis : x_axis.second)
-                count += (bool)z_axis.second;
+        for_each_chunk_entry([&](auto& entry) {
+            count += (bool)entry.value;
+        });
         return count;
     }
 
     bool world_data::exists(int64_t chunk_x, int64_t chunk_z) {
-        std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto y_axis = x_axis->second.find(chunk_z); y_axis != x_axis->second.end())
-                return true;
-        lock.unlock();
-        bool res = std::filesystem::exists(path / "chunks" / std::to_string(chunk_x) / (std::to_string(chunk_z) + ".dat"));
-        lock.lock();
-        if (res)
-            chunks[chunk_x][chunk_z] = nullptr;
+        if (find_chunk(chunk_x, chunk_z))
+            return true;
+        bool res = regions.exists(chunk_x, chunk_z);
+        if (res) {
+            //placeholder, keeps chunk if it was loaded meanwhile
+            auto& shard = shard_of(chunk_x, chunk_z);
+            std::unique_lock lock(shard.mutex);
+            shard.chunks(chunk_x, chunk_z);
+        }
         return res;
     }
 
     base_objects::atomic_holder<chunk_data> world_data::processed_load_chunk_sync(int64_t chunk_x, int64_t chunk_z, bool is_async_context) {
         auto chunk = load_chunk_sync(chunk_x, chunk_z);
         std::unique_lock lock(mutex);
-        chunks[chunk_x][chunk_z] = chunk;
+        store_chunk(chunk_x, chunk_z, chunk);
         if (is_async_context) {
             on_load_process.erase({chunk_x, chunk_z});
             if (profiling.enable_world_profiling)
@@ -1724,9 +1925,10 @@ namespace copper_server::storage {
         return Future<base_objects::atomic_holder<chunk_data>>::start(
             [this, chunk_x, chunk_z, callback, fault]() -> base_objects::atomic_holder<chunk_data> {
                 auto chunk = processed_load_chunk_sync(chunk_x, chunk_z, true);
-                if (chunk)
+                if (chunk) {
+                    std::unique_lock lock(shard_of(chunk_x, chunk_z).mutex);
                     callback(*chunk);
-                else
+                } else
                     fault();
                 return chunk;
             }
@@ -1735,11 +1937,10 @@ namespace copper_server::storage {
 
     base_objects::atomic_holder<chunk_data> world_data::request_chunk_data_sync(int64_t chunk_x, int64_t chunk_z) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto y_axis = x_axis->second.find(chunk_z); y_axis != x_axis->second.end())
-                if (y_axis->second)
-                    if (y_axis->second->generator_stage == 0xFF)
-                        return y_axis->second;
+        if (auto column = find_chunk(chunk_x, chunk_z); column)
+            if (*column)
+                if ((*column)->generator_stage == 0xFF)
+                    return *column;
 
         if (auto process = on_load_process.find({chunk_x, chunk_z}); process == on_load_process.end()) {
             auto it = on_load_process[{chunk_x, chunk_z}] = create_chunk_load_future(chunk_x, chunk_z);
@@ -1754,11 +1955,10 @@ namespace copper_server::storage {
 
     FuturePtr<base_objects::atomic_holder<chunk_data>> world_data::request_chunk_data(int64_t chunk_x, int64_t chunk_z) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto y_axis = x_axis->second.find(chunk_z); y_axis != x_axis->second.end())
-                if (y_axis->second)
-                    if (y_axis->second->generator_stage == 0xFF)
-                        return make_ready_future(y_axis->second);
+        if (auto column = find_chunk(chunk_x, chunk_z); column)
+            if (*column)
+                if ((*column)->generator_stage == 0xFF)
+                    return make_ready_future(*column);
 
         if (auto process = on_load_process.find({chunk_x, chunk_z}); process == on_load_process.end())
             return on_load_process[{chunk_x, chunk_z}] = create_chunk_load_future(chunk_x, chunk_z);
@@ -1768,10 +1968,9 @@ namespace copper_server::storage {
 
     std::optional<base_objects::atomic_holder<chunk_data>> world_data::request_chunk_data_weak_gen(int64_t chunk_x, int64_t chunk_z) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto y_axis = x_axis->second.find(chunk_z); y_axis != x_axis->second.end())
-                if (y_axis->second)
-                    return std::make_optional(y_axis->second);
+        if (auto column = find_chunk(chunk_x, chunk_z); column)
+            if (*column)
+                return std::make_optional(*column);
 
 
         if (auto process = on_load_process.find({chunk_x, chunk_z}); process == on_load_process.end()) {
@@ -1783,20 +1982,18 @@ namespace copper_server::storage {
 
     std::optional<base_objects::atomic_holder<chunk_data>> world_data::request_chunk_data_weak(int64_t chunk_x, int64_t chunk_z) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto y_axis = x_axis->second.find(chunk_z); y_axis != x_axis->second.end())
-                if (y_axis->second)
-                    return std::make_optional(y_axis->second);
+        if (auto column = find_chunk(chunk_x, chunk_z); column)
+            if (*column)
+                return std::make_optional(*column);
 
         return std::nullopt;
     }
 
     std::optional<base_objects::atomic_holder<chunk_data>> world_data::request_chunk_data_weak_sync(int64_t chunk_x, int64_t chunk_z) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto y_axis = x_axis->second.find(chunk_z); y_axis != x_axis->second.end())
-                if (y_axis->second)
-                    return std::make_optional(y_axis->second);
+        if (auto column = find_chunk(chunk_x, chunk_z); column)
+            if (*column)
+                return std::make_optional(*column);
         if (auto process = on_load_process.find({chunk_x, chunk_z}); process == on_load_process.end()) {
             if (exists(chunk_x, chunk_z)) {
                 auto it = on_load_process[{chunk_x, chunk_z}] = create_chunk_load_future(chunk_x, chunk_z);
@@ -1813,24 +2010,22 @@ namespace copper_server::storage {
 
     void world_data::request_chunk_gen(int64_t chunk_x, int64_t chunk_z) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto y_axis = x_axis->second.find(chunk_z); y_axis != x_axis->second.end())
-                return;
+        if (auto column = find_chunk(chunk_x, chunk_z); column)
+            return;
         if (auto process = on_load_process.find({chunk_x, chunk_z}); process == on_load_process.end()) {
             bool make_gen = false;
             if (!exists(chunk_x, chunk_z))
                 make_gen = true;
-            else if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-                if (auto z_axis = x_axis->second.find(chunk_z); z_axis != x_axis->second.end()) {
-                    auto chunk = z_axis->second;
-                    if (chunk)
-                        if (chunk->generator_stage != 0xFF)
-                            if (chunk->load_level <= chunk->resume_gen_level)
-                                if (!on_generate_process.contains({chunk_x, chunk_z})) {
-                                    make_gen = true;
-                                    chunk->resume_gen_level = 0xFF;
-                                }
-                }
+            else if (auto column = find_chunk(chunk_x, chunk_z); column) {
+                auto chunk = *column;
+                if (chunk)
+                    if (chunk->generator_stage != 0xFF)
+                        if (chunk->load_level <= chunk->resume_gen_level)
+                            if (!on_generate_process.contains({chunk_x, chunk_z})) {
+                                make_gen = true;
+                                chunk->resume_gen_level = 0xFF;
+                            }
+            }
 
             if (make_gen)
                 on_load_process[{chunk_x, chunk_z}] = create_chunk_load_future(chunk_x, chunk_z);
@@ -1839,19 +2034,20 @@ namespace copper_server::storage {
 
     bool world_data::request_chunk_data_sync(int64_t chunk_x, int64_t chunk_z, std::function<void(chunk_data& chunk)> callback) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto z_axis = x_axis->second.find(chunk_z); z_axis != x_axis->second.end())
-                if (z_axis->second) {
-                    callback(*z_axis->second);
-                    return true;
-                }
+        if (auto column = find_chunk(chunk_x, chunk_z); column && *column) {
+            lock.unlock();
+            std::unique_lock shard_lock(shard_of(chunk_x, chunk_z).mutex);
+            callback(**column);
+            return true;
+        }
 
         if (auto process = on_load_process.find({chunk_x, chunk_z}); process == on_load_process.end()) {
             auto res = processed_load_chunk_sync(chunk_x, chunk_z, false);
-            if (res)
-                callback(*(chunks[chunk_x][chunk_z] = res));
-            else
+            if (!res)
                 return false;
+            lock.unlock();
+            std::unique_lock shard_lock(shard_of(chunk_x, chunk_z).mutex);
+            callback(*res);
             return true;
         } else {
             process->second->wait_with(lock);
@@ -1861,20 +2057,21 @@ namespace copper_server::storage {
 
     void world_data::request_chunk_data(int64_t chunk_x, int64_t chunk_z, std::function<void(chunk_data& chunk)> callback, std::function<void()> fault) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto y_axis = x_axis->second.find(chunk_z); y_axis != x_axis->second.end())
-                if (y_axis->second) {
-                    callback(*y_axis->second);
-                    return;
-                }
+        if (auto column = find_chunk(chunk_x, chunk_z); column && *column) {
+            lock.unlock();
+            std::unique_lock shard_lock(shard_of(chunk_x, chunk_z).mutex);
+            callback(**column);
+            return;
+        }
 
         if (auto process = on_load_process.find({chunk_x, chunk_z}); process == on_load_process.end())
             on_load_process[{chunk_x, chunk_z}] = create_chunk_load_future(chunk_x, chunk_z, callback, fault);
         else
-            process->second->when_ready([callback, fault](base_objects::atomic_holder<chunk_data> chunk) {
-                if (chunk)
+            process->second->when_ready([this, chunk_x, chunk_z, callback, fault](base_objects::atomic_holder<chunk_data> chunk) {
+                if (chunk) {
+                    std::unique_lock lock(shard_of(chunk_x, chunk_z).mutex);
                     callback(*chunk);
-                else
+                } else
                     fault();
             });
     }
@@ -1890,9 +2087,9 @@ namespace copper_server::storage {
 
     void world_data::save_chunks(bool unload) {
         std::unique_lock lock(mutex);
-        for (auto& [x, x_axis] : chunks)
-            for (auto& [z, chunk] : x_axis)
-                make_save(x, z, unload);
+        for_each_chunk_entry([&](auto& entry) {
+            make_save(entry.x(), entry.z(), entry.value, unload);
+        });
     }
 
     void world_data::save_and_unload_chunk(int64_t chunk_x, int64_t chunk_z) {
@@ -1902,9 +2099,7 @@ namespace copper_server::storage {
 
     void world_data::unload_chunk(int64_t chunk_x, int64_t chunk_z) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto z_axis = x_axis->second.find(chunk_z); z_axis != x_axis->second.end())
-                x_axis->second.erase(z_axis);
+        remove_chunk(chunk_x, chunk_z);
     }
 
     void world_data::save_chunk(int64_t chunk_x, int64_t chunk_z) {
@@ -1914,18 +2109,14 @@ namespace copper_server::storage {
 
     void world_data::erase_chunk(int64_t chunk_x, int64_t chunk_z) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto z_axis = x_axis->second.find(chunk_z); z_axis != x_axis->second.end())
-                x_axis->second.erase(z_axis);
-        std::filesystem::remove(path / std::to_string(chunk_x) / (std::to_string(chunk_z) + ".dat"));
+        remove_chunk(chunk_x, chunk_z);
+        regions.erase(chunk_x, chunk_z);
     }
 
     void world_data::regenerate_chunk(int64_t chunk_x, int64_t chunk_z) {
         std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto z_axis = x_axis->second.find(chunk_z); z_axis != x_axis->second.end())
-                x_axis->second.erase(z_axis);
-        std::filesystem::remove(path / std::to_string(chunk_x) / (std::to_string(chunk_z) + ".dat"));
+        remove_chunk(chunk_x, chunk_z);
+        regions.erase(chunk_x, chunk_z);
         if (auto process = on_load_process.find({chunk_x, chunk_z}); process == on_load_process.end())
             on_load_process[{chunk_x, chunk_z}] = create_chunk_load_future(chunk_x, chunk_z);
     }
@@ -1960,62 +2151,63 @@ namespace copper_server::storage {
     }
 
     void world_data::for_each_chunk(std::function<void(chunk_data& chunk)> func) {
-        std::unique_lock lock(mutex);
-        for (auto& [x, x_axis] : chunks)
-            for (auto& [z, chunk] : x_axis)
-                if (chunk)
-                    if (chunk->generator_stage == 0xFF)
-                        func(*chunk);
+        for (auto& shard : chunk_shards) {
+            std::unique_lock lock(shard.mutex);
+            for (auto& entry : shard.chunks)
+                if (entry.value)
+                    if (entry.value->generator_stage == 0xFF) {
+                        func(*entry.value);
+                        shard.active(entry.x(), entry.z()) = true;
+                    }
+        }
     }
 
     void world_data::for_each_chunk(base_objects::cubic_bounds_chunk bounds, std::function<void(chunk_data& chunk)> func) {
-        std::unique_lock lock(mutex);
         for (int64_t x = bounds.x1; x <= bounds.x2; x++)
             for (int64_t z = bounds.z1; z <= bounds.z2; z++)
-                if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                    if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                        if (chunk->second)
-                            if (chunk->second->generator_stage == 0xFF)
-                                func(*chunk->second);
+                edit_chunk(x, z, [&](chunk_data& chunk) {
+                    if (chunk.generator_stage == 0xFF)
+                        func(chunk);
+                });
     }
 
     void world_data::for_each_chunk(base_objects::spherical_bounds_chunk bounds, std::function<void(chunk_data& chunk)> func) {
-        std::unique_lock lock(mutex);
         bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        if (chunk->second->generator_stage == 0xFF)
-                            func(*chunk->second);
+            edit_chunk(x, z, [&](chunk_data& chunk) {
+                if (chunk.generator_stage == 0xFF)
+                    func(chunk);
+            });
         });
     }
 
     void world_data::for_each_sub_chunk(int64_t chunk_x, int64_t chunk_z, std::function<void(sub_chunk_data& chunk)> func) {
-        std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto chunk = x_axis->second.find(chunk_z); chunk != x_axis->second.end())
-                if (chunk->second)
-                    if (chunk->second->generator_stage == 0xFF)
-                        chunk->second->for_each_sub_chunk(func);
+        edit_chunk(chunk_x, chunk_z, [&](chunk_data& chunk) {
+            if (chunk.generator_stage == 0xFF)
+                chunk.for_each_sub_chunk(func);
+        });
     }
 
     void world_data::get_sub_chunk(int64_t chunk_x, int64_t chunk_y_raw, int64_t chunk_z, std::function<void(sub_chunk_data& chunk)> func) {
-        std::unique_lock lock(mutex);
         TO_WORLD_POS_CHUNK(chunk_y, chunk_y_raw);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto chunk = x_axis->second.find(chunk_z); chunk != x_axis->second.end())
-                if (chunk->second)
-                    if (chunk->second->generator_stage == 0xFF)
-                        chunk->second->get_sub_chunk(chunk_y, func);
+        edit_chunk(chunk_x, chunk_z, [&](chunk_data& chunk) {
+            if (chunk.generator_stage == 0xFF)
+                chunk.get_sub_chunk(chunk_y, func);
+        });
+    }
+
+    void world_data::view_sub_chunk(int64_t chunk_x, int64_t chunk_y_raw, int64_t chunk_z, std::function<void(const sub_chunk_data& chunk)> func) {
+        TO_WORLD_POS_CHUNK(chunk_y, chunk_y_raw);
+        with_chunk(chunk_x, chunk_z, [&](chunk_data& chunk) {
+            if (chunk.generator_stage == 0xFF)
+                chunk.view_sub_chunk(chunk_y, func);
+        });
     }
 
     void world_data::get_chunk(int64_t chunk_x, int64_t chunk_z, std::function<void(chunk_data& chunk)> func) {
-        std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto chunk = x_axis->second.find(chunk_z); chunk != x_axis->second.end())
-                if (chunk->second)
-                    if (chunk->second->generator_stage == 0xFF)
-                        func(*chunk->second);
+        edit_chunk(chunk_x, chunk_z, [&](chunk_data& chunk) {
+            if (chunk.generator_stage == 0xFF)
+                func(chunk);
+        });
     }
 
     void world_data::for_each_chunk(base_objects::cubic_bounds_block bounds, std::function<void(chunk_data& chunk)> func) {
@@ -2040,136 +2232,113 @@ namespace copper_server::storage {
     }
 
     void world_data::for_each_entity(std::function<void(const base_objects::entity_ref& entity)> func) {
-        std::unique_lock lock(mutex);
+        fast_task::read_lock lock(entities_mutex);
         for (auto& [x, entity] : entities)
             func(entity);
     }
 
     void world_data::for_each_entity(base_objects::cubic_bounds_chunk bounds, std::function<void(base_objects::entity_ref& entity)> func) {
-        std::unique_lock lock(mutex);
-        bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_entity(func);
-        });
+        list_array<base_objects::entity_ref> found;
+        {
+            fast_task::read_lock lock(entities_mutex);
+            bounds.enum_points([&](int64_t x, int64_t z) { collect_entities(x, z, found); });
+        }
+        found.for_each(func);
     }
 
     void world_data::for_each_entity(base_objects::cubic_bounds_chunk_radius bounds, std::function<void(base_objects::entity_ref& entity)> func) {
-        std::unique_lock lock(mutex);
-        bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_entity(func);
-        });
+        list_array<base_objects::entity_ref> found;
+        {
+            fast_task::read_lock lock(entities_mutex);
+            bounds.enum_points([&](int64_t x, int64_t z) { collect_entities(x, z, found); });
+        }
+        found.for_each(func);
     }
 
     void world_data::for_each_entity(base_objects::cubic_bounds_chunk_radius_out bounds, std::function<void(base_objects::entity_ref& entity)> func) {
-        std::unique_lock lock(mutex);
-        bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_entity(func);
-        });
+        list_array<base_objects::entity_ref> found;
+        {
+            fast_task::read_lock lock(entities_mutex);
+            bounds.enum_points([&](int64_t x, int64_t z) { collect_entities(x, z, found); });
+        }
+        found.for_each(func);
     }
 
     void world_data::for_each_entity(base_objects::spherical_bounds_chunk bounds, std::function<void(base_objects::entity_ref& entity)> func) {
-        std::unique_lock lock(mutex);
-        bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_entity(func);
-        });
+        list_array<base_objects::entity_ref> found;
+        {
+            fast_task::read_lock lock(entities_mutex);
+            bounds.enum_points([&](int64_t x, int64_t z) { collect_entities(x, z, found); });
+        }
+        found.for_each(func);
     }
 
     void world_data::for_each_entity(base_objects::spherical_bounds_chunk_out bounds, std::function<void(base_objects::entity_ref& entity)> func) {
-        std::unique_lock lock(mutex);
-        bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_entity(func);
-        });
+        list_array<base_objects::entity_ref> found;
+        {
+            fast_task::read_lock lock(entities_mutex);
+            bounds.enum_points([&](int64_t x, int64_t z) { collect_entities(x, z, found); });
+        }
+        found.for_each(func);
     }
 
     void world_data::for_each_entity(int64_t chunk_x, int64_t chunk_z, std::function<void(const base_objects::entity_ref& entity)> func) {
-        std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto chunk = x_axis->second.find(chunk_z); chunk != x_axis->second.end())
-                if (chunk->second)
-                    chunk->second->for_each_entity(func);
+        list_array<base_objects::entity_ref> found;
+        {
+            fast_task::read_lock lock(entities_mutex);
+            collect_entities(chunk_x, chunk_z, found);
+        }
+        found.for_each([&](const base_objects::entity_ref& entity) { func(entity); });
     }
 
     void world_data::for_each_entity(int64_t chunk_x, int64_t chunk_y_raw, int64_t chunk_z, std::function<void(const base_objects::entity_ref& entity)> func) {
-        TO_WORLD_POS_CHUNK(chunk_y, chunk_y_raw);
-        std::unique_lock lock(mutex);
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto chunk = x_axis->second.find(chunk_z); chunk != x_axis->second.end())
-                if (chunk->second)
-                    chunk->second->for_each_entity(chunk_y, func);
+        list_array<base_objects::entity_ref> found;
+        {
+            fast_task::read_lock lock(entities_mutex);
+            collect_entities(chunk_x, chunk_z, found);
+        }
+        found.for_each([&](const base_objects::entity_ref& entity) {
+            if (convert_chunk_global_pos((int64_t)entity->position.y) == chunk_y_raw)
+                func(entity);
+        });
     }
 
     void world_data::for_each_block_entity(base_objects::cubic_bounds_chunk bounds, std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
-        std::unique_lock lock(mutex);
         bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_block_entity(func);
+            with_chunk(x, z, [&](chunk_data& chunk) { chunk.for_each_block_entity(func); });
         });
     }
 
     void world_data::for_each_block_entity(base_objects::cubic_bounds_chunk_radius bounds, std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
-        std::unique_lock lock(mutex);
         bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_block_entity(func);
+            with_chunk(x, z, [&](chunk_data& chunk) { chunk.for_each_block_entity(func); });
         });
     }
 
     void world_data::for_each_block_entity(base_objects::cubic_bounds_chunk_radius_out bounds, std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
-        std::unique_lock lock(mutex);
         bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_block_entity(func);
+            with_chunk(x, z, [&](chunk_data& chunk) { chunk.for_each_block_entity(func); });
         });
     }
 
     void world_data::for_each_block_entity(base_objects::spherical_bounds_chunk bounds, std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
-        std::unique_lock lock(mutex);
         bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_block_entity(func);
+            with_chunk(x, z, [&](chunk_data& chunk) { chunk.for_each_block_entity(func); });
         });
     }
 
     void world_data::for_each_block_entity(base_objects::spherical_bounds_chunk_out bounds, std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
-        std::unique_lock lock(mutex);
         bounds.enum_points([&](int64_t x, int64_t z) {
-            if (auto x_axis = chunks.find(x); x_axis != chunks.end())
-                if (auto chunk = x_axis->second.find(z); chunk != x_axis->second.end())
-                    if (chunk->second)
-                        chunk->second->for_each_block_entity(func);
+            with_chunk(x, z, [&](chunk_data& chunk) { chunk.for_each_block_entity(func); });
         });
     }
 
     void world_data::for_each_block_entity(int64_t chunk_x, int64_t chunk_z, std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
-        std::unique_lock lock(mutex);
         get_chunk(chunk_x, chunk_z, [&](auto& chunk) { chunk.for_each_block_entity(func); });
     }
 
     void world_data::for_each_block_entity(int64_t chunk_x, int64_t chunk_y_raw, int64_t chunk_z, std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
         TO_WORLD_POS_CHUNK(chunk_y, chunk_y_raw);
-        std::unique_lock lock(mutex);
         get_chunk(chunk_x, chunk_z, [&](auto& chunk) { chunk.for_each_block_entity(chunk_y, func); });
     }
 
@@ -2213,8 +2382,7 @@ namespace copper_server::storage {
     }
 
     void world_data::for_each_entity_at(int64_t global_x, int64_t global_y_raw, int64_t global_z, std::function<void(const base_objects::entity_ref& entity)> func) {
-        TO_WORLD_POS_GLOBAL(global_y, global_y_raw);
-        for_each_entity(convert_chunk_global_pos(global_x), convert_chunk_global_pos(global_z), convert_chunk_global_pos(global_y), func);
+        for_each_entity(convert_chunk_global_pos(global_x), convert_chunk_global_pos(global_y_raw), convert_chunk_global_pos(global_z), func);
     }
 
     void world_data::for_each_block_entity_at(int64_t global_x, int64_t global_z, std::function<void(base_objects::block& block, enbt::value& extended_data)> func) {
@@ -2227,47 +2395,56 @@ namespace copper_server::storage {
     }
 
     void world_data::query_for_tick(int64_t global_x, int64_t global_y_raw, int64_t global_z, uint64_t duration, int8_t priority) {
+        if (auto region = deferring_region(global_x >> 4, global_z >> 4); region) {
+            region->deferred.push_back([=, this] { query_for_tick(global_x, global_y_raw, global_z, duration, priority); });
+            return;
+        }
         TO_WORLD_POS_GLOBAL(global_y, global_y_raw);
-        std::unique_lock lock(mutex);
         auto chunk_x = global_x >> 4;
         auto chunk_z = global_z >> 4;
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto chunk = x_axis->second.find(chunk_z); chunk != x_axis->second.end())
-                if (chunk->second)
-                    chunk->second->query_for_tick(global_x & 15, global_y, global_z & 15, duration + tick_counter, priority);
+        edit_chunk(chunk_x, chunk_z, [&](chunk_data& chunk) { chunk.query_for_tick(global_x & 15, global_y, global_z & 15, duration + tick_counter, priority); });
     }
 
     void world_data::query_for_liquid_tick(int64_t global_x, int64_t global_y_raw, int64_t global_z, uint64_t duration) {
+        if (auto region = deferring_region(global_x >> 4, global_z >> 4); region) {
+            region->deferred.push_back([=, this] { query_for_liquid_tick(global_x, global_y_raw, global_z, duration); });
+            return;
+        }
         TO_WORLD_POS_GLOBAL(global_y, global_y_raw);
-        std::unique_lock lock(mutex);
         auto chunk_x = global_x >> 4;
         auto chunk_z = global_z >> 4;
-        if (auto x_axis = chunks.find(chunk_x); x_axis != chunks.end())
-            if (auto chunk = x_axis->second.find(chunk_z); chunk != x_axis->second.end())
-                if (chunk->second)
-                    chunk->second->query_for_liquid_tick(global_x & 15, global_y, global_z & 15, duration + tick_counter);
+        edit_chunk(chunk_x, chunk_z, [&](chunk_data& chunk) { chunk.query_for_liquid_tick(global_x & 15, global_y, global_z & 15, duration + tick_counter); });
     }
 
     void world_data::set_block(const base_objects::full_block_data& block, int64_t global_x, int64_t global_y_raw, int64_t global_z, block_set_mode mode) {
+        if (auto region = deferring_region(global_x >> 4, global_z >> 4); region) {
+            region->deferred.push_back([=, this] { set_block(block, global_x, global_y_raw, global_z, mode); });
+            return;
+        }
         TO_WORLD_POS_GLOBAL(global_y, global_y_raw);
         bool updates_height_map = false;
+        std::optional<base_objects::block_id_t> gen_block_id;
         get_sub_chunk(global_x >> 4, global_y >> 4, global_z >> 4, [&](sub_chunk_data& sub_chunk) {
-            auto gen_block_id = std::visit(
+            gen_block_id = std::visit(
                 [&](auto& it) {
                     if (mode == block_set_mode::destroy)
                         WORLD_ASYNC_RUN(notify_block_destroy_change, global_x, global_y, global_z, it);
-                    else
-                        WORLD_ASYNC_RUN(notify_block_change, global_x, global_y, global_z, it);
                     updates_height_map = it.is_solid();
                     return it.general_block_id();
                 },
                 block
             );
             sub_chunk.set_block(global_x & 15, global_y & 15, global_z & 15, block);
-            get_light_processor()->block_changed(*this, global_x, global_y, global_z);
-            __update_block(global_x, global_y_raw, global_z, mode, gen_block_id);
         });
-
+        if (!gen_block_id)
+            return;
+        if (mode != block_set_mode::destroy) {
+            std::unique_lock journal_lock(block_changes_mutex);
+            mark_block_changed(global_x, global_y_raw, global_z);
+        }
+        //neighbors may be in other shard, so called after chunk lock released
+        get_light_processor()->block_changed(*this, global_x, global_y, global_z);
+        __update_block(global_x, global_y_raw, global_z, mode, *gen_block_id);
 
         if (updates_height_map)
             get_chunk_at(global_x, global_z, [&](auto& chunk) {
@@ -2276,39 +2453,62 @@ namespace copper_server::storage {
     }
 
     void world_data::set_block(base_objects::full_block_data&& block, int64_t global_x, int64_t global_y_raw, int64_t global_z, block_set_mode mode) {
+        if (auto region = deferring_region(global_x >> 4, global_z >> 4); region) {
+            region->deferred.push_back([=, this, block = std::move(block)]() mutable { set_block(std::move(block), global_x, global_y_raw, global_z, mode); });
+            return;
+        }
         TO_WORLD_POS_GLOBAL(global_y, global_y_raw);
+        std::optional<base_objects::block_id_t> gen_block_id;
         get_sub_chunk(global_x >> 4, global_y >> 4, global_z >> 4, [&](sub_chunk_data& sub_chunk) {
-            auto gen_block_id = std::visit(
+            gen_block_id = std::visit(
                 [&](auto& it) {
                     if (mode == block_set_mode::destroy)
                         WORLD_ASYNC_RUN(notify_block_destroy_change, global_x, global_y, global_z, it);
-                    else
-                        WORLD_ASYNC_RUN(notify_block_change, global_x, global_y, global_z, it);
                     return it.general_block_id();
                 },
                 block
             );
             sub_chunk.set_block(global_x & 15, global_y & 15, global_z & 15, std::move(block));
-            get_light_processor()->block_changed(*this, global_x, global_y, global_z);
-            __update_block(global_x, global_y_raw, global_z, mode, gen_block_id);
         });
+        if (!gen_block_id)
+            return;
+        if (mode != block_set_mode::destroy) {
+            std::unique_lock journal_lock(block_changes_mutex);
+            mark_block_changed(global_x, global_y_raw, global_z);
+        }
+        get_light_processor()->block_changed(*this, global_x, global_y, global_z);
+        __update_block(global_x, global_y_raw, global_z, mode, *gen_block_id);
     }
 
     void world_data::remove_block(int64_t global_x, int64_t global_y_raw, int64_t global_z) {
+        if (auto region = deferring_region(global_x >> 4, global_z >> 4); region) {
+            region->deferred.push_back([=, this] { remove_block(global_x, global_y_raw, global_z); });
+            return;
+        }
         TO_WORLD_POS_GLOBAL(global_y, global_y_raw);
+        base_objects::block air;
+        bool changed = false;
         get_sub_chunk(global_x >> 4, global_y >> 4, global_z >> 4, [&](sub_chunk_data& sub_chunk) {
-            base_objects::block air;
-            WORLD_ASYNC_RUN(notify_block_change, global_x, global_y, global_z, air);
             sub_chunk.set_block(global_x & 15, global_y & 15, global_z & 15, air);
-            get_light_processor()->block_changed(*this, global_x, global_y, global_z);
-            __update_block(global_x, global_y_raw, global_z, block_set_mode::replace, air.general_block_id());
+            changed = true;
         });
+        if (!changed)
+            return;
+        {
+            std::unique_lock journal_lock(block_changes_mutex);
+            mark_block_changed(global_x, global_y_raw, global_z);
+        }
+        get_light_processor()->block_changed(*this, global_x, global_y, global_z);
+        __update_block(global_x, global_y_raw, global_z, block_set_mode::replace, air.general_block_id());
     }
 
     void world_data::get_block(int64_t global_x, int64_t global_y_raw, int64_t global_z, std::function<void(base_objects::block& block)> func, std::function<void(base_objects::block& block, enbt::value& extended_data)> block_entity) {
         TO_WORLD_POS_GLOBAL(global_y, global_y_raw);
-        get_sub_chunk(global_x >> 4, global_y >> 4, global_z >> 4, [&](sub_chunk_data& sub_chunk) {
-            sub_chunk.get_block(global_x & 15, global_y & 15, global_z & 15, func, block_entity);
+        get_chunk(global_x >> 4, global_z >> 4, [&](chunk_data& chunk) {
+            TO_WORLD_POS_CHUNK(chunk_y, global_y >> 4);
+            //goes through handle, shared section copied only if callbacks changes the block
+            if (uint64_t(chunk_y) < chunk.sub_chunks.size())
+                chunk.sub_chunks[chunk_y].get_block(global_x & 15, global_y & 15, global_z & 15, func, block_entity);
         });
     }
 
@@ -2318,12 +2518,8 @@ namespace copper_server::storage {
             global_x >> 4,
             global_z >> 4,
             [&](chunk_data& chunk) {
-                chunk.get_sub_chunk(
-                    global_y >> 4,
-                    [&, block_entity, func](sub_chunk_data& sub_chunk) {
-                        sub_chunk.get_block(global_x & 15, global_y & 15, global_z & 15, func, block_entity);
-                    }
-                );
+                if (uint64_t(global_y >> 4) < chunk.sub_chunks.size())
+                    chunk.sub_chunks[global_y >> 4].get_block(global_x & 15, global_y & 15, global_z & 15, func, block_entity);
             },
             fault
         );
@@ -2331,16 +2527,10 @@ namespace copper_server::storage {
 
     void world_data::block_updated(int64_t global_x, int64_t global_y, int64_t global_z) {
         std::unique_lock lock(mutex);
-        get_block(
-            global_x,
-            global_y,
-            global_z,
-            [&](auto& normal) { WORLD_ASYNC_RUN(notify_block_change, global_x, global_y, global_z, normal); },
-            [&](auto& block, auto& nbt) {
-                base_objects::const_block_entity_ref ref(block, nbt);
-                WORLD_ASYNC_RUN(notify_block_change, global_x, global_y, global_z, ref);
-            }
-        );
+        {
+            std::unique_lock journal_lock(block_changes_mutex);
+            mark_block_changed(global_x, global_y, global_z);
+        }
         get_light_processor()->block_changed(*this, global_x, global_y, global_z);
     }
 
@@ -2357,148 +2547,209 @@ namespace copper_server::storage {
 
     void world_data::locked(std::function<void(world_data& self)> func) {
         std::unique_lock lock(mutex);
+        std::vector<std::unique_lock<fast_task::task_recursive_mutex>> shard_locks;
+        shard_locks.reserve(chunk_shards_count);
+        for (auto& shard : chunk_shards)
+            shard_locks.emplace_back(shard.mutex);
+        func(*this);
+    }
+
+    void world_data::locked(base_objects::cubic_bounds_chunk bounds, std::function<void(world_data& self)> func) {
+        auto shard_locks = lock_shards(bounds);
         func(*this);
     }
 
+    std::vector<std::unique_lock<fast_task::task_recursive_mutex>> world_data::lock_shards(base_objects::cubic_bounds_chunk bounds) {
+        std::bitset<chunk_shards_count> involved;
+        int64_t region_x1 = bounds.x1 >> chunk_shard_region_shift;
+        int64_t region_z1 = bounds.z1 >> chunk_shard_region_shift;
+        int64_t region_x2 = bounds.x2 >> chunk_shard_region_shift;
+        int64_t region_z2 = bounds.z2 >> chunk_shard_region_shift;
+        if (uint64_t(region_x2 - region_x1 + 1) * uint64_t(region_z2 - region_z1 + 1) >= chunk_shards_count)
+            involved.set();
+        else
+            for (int64_t x = region_x1; x <= region_x2; x++)
+                for (int64_t z = region_z1; z <= region_z2; z++)
+                    involved.set(shard_index(x << chunk_shard_region_shift, z << chunk_shard_region_shift));
+
+        std::vector<std::unique_lock<fast_task::task_recursive_mutex>> shard_locks;
+        shard_locks.reserve(involved.count());
+        for (size_t i = 0; i < chunk_shards_count; i++)
+            if (involved.test(i))
+                shard_locks.emplace_back(chunk_shards[i].mutex);
+        return shard_locks;
+    }
+
+    //chunks which could be touched by range change, includes neighbors for block updates
+    static base_objects::cubic_bounds_chunk lock_region_of(base_objects::cubic_bounds_block bounds) {
+        auto res = (base_objects::cubic_bounds_chunk)bounds;
+        return {res.x1 - 1, res.z1 - 1, res.x2 + 1, res.z2 + 1};
+    }
+
+    static base_objects::cubic_bounds_chunk lock_region_of(base_objects::spherical_bounds_block bounds) {
+        int64_t radius = int64_t(std::ceil(bounds.radius));
+        return {((bounds.x - radius) >> 4) - 1, ((bounds.z - radius) >> 4) - 1, ((bounds.x + radius) >> 4) + 1, ((bounds.z + radius) >> 4) + 1};
+    }
+
+
     void world_data::set_block_range(base_objects::cubic_bounds_block bounds, const list_array<base_objects::full_block_data>& blocks, block_set_mode mode) {
         if (blocks.size() == bounds.count()) {
             size_t i = 0;
-            locked([&](storage::world_data& world) {
+            locked(lock_region_of(bounds), [&](storage::world_data& world) {
                 bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
                     world.__set_block_silent(blocks[i++], x, y, z, mode);
                 });
-
-                bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
-                    get_light_processor()->block_changed(*this, x, y, z);
-                });
+            });
+            //light processor reads neighbor chunks, so it runs after shards released
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                get_light_processor()->block_changed(*this, x, y, z);
             });
         } else {
             size_t i = 0;
             size_t max = blocks.size();
-            locked([&](storage::world_data& world) {
+            locked(lock_region_of(bounds), [&](storage::world_data& world) {
                 bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
                     world.__set_block_silent(blocks[i++], x, y, z, mode);
                     if (i == max)
                         i = 0;
                 });
-                bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
-                    get_light_processor()->block_changed(*this, x, y, z);
-                });
+            });
+            //light processor reads neighbor chunks, so it runs after shards released
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                get_light_processor()->block_changed(*this, x, y, z);
             });
         }
 
-        if (mode != block_set_mode::destroy)
-            ((base_objects::cubic_bounds_chunk)bounds).enum_points([&](int64_t x, int64_t z) {
-                WORLD_ASYNC_RUN(notify_chunk_blocks, x, z);
+        if (mode != block_set_mode::destroy) {
+            std::unique_lock journal_lock(block_changes_mutex);
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                mark_block_changed(x, y, z);
             });
+        }
     }
 
     void world_data::set_block_range(base_objects::cubic_bounds_block bounds, list_array<base_objects::full_block_data>&& blocks, block_set_mode mode) {
         if (blocks.size() == bounds.count()) {
             size_t i = 0;
-            locked([&](storage::world_data& world) {
+            locked(lock_region_of(bounds), [&](storage::world_data& world) {
                 bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
                     world.__set_block_silent(std::move(blocks[i++]), x, y, z, mode);
                 });
-                bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
-                    get_light_processor()->block_changed(*this, x, y, z);
-                });
+            });
+            //light processor reads neighbor chunks, so it runs after shards released
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                get_light_processor()->block_changed(*this, x, y, z);
             });
         } else {
             size_t i = 0;
             size_t max = blocks.size();
-            locked([&](storage::world_data& world) {
+            locked(lock_region_of(bounds), [&](storage::world_data& world) {
                 bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
                     world.__set_block_silent(blocks[i++], x, y, z, mode);
                     if (i == max)
                         i = 0;
                 });
-                bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
-                    get_light_processor()->block_changed(*this, x, y, z);
-                });
+            });
+            //light processor reads neighbor chunks, so it runs after shards released
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                get_light_processor()->block_changed(*this, x, y, z);
             });
         }
 
-        if (mode != block_set_mode::destroy)
-            ((base_objects::cubic_bounds_chunk)bounds).enum_points([&](int64_t x, int64_t z) {
-                WORLD_ASYNC_RUN(notify_chunk_blocks, x, z);
+        if (mode != block_set_mode::destroy) {
+            std::unique_lock journal_lock(block_changes_mutex);
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                mark_block_changed(x, y, z);
             });
+        }
     }
 
     void world_data::set_block_range(base_objects::spherical_bounds_block bounds, const list_array<base_objects::full_block_data>& blocks, block_set_mode mode) {
         if (blocks.size() == bounds.count()) {
             size_t i = 0;
-            locked([&](storage::world_data& world) {
+            locked(lock_region_of(bounds), [&](storage::world_data& world) {
                 bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
                     world.__set_block_silent(blocks[i++], x, y, z, mode);
                 });
-                bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
-                    get_light_processor()->block_changed(*this, x, y, z);
-                });
+            });
+            //light processor reads neighbor chunks, so it runs after shards released
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                get_light_processor()->block_changed(*this, x, y, z);
             });
         } else {
             size_t i = 0;
             size_t max = blocks.size();
-            locked([&](storage::world_data& world) {
+            locked(lock_region_of(bounds), [&](storage::world_data& world) {
                 bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
                     world.__set_block_silent(blocks[i++], x, y, z, mode);
                 });
-                bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
-                    get_light_processor()->block_changed(*this, x, y, z);
-                });
                 if (i == max)
                     i = 0;
             });
+            //light processor reads neighbor chunks, so it runs after shards released
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                get_light_processor()->block_changed(*this, x, y, z);
+            });
         }
 
-        if (mode != block_set_mode::destroy)
-            ((base_objects::spherical_bounds_chunk)bounds).enum_points([&](int64_t x, int64_t z) {
-                WORLD_ASYNC_RUN(notify_chunk_blocks, x, z);
+        if (mode != block_set_mode::destroy) {
+            std::unique_lock journal_lock(block_changes_mutex);
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                mark_block_changed(x, y, z);
             });
+        }
     }
 
     void world_data::set_block_range(base_objects::spherical_bounds_block bounds, list_array<base_objects::full_block_data>&& blocks, block_set_mode mode) {
         if (blocks.size() == bounds.count()) {
             size_t i = 0;
-            locked([&](storage::world_data& world) {
+            locked(lock_region_of(bounds), [&](storage::world_data& world) {
                 bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
                     world.__set_block_silent(std::move(blocks[i++]), x, y, z, mode);
                 });
-                ((base_objects::spherical_bounds_chunk)bounds).enum_points([&](int64_t x, int64_t z) {
-                    get_light_processor()->process_chunk(world, x, z);
-                });
+            });
+            //light processor reads neighbor chunks, so it runs after shards released
+            ((base_objects::spherical_bounds_chunk)bounds).enum_points([&](int64_t x, int64_t z) {
+                get_light_processor()->process_chunk(*this, x, z);
             });
         } else {
             size_t i = 0;
             size_t max = blocks.size();
-            locked([&](storage::world_data& world) {
+            locked(lock_region_of(bounds), [&](storage::world_data& world) {
                 bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
                     if (i == max)
                         return;
                     world.__set_block_silent(std::move(blocks[i++]), x, y, z, mode);
                     ++i;
                 });
-                ((base_objects::spherical_bounds_chunk)bounds).enum_points([&](int64_t x, int64_t z) {
-                    get_light_processor()->process_chunk(world, x, z);
-                });
             });
-        }
-        if (mode != block_set_mode::destroy)
+            //light processor reads neighbor chunks, so it runs after shards released
             ((base_objects::spherical_bounds_chunk)bounds).enum_points([&](int64_t x, int64_t z) {
-                WORLD_ASYNC_RUN(notify_chunk_blocks, x, z);
+                get_light_processor()->process_chunk(*this, x, z);
             });
+        }
+        if (mode != block_set_mode::destroy) {
+            std::unique_lock journal_lock(block_changes_mutex);
+            bounds.enum_points([&](int64_t x, int64_t y, int64_t z) {
+                mark_block_changed(x, y, z);
+            });
+        }
     }
 
     int32_t world_data::get_biome(int64_t global_x, int64_t global_y_raw, int64_t global_z) {
         uint32_t res = 0;
         TO_WORLD_POS_GLOBAL(global_y, global_y_raw);
-        get_sub_chunk(global_x >> 4, global_y >> 4, global_z >> 4, [&](sub_chunk_data& sub_chunk) {
+        view_sub_chunk(global_x >> 4, global_y >> 4, global_z >> 4, [&](const sub_chunk_data& sub_chunk) {
             res = sub_chunk.get_biome(global_x & 15, global_y & 15, global_z & 15);
         });
         return res;
     }
 
     void world_data::set_biome(int64_t global_x, int64_t global_y_raw, int64_t global_z, int32_t biome_id) {
+        if (auto region = deferring_region(global_x >> 4, global_z >> 4); region) {
+            region->deferred.push_back([=, this] { set_biome(global_x, global_y_raw, global_z, biome_id); });
+            return;
+        }
         TO_WORLD_POS_GLOBAL(global_y, global_y_raw);
         get_sub_chunk(global_x >> 4, global_y >> 4, global_z >> 4, [&](sub_chunk_data& sub_chunk) {
             sub_chunk.set_biome(global_x & 15, global_y & 15, global_z & 15, biome_id);
@@ -2606,20 +2857,26 @@ namespace copper_server::storage {
         if (entity->world_syncing_data)
             throw std::runtime_error("Entity already registered in another world");
         std::unique_lock lock(mutex);
-        uint64_t id = local_entity_id_generator++;
-        while (entities.contains(id))
+        base_objects::cubic_bounds_chunk_radius processing_region((int64_t)convert_chunk_global_pos(entity->position.x), (int64_t)convert_chunk_global_pos(entity->position.z), entity->const_data().max_track_distance);
+        uint64_t id;
+        {
+            fast_task::write_lock entities_lock(entities_mutex);
             id = local_entity_id_generator++;
-
-        base_objects::cubic_bounds_chunk_radius processing_region((int64_t)entity->position.x, (int64_t)entity->position.z, entity->const_data().max_track_distance);
-
-        entity->world_syncing_data = std::make_optional<base_objects::entity::world_syncing>(
-            bit_list_array(),
-            processing_region,
-            id,
-            this
-        );
-        entity->world_syncing_data->flush_processing();
-        entities[id] = entity;
+            while (entities.contains(id))
+                id = local_entity_id_generator++;
+
+            entity->world_syncing_data = std::make_optional<base_objects::entity::world_syncing>(
+                base_objects::world::chunk_bitmap(),
+                processing_region,
+                id,
+                this
+            );
+            entity->world_syncing_data->flush_processing();
+            entities[id] = entity;
+            index_entity(*entity, entity->position);
+            std::unique_lock tracker_lock(entity_tracker_mutex);
+            entities_tracker.track(id, &*entity, entity->position, entity->const_data().track_tick_interval);
+        }
         to_load_entities[id] = entity;
         entity_init(*entity);
         if (auto loading_level = entity->const_data().loading_ticket_level; loading_level <= 44)
@@ -2630,24 +2887,175 @@ namespace copper_server::storage {
         std::unique_lock lock(mutex);
         if (entity->world_syncing_data) {
             entity_deinit(*entity);
-            entities.erase(entity->world_syncing_data->assigned_world_id);
             to_load_entities.erase(entity->world_syncing_data->assigned_world_id);
+            fast_task::write_lock entities_lock(entities_mutex);
+            {
+                std::unique_lock index_lock(entity_index_mutex);
+                entities_index.remove(entity->world_syncing_data->assigned_world_id);
+            }
+            {
+                std::unique_lock tracker_lock(entity_tracker_mutex);
+                entities_tracker.remove(entity->world_syncing_data->assigned_world_id);
+            }
+            entities.erase(entity->world_syncing_data->assigned_world_id);
             entity->world_syncing_data = std::nullopt;
         }
     }
 
     void world_data::change_chunk_generator(const std::string& id) {
         std::unique_lock lock(mutex);
+        std::unique_lock processor_lock(light_processor_mutex);
         light_processor = nullptr;
         light_processor_id = id;
     }
 
     void world_data::change_light_processor(const std::string& id) {
         std::unique_lock lock(mutex);
+        std::unique_lock processor_lock(light_processor_mutex);
         light_processor = nullptr;
         light_processor_id = id;
     }
 
+    struct world_data::tick_region {
+        int64_t region_x;
+        int64_t region_z;
+        list_array<base_objects::atomic_holder<chunk_data>> chunks;
+        list_array<base_objects::atomic_holder<chunk_data>> idle;
+        list_array<std::function<void()>> deferred;
+    };
+
+    world_data::tick_region* world_data::current_tick_region() {
+        if (!parallel_tick_active && !serial_tick_active)
+            return nullptr;
+        std::unique_lock lock(ticking_regions_mutex);
+        if (auto it = ticking_regions.find(fast_task::this_task::get_id()); it != ticking_regions.end())
+            return it->second;
+        return nullptr;
+    }
+
+    world_data::tick_region* world_data::deferring_region(int64_t chunk_x, int64_t chunk_z) {
+        auto region = current_tick_region();
+        if (!region)
+            return nullptr;
+        if ((chunk_x >> tick_region_shift) == region->region_x && (chunk_z >> tick_region_shift) == region->region_z)
+            return nullptr;
+        return region;
+    }
+
+    void world_data::check_tick_access(int64_t chunk_x, int64_t chunk_z) {
+        if (!parallel_tick_active)
+            return;
+        auto region = current_tick_region();
+        if (!region)
+            return;
+        int64_t region_x = chunk_x >> tick_region_shift;
+        int64_t region_z = chunk_z >> tick_region_shift;
+        if (region_x == region->region_x && region_z == region->region_z)
+            return;
+        //regions of other colors are not ticked in this phase, only same colored regions could race
+        if (((region_x ^ region->region_x) & 1) || ((region_z ^ region->region_z) & 1))
+            return;
+        log::warn(
+            "world",
+            "Non deterministic access in world " + world_name
+                + ": tick of region " + std::to_string(region->region_x) + ", " + std::to_string(region->region_z)
+                + " touched chunk " + std::to_string(chunk_x) + ", " + std::to_string(chunk_z)
+        );
+    }
+
+    bool world_data::tick_chunk(chunk_data& chunk, std::mt19937& random_engine, std::chrono::high_resolution_clock::time_point current_time) {
+        list_array<base_objects::entity_ref> ticking_entities;
+        bool has_work;
+        //serial tick uses region of ticked chunk, so changes of other regions are deferred same as in parallel tick
+        tick_region serial{chunk.chunk_x >> tick_region_shift, chunk.chunk_z >> tick_region_shift};
+        bool serial_mode = !current_tick_region();
+        size_t task_id = fast_task::this_task::get_id();
+        if (serial_mode) {
+            std::unique_lock lock(ticking_regions_mutex);
+            ticking_regions[task_id] = &serial;
+            serial_tick_active = true;
+        }
+        auto unregister = [&] {
+            if (!serial_mode)
+                return;
+            std::unique_lock lock(ticking_regions_mutex);
+            ticking_regions.erase(task_id);
+            serial_tick_active = false;
+        };
+        try {
+            //shards of neighbors are locked upfront in ascending order, so block tick handlers could read them without breaking lock order
+            auto shard_locks = lock_shards({chunk.chunk_x - 1, chunk.chunk_z - 1, chunk.chunk_x + 1, chunk.chunk_z + 1});
+            has_work = chunk.tick(*this, random_tick_speed, random_engine, current_time, ticking_entities);
+        } catch (...) {
+            unregister();
+            throw;
+        }
+        unregister();
+        serial.deferred.for_each([](auto& action) { action(); });
+        //entity tick could use entity registry or move entity to other section, so it is not done under shard lock
+        ticking_entities.for_each([](auto& entity) { entity->tick(); });
+        return has_work;
+    }
+
+    void world_data::tick_chunks_parallel(list_array<base_objects::atomic_holder<chunk_data>>& to_tick_chunks, list_array<base_objects::atomic_holder<chunk_data>>& idle_chunks, std::chrono::high_resolution_clock::time_point current_time) {
+        //ordered map, merge order must not depend from hash or task scheduling
+        std::map<std::pair<int64_t, int64_t>, tick_region> regions;
+        to_tick_chunks.for_each([&](auto& chunk) {
+            std::pair<int64_t, int64_t> pos{chunk->chunk_x >> tick_region_shift, chunk->chunk_z >> tick_region_shift};
+            auto& region = regions.try_emplace(pos, tick_region{pos.first, pos.second}).first->second;
+            region.chunks.push_back(chunk);
+        });
+
+        std::array<list_array<tick_region*>, 4> phases;
+        for (auto& [pos, region] : regions)
+            phases[(pos.first & 1) | ((pos.second & 1) << 1)].push_back(&region);
+
+        parallel_tick_active = true;
+        try {
+            for (auto& phase : phases) {
+                future::forEach(phase, [&, this](tick_region* region) {
+                    //each region has own engine seeded from world seed, so result does not depend from worker count
+                    std::seed_seq seed{
+                        uint32_t(hashed_seed_value),
+                        uint32_t(hashed_seed_value >> 32),
+                        uint32_t(tick_counter),
+                        uint32_t(region->region_x),
+                        uint32_t(region->region_z)
+                    };
+                    std::mt19937 random_engine(seed);
+                    size_t task_id = fast_task::this_task::get_id();
+                    {
+                        std::unique_lock lock(ticking_regions_mutex);
+                        ticking_regions[task_id] = region;
+                    }
+                    try {
+                        region->chunks.for_each([&](auto& chunk) {
+                            if (!tick_chunk(*chunk, random_engine, current_time))
+                                region->idle.push_back(chunk);
+                        });
+                    } catch (...) {
+                        std::unique_lock lock(ticking_regions_mutex);
+                        ticking_regions.erase(task_id);
+                        throw;
+                    }
+                    std::unique_lock lock(ticking_regions_mutex);
+                    ticking_regions.erase(task_id);
+                })->wait();
+
+                //merge phase
+                for (auto region : phase) {
+                    region->deferred.for_each([](auto& action) { action(); });
+                    region->deferred.clear();
+                    idle_chunks.push_back(std::move(region->idle));
+                }
+            }
+        } catch (...) {
+            parallel_tick_active = false;
+            throw;
+        }
+        parallel_tick_active = false;
+    }
+
     void world_data::tick(std::mt19937& random_engine, std::chrono::high_resolution_clock::time_point current_time) {
         std::unique_lock lock(mutex);
 
@@ -2655,16 +3063,6 @@ namespace copper_server::storage {
         list_array<base_objects::atomic_holder<chunk_data>> to_tick_chunks;
         list_array<size_t> expired_tickets;
 
-        for (auto& [x, x_axis] : chunks) {
-            for (auto& [z, z_axis] : x_axis) {
-                if (z_axis)
-                    if (z_axis->load_level <= 44)
-                        z_axis->load_level++;
-            }
-        }
-
-        std::unordered_map<int64_t, std::unordered_set<int64_t>> loading_tickets_cc;
-        size_t target_load_count = 0;
         for (auto& [id, ticket] : loading_tickets) {
             bool expired = false;
             std::visit(
@@ -2679,6 +3077,7 @@ namespace copper_server::storage {
                         if (!expr(*this, id, ticket))
                             expired = true;
                     } else if constexpr (std::is_same_v<T, base_objects::world::loading_point_ticket::entity_bound_ticket>) {
+                        fast_task::read_lock entities_lock(entities_mutex);
                         if (auto it = entities.find(expr.id); it != entities.end()) {
                             if (it->second->world_syncing_data)
                                 ticket.point = it->second->world_syncing_data->processing_region;
@@ -2692,82 +3091,102 @@ namespace copper_server::storage {
             );
             if (expired)
                 expired_tickets.push_back(id);
-            else if (ticket.level < 44) {
-                to_tick_chunks.reserve(ticket.point.count());
-                ticket.point.enum_points_from_center([&](int64_t x, int64_t z) {
-                    auto& local_x = loading_tickets_cc[x];
-                    if (local_x.contains(z))
-                        return;
-                    local_x.insert(z);
-                    ++target_load_count;
-                    auto res = request_chunk_data(x, z);
-                    if (res->is_ready()) {
-                        res->get()->load_level = std::min<uint8_t>(res->get()->load_level, ticket.level);
-                        if (res->get()->load_level < 33)
-                            to_tick_chunks.push_back(res->get());
-                    }
-                });
-                uint8_t propagation = 44 - ticket.level;
-                if (propagation) {
-                    base_objects::cubic_bounds_chunk_radius_out bounds(ticket.point.center_x, ticket.point.center_z, ticket.point.radius, ticket.point.radius + propagation);
-                    to_tick_chunks.reserve(bounds.count());
-                    bounds.enum_points_from_center_w_layer_no_center([&](int64_t x, int64_t z, int64_t layer) {
-                        auto set_load_level = propagation + layer;
-                        if (set_load_level <= 33) {
-                            auto& local_x = loading_tickets_cc[x];
-                            if (local_x.contains(z))
-                                return;
-                            local_x.insert(z);
-                            ++target_load_count;
-                            auto res = request_chunk_data(x, z);
-                            if (res->is_ready()) {
-                                res->get()->load_level = (uint8_t)std::min<int64_t>(res->get()->load_level, set_load_level);
-                                if (res->get()->load_level < 32)
-                                    to_tick_chunks.push_back(res->get());
-                            }
-                        } else if (set_load_level <= 44)
-                            request_chunk_gen(x, z);
-                    });
-                }
-            }
+            else
+                ticket_levels.set(id, ticket.point, ticket.level);
         }
         expired_tickets.for_each([&](size_t id) {
             loading_tickets.erase(id);
+            ticket_levels.remove(id);
         });
 
+        //processors may change processing region or position directly, index catches up once per tick
+        {
+            fast_task::read_lock entities_lock(entities_mutex);
+            std::unique_lock index_lock(entity_index_mutex);
+            for (auto& [id, entity] : entities)
+                if (entity->world_syncing_data)
+                    entities_index.update(
+                        id,
+                        &*entity,
+                        entity->world_syncing_data->processing_region,
+                        (int64_t)convert_chunk_global_pos(entity->position.x),
+                        (int64_t)convert_chunk_global_pos(entity->position.z)
+                    );
+        }
+
+        //only chunks around added, moved or removed tickets are recomputed
+        if (ticket_levels.has_changes())
+            ticket_levels.flush([&](int64_t x, int64_t z, uint8_t old_level, uint8_t new_level) {
+                ticket_load_target += (new_level <= 33) - (old_level <= 33);
+                apply_ticket_level(x, z, new_level);
+            });
+        for (auto& entry : pending_ticket_loads) {
+            auto res = request_chunk_data(entry.x(), entry.z());
+            if (res->is_ready()) {
+                if (res->get())
+                    apply_ticket_level(entry.x(), entry.z(), ticket_levels.level_of(entry.x(), entry.z()));
+                else
+                    pending_ticket_loads.erase(entry.x(), entry.z());
+            }
+        }
+        //chunks leaving ticking set are marked again by `apply_ticket_level` when they return
+        for (auto& shard : chunk_shards) {
+            std::unique_lock shard_lock(shard.mutex);
+            for (auto& entry : shard.active) {
+                if (auto chunk = ticking_chunks.find(entry.x(), entry.z()); chunk)
+                    to_tick_chunks.push_back(*chunk);
+                else
+                    shard.active.erase(entry.x(), entry.z());
+            }
+        }
+
         for (auto& [id, entity] : to_load_entities) {
             auto chunk = request_chunk_data_weak_gen((int64_t)convert_chunk_global_pos(entity->position.x), (int64_t)convert_chunk_global_pos(entity->position.z));
             if (chunk) {
                 if ((*chunk)->generator_stage == 0xFF) {
                     TO_WORLD_POS_GLOBAL(y_level, entity->position.y);
-                    (*chunk)->sub_chunks[convert_chunk_global_pos(y_level)].stored_entities.insert({id, entity});
+                    auto& shard = shard_of((*chunk)->chunk_x, (*chunk)->chunk_z);
+                    std::unique_lock shard_lock(shard.mutex);
+                    (*chunk)->sub_chunks[convert_chunk_global_pos(y_level)].edit().stored_entities.insert({id, entity});
+                    shard.active((*chunk)->chunk_x, (*chunk)->chunk_z) = true;
                 }
             }
         }
         to_load_entities.clear();
         lock.unlock();
         tick_counter++;
+        list_array<base_objects::atomic_holder<chunk_data>> idle_chunks;
         if (!profiling.enable_world_profiling) {
-            to_tick_chunks.for_each([&](auto&& chunk) {
-                chunk->tick(*this, random_tick_speed, random_engine, current_time);
-            });
+            if (parallel_ticking)
+                tick_chunks_parallel(to_tick_chunks, idle_chunks, current_time);
+            else
+                to_tick_chunks.for_each([&](auto&& chunk) {
+                    if (!tick_chunk(*chunk, random_engine, current_time))
+                        idle_chunks.push_back(chunk);
+                });
         } else {
-            profiling.chunk_target_to_load = target_load_count;
+            profiling.chunk_target_to_load = ticket_load_target;
             const auto tick_speed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(1) / ticks_per_second);
             auto tick_local_time = std::chrono::high_resolution_clock::now();
-            to_tick_chunks.for_each([&](auto&& chunk) {
-                chunk->tick(*this, random_tick_speed, random_engine, current_time);
-
-                auto actual_time = std::chrono::high_resolution_clock::now();
-                auto current_tick_speed = std::chrono::duration_cast<std::chrono::milliseconds>(actual_time - tick_local_time);
-                auto slow_chunk_threshold = tick_speed * profiling.slow_chunk_tick_callback_threshold;
-                if (slow_chunk_threshold < current_tick_speed)
-                    if (profiling.slow_chunk_tick_callback)
-                        profiling.slow_chunk_tick_callback(*this, chunk->chunk_x, chunk->chunk_z, current_tick_speed);
-                tick_local_time = actual_time;
-                if (profiling.chunk_speedometer_callback)
-                    profiling.chunk_speedometer_callback(*this, chunk->chunk_x, chunk->chunk_z, current_tick_speed);
-            });
+            //per chunk timings are not collected in parallel mode
+            if (parallel_ticking) {
+                tick_chunks_parallel(to_tick_chunks, idle_chunks, current_time);
+                tick_local_time = std::chrono::high_resolution_clock::now();
+            } else
+                to_tick_chunks.for_each([&](auto&& chunk) {
+                    if (!tick_chunk(*chunk, random_engine, current_time))
+                        idle_chunks.push_back(chunk);
+
+                    auto actual_time = std::chrono::high_resolution_clock::now();
+                    auto current_tick_speed = std::chrono::duration_cast<std::chrono::milliseconds>(actual_time - tick_local_time);
+                    auto slow_chunk_threshold = tick_speed * profiling.slow_chunk_tick_callback_threshold;
+                    if (slow_chunk_threshold < current_tick_speed)
+                        if (profiling.slow_chunk_tick_callback)
+                            profiling.slow_chunk_tick_callback(*this, chunk->chunk_x, chunk->chunk_z, current_tick_speed);
+                    tick_local_time = actual_time;
+                    if (profiling.chunk_speedometer_callback)
+                        profiling.chunk_speedometer_callback(*this, chunk->chunk_x, chunk->chunk_z, current_tick_speed);
+                });
             if (profiling.chunk_speedometer_callback)
                 profiling.chunk_speedometer_callback(*this, INT64_MAX, INT64_MAX, std::chrono::milliseconds(0));
             ++profiling.got_ticks;
@@ -2786,6 +3205,18 @@ namespace copper_server::storage {
                 if (profiling.slow_world_tick_callback)
                     profiling.slow_world_tick_callback(*this, std::chrono::duration_cast<std::chrono::milliseconds>(current_tick_speed));
         }
+        flush_entity_tracker();
+        flush_block_changes();
+        //chunk could get work from other chunk after its own tick, so idle chunks are rechecked under shard lock
+        idle_chunks.for_each([&](auto& chunk) {
+            auto& shard = shard_of(chunk->chunk_x, chunk->chunk_z);
+            std::unique_lock shard_lock(shard.mutex);
+            if (!chunk->has_tick_work()) {
+                shard.active.erase(chunk->chunk_x, chunk->chunk_z);
+                //entities could left sections and edits could make them uniform again, so they may be shared
+                chunk->share_uniform_sections();
+            }
+        });
         if (tick_counter % api::configuration::get().world.auto_save == 0) {
             save_chunks();
         }
@@ -2797,26 +3228,20 @@ namespace copper_server::storage {
             if (on_load_process.empty() && on_save_process.empty())
                 return true;
 
-        for (auto& [x, x_axis] : chunks) {
-            bool chunk_unloaded = false;
-            do {
-                chunk_unloaded = false;
-                auto begin = x_axis.begin();
-                auto end = x_axis.end();
-                while (begin != end && unload_limit) {
-                    if (begin->second)
-                        if (begin->second->load_level > 44) {
-                            make_save(x, begin->first, begin, true);
-                            --unload_limit;
-                            chunk_unloaded = true;
-                            break;
-                        }
-                    ++begin;
-                }
-                if (!unload_limit)
-                    return false;
-            } while (chunk_unloaded);
-        }
+        //chunks erased only when save completes, so single pass is enough
+        for_each_chunk_entry([&](auto& item) {
+            if (!item.value)
+                return;
+            //chunks without ticket level decays by one per tick, ticketed chunks gets their level in `tick`
+            if (item.value->load_level <= loading_levels::max_level && ticket_levels.level_of(item.x(), item.z()) == loading_levels::unloaded_level)
+                item.value->load_level++;
+            if (!unload_limit)
+                return;
+            if (item.value->load_level > loading_levels::max_level && !on_save_process.contains({item.x(), item.z()})) {
+                make_save(item.x(), item.z(), item.value, true);
+                --unload_limit;
+            }
+        });
         return false;
     }
 
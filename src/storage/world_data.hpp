@@ -8,9 +8,11 @@
  */
 #ifndef SRC_STORAGE_WORLD_DATA
 #define SRC_STORAGE_WORLD_DATA
+#include <array>
 #include <atomic>
 #include <bitset>
 #include <filesystem>
+#include <optional>
 #include <random>
 #include <string>
 #include <vector>
@@ -23,11 +25,19 @@
 #include <src/base_objects/entity/animation.hpp>
 #include <src/base_objects/entity/event.hpp>
 #include <src/base_objects/events/event.hpp>
+#include <src/base_objects/network/response.hpp>
 #include <src/base_objects/weather.hpp>
 #include <src/base_objects/world/block_action.hpp>
 #include <src/base_objects/world/height_maps.hpp>
 #include <src/base_objects/world/loading_point_ticket.hpp>
 #include <src/base_objects/world/sub_chunk_data.hpp>
+#include <src/storage/block_change_journal.hpp>
+#include <src/storage/chunk_map.hpp>
+#include <src/storage/entity_index.hpp>
+#include <src/storage/entity_tracker.hpp>
+#include <src/storage/loading_levels.hpp>
+#include <src/storage/region_file.hpp>
+#include <src/storage/tick_schedule.hpp>
 #include <src/util/calculations.hpp>
 #include <src/util/task_management.hpp>
 
@@ -80,52 +90,81 @@ namespace copper_server::storage {
     class world_data;
     class worlds_data;
 
+    //serialized packet of chunk shared by all viewers
+    //it is built by first viewer which needs it and kept until key changes, concurrent callers with same key wait for single build
+    class chunk_packet_cache {
+    public:
+        using encoded = std::shared_ptr<const base_objects::network::response::item>;
+
+        encoded get(uint64_t key, const std::function<base_objects::network::response::item()>& build) const;
+        void reset();
+
+    private:
+        mutable fast_task::task_mutex mutex;
+        mutable uint64_t cached_key = 0;
+        mutable encoded cached;
+    };
+
     class chunk_data {
         friend world_data;
-        bool load(const std::filesystem::path& chunk_z, uint64_t tick_counter, world_data& world);
+        bool load(std::istream& stream, uint64_t tick_counter, world_data& world);
         bool load(const enbt::compound_const_ref& chunk_data, uint64_t tick_counter, world_data& world);
-        bool save(const std::filesystem::path& chunk_z, uint64_t tick_counter, world_data& world);
+        bool save(std::ostream& stream, uint64_t tick_counter, world_data& world);
 
     public:
         base_objects::world::height_maps height_maps;
-        std::vector<base_objects::world::sub_chunk_data> sub_chunks;
+        std::vector<base_objects::world::sub_chunk_handle> sub_chunks;
 
         //instead of using negative values for priority, schedule ticks in reverse order
         // -1 == 1, -2 == 2, etc... means higher value == lower priority
-        list_array<list_array<std::pair<uint64_t, base_objects::chunk_block_pos>>> queried_for_tick;
-        list_array<std::pair<uint64_t, base_objects::chunk_block_pos>> queried_for_liquid_tick;
+        //positions stores y from bottom of the chunk
+        tick_schedule queried_for_tick;
+        tick_schedule queried_for_liquid_tick;
         const int64_t chunk_x, chunk_z;
         uint8_t load_level = 44;
         uint8_t resume_gen_level = 255; //if load_level would be lower or equal than this, then generation would be resumed, used by generators
         uint8_t generator_stage = 0xFF; //0xFF == the chunk is complete and accessible, should be managed by generator
 
+        chunk_packet_cache packet_cache;
+
         chunk_data(int64_t chunk_x, int64_t chunk_z);
 
+        //grows on every section change or replacement, height maps follows block changes so they are not counted separately
+        uint64_t revision() const;
+
         void update_height_map_on(uint8_t local_x, uint64_t local_y, uint8_t local_z);
         void update_height_map();
 
-        void for_each_entity(std::function<void(base_objects::entity_ref& entity)> func);
-        void for_each_entity(uint64_t local_y, std::function<void(base_objects::entity_ref& entity)> func);
+        void for_each_entity(std::function<void(const base_objects::entity_ref& entity)> func);
+        void for_each_entity(uint64_t local_y, std::function<void(const base_objects::entity_ref& entity)> func);
 
         void for_each_block_entity(std::function<void(base_objects::block& block, enbt::value& extended_data)> func);
         void for_each_block_entity(uint64_t local_y, std::function<void(base_objects::block& block, enbt::value& extended_data)> func);
 
+        //mutable access for writers, shared sections are copied only when `func` changed them, reads should use `view_sub_chunk`
         void for_each_sub_chunk(std::function<void(base_objects::world::sub_chunk_data& sub_chunk)> func);
         void get_sub_chunk(uint64_t local_y, std::function<void(base_objects::world::sub_chunk_data& sub_chunk)> func);
+        void view_sub_chunk(uint64_t local_y, std::function<void(const base_objects::world::sub_chunk_data& sub_chunk)> func) const;
+        //replaces uniform sections with shared instances
+        void share_uniform_sections();
 
         //priority accepts only negative values
         void query_for_tick(uint8_t local_x, uint64_t local_y, uint8_t local_z, uint64_t on_tick, int8_t priority = -1);
         void query_for_liquid_tick(uint8_t local_x, uint64_t local_y, uint8_t local_z, uint64_t on_tick);
 
 
-        void tick(world_data& world, size_t random_tick_speed, std::mt19937& random_engine, std::chrono::high_resolution_clock::time_point current_time);
+        //returns false when chunk has nothing to tick left, then world drops it from active set
+        //called under shard lock, entities which should be ticked are appended to `ticking_entities` and ticked by caller after lock released
+        bool tick(world_data& world, size_t random_tick_speed, std::mt19937& random_engine, std::chrono::high_resolution_clock::time_point current_time, list_array<base_objects::entity_ref>& ticking_entities);
+        //scheduled ticks, tickable blocks or ticking entities
+        bool has_tick_work() const;
 
 
         //generator functions
         void gen_set_block(const base_objects::full_block_data& block, uint8_t local_x, uint64_t local_y, uint8_t local_z);
         void gen_set_block(base_objects::full_block_data&& block, uint8_t local_x, uint64_t local_y, uint8_t local_z);
         void gen_remove_block(uint8_t local_x, uint64_t local_y, uint8_t local_z);
-        base_objects::full_block_data_ref gen_get_block(uint8_t local_x, uint64_t local_y, uint8_t local_z);
+        base_objects::full_block_data gen_get_block(uint8_t local_x, uint64_t local_y, uint8_t local_z) const;
     };
 
     class chunk_generator {
@@ -244,13 +283,100 @@ namespace copper_server::storage {
     };
 
     class world_data {
-        using chunk_row = std::unordered_map<uint64_t, base_objects::atomic_holder<chunk_data>>;
-        using chunk_column = std::unordered_map<uint64_t, chunk_row>;
+        using chunk_column = chunk_map<base_objects::atomic_holder<chunk_data>>;
         uint64_t hashed_seed_value = 0;
 
+        //locking protocol, locks must be acquired only in this order:
+        //  1. `mutex`          - world state: tickets, load/save/generate processes, settings, light processor
+        //  2. `entities_mutex` - entity registry, notifications takes read lock, (un)registration takes write lock
+        //  3. chunk shards     - loaded chunks of one shard, multiple shards locked only in ascending index order
+        //`entity_index_mutex`, `entity_tracker_mutex` and `block_changes_mutex` are leaf locks, entity callbacks are never called under them
+        //code that runs under shard lock must not acquire `mutex`, `entities_mutex` or other shard, cross-region changes
+        //uses `locked(bounds, ...)` which locks all involved shards upfront, entity processors must not (un)register entities synchronously
+        //chunk tick holds shards of ticked chunk and its neighbors, so game workers never see half applied tick, entities are ticked after they released
+        //block tick handlers runs under these locks, their changes of other tick regions are deferred in both serial and parallel tick
+        struct chunk_shard {
+            fast_task::task_recursive_mutex mutex;
+            chunk_column chunks;
+            chunk_map<bool> active; //chunks which may have tick work, only these are visited by `tick`
+        };
+
+        static constexpr size_t chunk_shards_count = 64;
+        static constexpr int64_t chunk_shard_region_shift = 5; //32x32 chunks per region, same as region files
+
         fast_task::task_recursive_mutex mutex;
-        chunk_column chunks;
+        fast_task::task_rw_mutex entities_mutex;
+        std::array<chunk_shard, chunk_shards_count> chunk_shards;
         base_objects::atomic_holder<chunk_light_processor> light_processor;
+        fast_task::task_mutex light_processor_mutex;
+
+        static size_t shard_index(int64_t chunk_x, int64_t chunk_z);
+
+        chunk_shard& shard_of(int64_t chunk_x, int64_t chunk_z) {
+            return chunk_shards[shard_index(chunk_x, chunk_z)];
+        }
+
+        //nullopt if chunk not present, holder is empty when chunk only known to be saved
+        std::optional<base_objects::atomic_holder<chunk_data>> find_chunk(int64_t chunk_x, int64_t chunk_z);
+        void store_chunk(int64_t chunk_x, int64_t chunk_z, const base_objects::atomic_holder<chunk_data>& chunk);
+        //`mutex` must be held, chunk still wanted by tickets is requested again on next tick
+        bool remove_chunk(int64_t chunk_x, int64_t chunk_z);
+
+        //locks shards one by one, `func(chunk_map::entry&)` must not insert chunks
+        template <class FN>
+        void for_each_chunk_entry(FN&& func) {
+            for (auto& shard : chunk_shards) {
+                std::unique_lock lock(shard.mutex);
+                for (auto& entry : shard.chunks)
+                    func(entry);
+            }
+        }
+
+        //locks only shard of chunk, `func(chunk_data&)` called if chunk loaded
+        template <class FN>
+        void with_chunk(int64_t chunk_x, int64_t chunk_z, FN&& func) {
+            auto& shard = shard_of(chunk_x, chunk_z);
+            if (parallel_tick_determinism_check)
+                check_tick_access(chunk_x, chunk_z);
+            std::unique_lock lock(shard.mutex);
+            if (auto chunk = shard.chunks.find(chunk_x, chunk_z); chunk)
+                if (*chunk)
+                    func(**chunk);
+        }
+
+        //same as `with_chunk`, but also marks chunk as active, used for every access which may add tick work
+        template <class FN>
+        void edit_chunk(int64_t chunk_x, int64_t chunk_z, FN&& func) {
+            auto& shard = shard_of(chunk_x, chunk_z);
+            if (parallel_tick_determinism_check)
+                check_tick_access(chunk_x, chunk_z);
+            std::unique_lock lock(shard.mutex);
+            if (auto chunk = shard.chunks.find(chunk_x, chunk_z); chunk)
+                if (*chunk) {
+                    func(**chunk);
+                    shard.active(chunk_x, chunk_z) = true;
+                }
+        }
+
+        void mark_active(int64_t chunk_x, int64_t chunk_z);
+
+        //parallel tick, chunks grouped to 8x8 regions colored as checkerboard
+        //regions of the same color are never adjacent, so each color phase ticks its regions concurrently
+        //changes from region tick which targets other region are deferred to merge phase after each color phase
+        struct tick_region;
+        static constexpr int64_t tick_region_shift = 3;
+        std::atomic_bool parallel_tick_active = false;
+        std::atomic_bool serial_tick_active = false; //serial tick registers region of ticked chunk in `ticking_regions`
+        fast_task::task_mutex ticking_regions_mutex; //leaf lock
+        std::unordered_map<size_t, tick_region*> ticking_regions; //task id => region ticked by this task
+
+        void tick_chunks_parallel(list_array<base_objects::atomic_holder<chunk_data>>& to_tick_chunks, list_array<base_objects::atomic_holder<chunk_data>>& idle_chunks, std::chrono::high_resolution_clock::time_point current_time);
+        //ticks chunk under its shard lock, returns false when chunk has nothing to tick left
+        bool tick_chunk(chunk_data& chunk, std::mt19937& random_engine, std::chrono::high_resolution_clock::time_point current_time);
+        tick_region* current_tick_region();
+        //returns region of current region tick if chunk belongs to other region, changes then must be pushed to `deferred`
+        tick_region* deferring_region(int64_t chunk_x, int64_t chunk_z);
+        void check_tick_access(int64_t chunk_x, int64_t chunk_z);
 
         std::unordered_map<util::XY<int64_t>, FuturePtr<base_objects::atomic_holder<chunk_data>>> on_generate_process;
 
@@ -292,21 +418,49 @@ namespace copper_server::storage {
         friend class worlds_data;
         std::string preview_world_name();
         std::filesystem::path path;
+        region_storage regions;
 
         std::unordered_map<util::XY<int64_t>, FuturePtr<base_objects::atomic_holder<chunk_data>>> on_load_process;
         std::unordered_map<util::XY<int64_t>, FuturePtr<bool>> on_save_process;
         std::unordered_map<size_t, base_objects::entity_ref> entities;
+        fast_task::task_mutex entity_index_mutex;
+        entity_index entities_index;
+        //entities with processor which processing region covers chunk, `entities_mutex` must be held while result used
+        list_array<base_objects::entity*> viewers_of(int64_t chunk_x, int64_t chunk_z);
+        list_array<base_objects::entity*> viewers_of(const base_objects::entity& self);
+        list_array<base_objects::entity*> viewers_of_block(int64_t global_x, int64_t global_z);
+        void index_entity(base_objects::entity& entity, util::VECTOR position);
+        fast_task::task_mutex entity_tracker_mutex;
+        entity_tracker entities_tracker;
+        void track_entity(base_objects::entity& entity, uint8_t changes);
+        //sends accumulated movement to viewers, called once at end of tick
+        void flush_entity_tracker();
+        fast_task::task_mutex block_changes_mutex;
+        block_change_journal block_changes;
+        //`block_changes_mutex` must be held
+        void mark_block_changed(int64_t global_x, int64_t global_y_raw, int64_t global_z);
+        //sends changed blocks to viewers, called once at end of tick
+        void flush_block_changes();
+        //appends registered entities which position is in chunk, `entities_mutex` must be held
+        void collect_entities(int64_t chunk_x, int64_t chunk_z, list_array<base_objects::entity_ref>& res);
         std::unordered_map<size_t, base_objects::entity_ref> to_load_entities;
         size_t local_entity_id_generator = 0;
         size_t world_spawn_ticket_id;
 
+        //derived from `loading_tickets` in `tick`, guarded by `mutex`
+        loading_levels ticket_levels;
+        chunk_map<bool> pending_ticket_loads; //chunks with level 33 or lower which are not loaded yet
+        chunk_column ticking_chunks;          //loaded chunks with level 32 or lower
+        size_t ticket_load_target = 0;        //chunks with level 33 or lower
+        void apply_ticket_level(int64_t chunk_x, int64_t chunk_z, uint8_t level);
+
         std::chrono::high_resolution_clock::time_point last_usage;
 
         FuturePtr<base_objects::atomic_holder<chunk_data>> create_chunk_generate_future(base_objects::atomic_holder<chunk_data>& chunk);
         FuturePtr<base_objects::atomic_holder<chunk_data>> create_chunk_load_future(int64_t chunk_x, int64_t chunk_z, std::function<void(chunk_data& chunk)> callback, std::function<void()> fault);
         FuturePtr<base_objects::atomic_holder<chunk_data>> create_chunk_load_future(int64_t chunk_x, int64_t chunk_z);
         void make_save(int64_t chunk_x, int64_t chunk_z, bool also_unload);
-        void make_save(int64_t chunk_x, int64_t chunk_z, chunk_row::iterator, bool also_unload);
+        void make_save(int64_t chunk_x, int64_t chunk_z, const base_objects::atomic_holder<chunk_data>& chunk, bool also_unload);
         base_objects::atomic_holder<chunk_data> load_chunk_sync(int64_t chunk_x, int64_t chunk_z);
         base_objects::atomic_holder<chunk_data> processed_load_chunk_sync(int64_t chunk_x, int64_t chunk_z, bool is_async_context = false);
 
@@ -395,6 +549,7 @@ namespace copper_server::storage {
         int64_t day_time = 0;
         int64_t time = 0;
         uint64_t random_tick_speed = 3;
+        uint64_t block_changes_resend_threshold = 4096; //changed blocks per chunk in one tick above which whole chunk is resent
         uint64_t ticks_per_second = 20;
         int32_t portal_teleport_boundary = 29999984;
 
@@ -417,6 +572,8 @@ namespace copper_server::storage {
         bool has_skylight : 1 = true;
         bool enable_entity_light_source_updates : 1 = false; //calculated from light processor
         bool enable_entity_light_source_updates_include_rot : 1 = false;
+        bool parallel_ticking : 1 = false;                 //ticks chunk regions on all executors
+        bool parallel_tick_determinism_check : 1 = false; //logs chunk accesses which may race between regions of one phase
 
         const int32_t world_id;
 
@@ -463,6 +620,7 @@ namespace copper_server::storage {
         void for_each_chunk(base_objects::spherical_bounds_chunk bounds, std::function<void(chunk_data& chunk)> func);
         void for_each_sub_chunk(int64_t chunk_x, int64_t chunk_z, std::function<void(base_objects::world::sub_chunk_data& chunk)> func);
         void get_sub_chunk(int64_t chunk_x, int64_t chunk_y, int64_t chunk_z, std::function<void(base_objects::world::sub_chunk_data& chunk)> func);
+        void view_sub_chunk(int64_t chunk_x, int64_t chunk_y, int64_t chunk_z, std::function<void(const base_objects::world::sub_chunk_data& chunk)> func);
         void get_chunk(int64_t chunk_x, int64_t chunk_z, std::function<void(chunk_data& chunk)> func);
 
 
@@ -516,7 +674,12 @@ namespace copper_server::storage {
         void sub_chunk_updated(int64_t chunk_x, int64_t chunk_y, int64_t chunk_z);
 
 
+        //locks whole world, includes all chunk shards
         void locked(std::function<void(world_data& self)> func);
+        //locks only shards of regions which overlaps `bounds`
+        void locked(base_objects::cubic_bounds_chunk bounds, std::function<void(world_data& self)> func);
+        //locks shards of regions which overlaps `bounds` in ascending index order
+        std::vector<std::unique_lock<fast_task::task_recursive_mutex>> lock_shards(base_objects::cubic_bounds_chunk bounds);
 
         void set_block_range(base_objects::cubic_bounds_block bounds, const list_array<base_objects::full_block_data>& blocks, block_set_mode mode = block_set_mode::replace);
         void set_block_range(base_objects::cubic_bounds_block bounds, list_array<base_objects::full_block_data>&& blocks, block_set_mode mode = block_set_mode::replace);
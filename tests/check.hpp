@@ -0,0 +1,23 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#ifndef TESTS_CHECK
+#define TESTS_CHECK
+#include <cstdio>
+#include <cstdlib>
+
+//tests are plain executables, first failed check ends process with non zero code
+#define CHECK(expr)                                                                  \
+    do {                                                                             \
+        if (!(expr)) {                                                               \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            std::exit(1);                                                            \
+        }                                                                            \
+    } while (false)
+
+#endif /* TESTS_CHECK */
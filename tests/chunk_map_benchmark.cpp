@@ -0,0 +1,154 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <src/storage/chunk_map.hpp>
+#include <unordered_map>
+#include <vector>
+
+using copper_server::storage::chunk_map;
+
+//compares chunk_map with nested unordered_map used by world_data before
+//workload is players walking around with view distance, chunks are loaded in front and unloaded behind them
+
+struct nested_map {
+    std::unordered_map<int64_t, std::unordered_map<int64_t, uint64_t>> map;
+
+    uint64_t* find(int64_t x, int64_t z) {
+        auto x_it = map.find(x);
+        if (x_it == map.end())
+            return nullptr;
+        auto z_it = x_it->second.find(z);
+        return z_it == x_it->second.end() ? nullptr : &z_it->second;
+    }
+
+    uint64_t& operator()(int64_t x, int64_t z) {
+        return map[x][z];
+    }
+
+    void erase(int64_t x, int64_t z) {
+        auto x_it = map.find(x);
+        if (x_it == map.end())
+            return;
+        x_it->second.erase(z);
+        if (x_it->second.empty())
+            map.erase(x_it);
+    }
+
+    template <class FN>
+    void for_each(FN&& func) {
+        for (auto& [x, column] : map)
+            for (auto& [z, value] : column)
+                func(x, z, value);
+    }
+};
+
+struct flat_map {
+    chunk_map<uint64_t> map;
+
+    uint64_t* find(int64_t x, int64_t z) {
+        return map.find(x, z);
+    }
+
+    uint64_t& operator()(int64_t x, int64_t z) {
+        return map(x, z);
+    }
+
+    void erase(int64_t x, int64_t z) {
+        map.erase(x, z);
+    }
+
+    template <class FN>
+    void for_each(FN&& func) {
+        for (auto& it : map)
+            func(it.x(), it.z(), it.value);
+    }
+};
+
+struct player {
+    int64_t x;
+    int64_t z;
+    int64_t dx;
+    int64_t dz;
+};
+
+constexpr int64_t view_distance = 12;
+constexpr size_t players = 20;
+constexpr size_t steps = 400;
+
+static std::vector<player> spawn_players() {
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int64_t> pos(-200, 200);
+    std::uniform_int_distribution<int64_t> dir(-1, 1);
+    std::vector<player> res;
+    for (size_t i = 0; i < players; i++)
+        res.push_back({pos(random), pos(random), dir(random), dir(random) ? 1 : -1});
+    return res;
+}
+
+template <class MAP>
+static void run(const char* name) {
+    MAP map;
+    auto walkers = spawn_players();
+    uint64_t checksum = 0;
+    double load = 0;
+    double lookup = 0;
+    double neighbors = 0;
+    double iterate = 0;
+    auto timed = [](double& total, auto&& func) {
+        auto started = std::chrono::steady_clock::now();
+        func();
+        total += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    };
+    for (size_t step = 0; step < steps; step++) {
+        timed(load, [&] {
+            for (auto& it : walkers) {
+                int64_t old_x = it.x;
+                int64_t old_z = it.z;
+                it.x += it.dx;
+                it.z += it.dz;
+                for (int64_t x = old_x - view_distance; x <= old_x + view_distance; x++)
+                    for (int64_t z = old_z - view_distance; z <= old_z + view_distance; z++)
+                        if (std::abs(x - it.x) > view_distance || std::abs(z - it.z) > view_distance)
+                            map.erase(x, z);
+                for (int64_t x = it.x - view_distance; x <= it.x + view_distance; x++)
+                    for (int64_t z = it.z - view_distance; z <= it.z + view_distance; z++)
+                        map(x, z) = uint64_t(x * 31 + z);
+            }
+        });
+        //entities and block updates looks up chunks around players
+        timed(lookup, [&] {
+            for (auto& it : walkers)
+                for (int64_t x = it.x - view_distance; x <= it.x + view_distance; x++)
+                    for (int64_t z = it.z - view_distance; z <= it.z + view_distance; z++)
+                        if (auto value = map.find(x, z))
+                            checksum += *value;
+        });
+        //chunk tick reads 3x3 area
+        timed(neighbors, [&] {
+            map.for_each([&](int64_t x, int64_t z, uint64_t&) {
+                for (int64_t dx = -1; dx <= 1; dx++)
+                    for (int64_t dz = -1; dz <= 1; dz++)
+                        if (auto value = map.find(x + dx, z + dz))
+                            checksum += *value;
+            });
+        });
+        timed(iterate, [&] {
+            map.for_each([&](int64_t, int64_t, uint64_t& value) { checksum += value; });
+        });
+    }
+    std::printf("%-8s load %8.2f ms  lookup %8.2f ms  neighbors %8.2f ms  iterate %8.2f ms  (checksum %llu)\n", name, load * 1000, lookup * 1000, neighbors * 1000, iterate * 1000, (unsigned long long)checksum);
+}
+
+int main() {
+    run<nested_map>("nested");
+    run<flat_map>("flat");
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <src/base_objects/network/compression.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+using namespace copper_server::base_objects::network;
+using packet = std::vector<uint8_t>;
+
+//compares compression backends and per packet zlib initialization used before
+//arguments are files with captured uncompressed packets, one packet per file
+//without arguments generated chunk like packets are used
+
+static void write_varint(packet& out, uint32_t value) {
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out.push_back(value ? byte | 0x80 : byte);
+    } while (value);
+}
+
+//24 sections of layered terrain with few random ores, encoded like chunk data packet
+static packet generate_chunk(std::mt19937& random) {
+    packet out;
+    std::uniform_int_distribution<int> height(60, 72);
+    std::uniform_int_distribution<int> ore(0, 99);
+    int surface = height(random);
+    for (int section = 0; section < 24; section++) {
+        int base = section * 16 - 64;
+        out.push_back(0x10);
+        out.push_back(0x00);
+        if (base + 16 <= surface - 4 && base + 16 > 0) {
+            //stone with ores, 4 bits per entry
+            out.push_back(4);
+            write_varint(out, 4);
+            for (uint32_t id : {1u, 16u, 21u, 3u})
+                write_varint(out, id);
+            for (int i = 0; i < 4096 / 16; i++) {
+                uint64_t value = 0;
+                for (int j = 0; j < 16; j++)
+                    value |= uint64_t(ore(random) < 95 ? 0 : ore(random) % 3 + 1) << (j * 4);
+                for (int b = 7; b >= 0; b--)
+                    out.push_back(uint8_t(value >> (b * 8)));
+            }
+        } else if (base + 16 <= 0 || base > surface) {
+            //uniform section
+            out.push_back(0);
+            write_varint(out, base > surface ? 0 : 1);
+        } else {
+            //surface, 2 bits per entry: air, grass, dirt, stone
+            out.push_back(2);
+            write_varint(out, 4);
+            for (uint32_t id : {0u, 9u, 10u, 1u})
+                write_varint(out, id);
+            for (int i = 0; i < 4096 / 32; i++) {
+                uint64_t value = 0;
+                for (int j = 0; j < 32; j++) {
+                    int y = base + (i * 32 + j) / 256;
+                    uint64_t id = y > surface ? 0 : y == surface ? 1 : y > surface - 4 ? 2 : 3;
+                    value |= id << (j * 2);
+                }
+                for (int b = 7; b >= 0; b--)
+                    out.push_back(uint8_t(value >> (b * 8)));
+            }
+        }
+        //biomes, single value
+        out.push_back(0);
+        write_varint(out, 1);
+    }
+    //light arrays are mostly full or empty
+    for (int section = 0; section < 26; section++) {
+        write_varint(out, 2048);
+        out.insert(out.end(), 2048, section > 9 ? 0xFF : 0x00);
+    }
+    return out;
+}
+
+static packet read_file(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error(std::string("could not open ") + path);
+    return packet(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+//zlib stream initialized and freed for every packet
+static size_t compress_per_packet(const packet& in, packet& out) {
+    z_stream stream{};
+    if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+        throw std::runtime_error("deflateInit failed");
+    out.resize(deflateBound(&stream, (uLong)in.size()));
+    stream.next_in = const_cast<uint8_t*>(in.data());
+    stream.avail_in = (uInt)in.size();
+    stream.next_out = out.data();
+    stream.avail_out = (uInt)out.size();
+    int res = deflate(&stream, Z_FINISH);
+    size_t size = stream.total_out;
+    deflateEnd(&stream);
+    if (res != Z_STREAM_END)
+        throw std::runtime_error("deflate failed");
+    return size;
+}
+
+template <class FN>
+static void run(const char* name, const std::vector<packet>& packets, size_t rounds, FN&& compress) {
+    size_t in_size = 0;
+    size_t out_size = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++)
+        for (auto& it : packets) {
+            in_size += it.size();
+            out_size += compress(it);
+        }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::printf("%-16s %10.1f MiB/s %10.0f packets/s  ratio %.3f\n", name, double(in_size) / seconds / (1 << 20), double(packets.size() * rounds) / seconds, double(out_size) / double(in_size));
+}
+
+int main(int argc, char** argv) {
+    std::vector<packet> packets;
+    if (argc > 1)
+        for (int i = 1; i < argc; i++)
+            packets.push_back(read_file(argv[i]));
+    else {
+        std::mt19937 random(42);
+        for (int i = 0; i < 64; i++)
+            packets.push_back(generate_chunk(random));
+    }
+    constexpr size_t rounds = 20;
+
+    packet out;
+    run("zlib per packet", packets, rounds, [&](const packet& in) { return compress_per_packet(in, out); });
+    for (const char* name : {"zlib", "zlib_fast"}) {
+        auto backend = make_compressor(name);
+        packet check;
+        run(name, packets, rounds, [&](const packet& in) {
+            out.resize(backend->bound(in.size()));
+            return backend->compress(in.data(), in.size(), out.data(), out.size());
+        });
+        //output must stay readable by client
+        for (auto& it : packets) {
+            out.resize(backend->bound(it.size()));
+            size_t size = backend->compress(it.data(), it.size(), out.data(), out.size());
+            check.resize(it.size());
+            backend->decompress(out.data(), size, check.data(), check.size());
+            if (check != it) {
+                std::fprintf(stderr, "%s: round trip mismatch\n", name);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <map>
+#include <random>
+#include <src/storage/loading_levels.hpp>
+#include <tests/check.hpp>
+
+using copper_server::base_objects::cubic_bounds_chunk_radius;
+using copper_server::storage::loading_levels;
+
+struct ticket {
+    cubic_bounds_chunk_radius point;
+    int64_t level;
+};
+
+//direct definition: ticket level inside bounds, one more per chunk outside until `max_level`
+static uint8_t expected_level(const std::map<size_t, ticket>& tickets, int64_t x, int64_t z) {
+    int64_t level = loading_levels::unloaded_level;
+    for (auto& [id, it] : tickets) {
+        if (it.level >= loading_levels::max_level)
+            continue;
+        int64_t distance = std::max(std::abs(x - it.point.center_x), std::abs(z - it.point.center_z)) - it.point.radius;
+        level = std::min<int64_t>(level, std::max<int64_t>(it.level, 0) + std::max<int64_t>(distance, 0));
+    }
+    return uint8_t(std::min<int64_t>(level, loading_levels::unloaded_level));
+}
+
+int main() {
+    std::mt19937 random(12345);
+    loading_levels levels;
+    std::map<size_t, ticket> tickets;
+    std::map<std::pair<int64_t, int64_t>, uint8_t> reported; //levels known from `flush` callbacks
+    constexpr int64_t range = 80;
+
+    auto random_ticket = [&] {
+        std::uniform_int_distribution<int64_t> pos(-20, 20);
+        std::uniform_int_distribution<int64_t> radius(0, 6);
+        std::uniform_int_distribution<int64_t> level(20, 46);
+        return ticket{{pos(random), pos(random), radius(random)}, level(random)};
+    };
+
+    for (size_t step = 0; step < 400; step++) {
+        size_t ops = random() % 4 + 1;
+        for (size_t op = 0; op < ops; op++) {
+            size_t id = random() % 8;
+            switch (random() % 4) {
+            case 0:
+                tickets.erase(id);
+                levels.remove(id);
+                break;
+            case 1:
+                //players usually move by one chunk
+                if (auto it = tickets.find(id); it != tickets.end()) {
+                    it->second.point.center_x += int64_t(random() % 3) - 1;
+                    it->second.point.center_z += int64_t(random() % 3) - 1;
+                    levels.set(id, it->second.point, it->second.level);
+                    break;
+                }
+                [[fallthrough]];
+            default: {
+                auto it = random_ticket();
+                tickets[id] = it;
+                levels.set(id, it.point, it.level);
+                break;
+            }
+            }
+        }
+        levels.flush([&](int64_t x, int64_t z, uint8_t old_level, uint8_t new_level) {
+            auto it = reported.find({x, z});
+            CHECK(old_level == (it == reported.end() ? loading_levels::unloaded_level : it->second));
+            CHECK(old_level != new_level);
+            if (new_level == loading_levels::unloaded_level)
+                reported.erase({x, z});
+            else
+                reported[{x, z}] = new_level;
+        });
+        CHECK(!levels.has_changes());
+        size_t loaded = 0;
+        for (int64_t x = -range; x <= range; x++)
+            for (int64_t z = -range; z <= range; z++) {
+                auto expected = expected_level(tickets, x, z);
+                CHECK(levels.level_of(x, z) == expected);
+                loaded += expected != loading_levels::unloaded_level;
+            }
+        CHECK(levels.size() == loaded);
+        CHECK(reported.size() == loaded);
+    }
+    return 0;
+}
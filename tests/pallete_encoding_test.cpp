@@ -0,0 +1,146 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <algorithm>
+#include <random>
+#include <src/base_objects/pallete_container.hpp>
+#include <tests/check.hpp>
+#include <unordered_map>
+#include <vector>
+
+using namespace copper_server::base_objects;
+using compiled = std::variant<pallete_container_single, pallete_container_indirect, pallete_data>;
+
+//encoding before word packing, value at a time through `add`
+static compiled reference_compile(pallete_container& container) {
+    if (container.unique_pallete.size() == 1)
+        return pallete_container_single{.id_of_palette = *container.unique_pallete.begin()};
+    size_t max_indirect = container.is_biomes_mode ? pallete_container::max_indirect_biomes : pallete_container::max_indirect_blocks;
+    if (container.unique_pallete.size() <= max_indirect) {
+        pallete_container_indirect res(pallete_data::bits_for_max(container.unique_pallete.size()));
+        std::unordered_map<int32_t, size_t> map;
+        res.palette = to_list_array(container.unique_pallete);
+        res.palette.for_each([&map](auto it, size_t index) {
+            map[(int32_t)it] = index;
+        });
+        for (auto it : container.data)
+            res.data.add(map[it]);
+        return res;
+    }
+    pallete_data res(container.bits_per_entry);
+    for (auto it : container.data)
+        res.add(it);
+    return res;
+}
+
+static bool same_bytes(pallete_data& a, pallete_data& b) {
+    if (a.bits_per_entry != b.bits_per_entry)
+        return false;
+    auto& a_bytes = a.get();
+    auto& b_bytes = b.get();
+    if (a_bytes.size() != b_bytes.size())
+        return false;
+    for (size_t i = 0; i < a_bytes.size(); i++)
+        if (a_bytes[i] != b_bytes[i])
+            return false;
+    return true;
+}
+
+static bool same(compiled& a, compiled& b) {
+    if (a.index() != b.index())
+        return false;
+    if (auto single = std::get_if<pallete_container_single>(&a))
+        return single->id_of_palette == std::get<pallete_container_single>(b).id_of_palette;
+    if (auto indirect = std::get_if<pallete_container_indirect>(&a)) {
+        auto& other = std::get<pallete_container_indirect>(b);
+        if (indirect->bits_per_entry != other.bits_per_entry || indirect->palette.size() != other.palette.size())
+            return false;
+        for (size_t i = 0; i < indirect->palette.size(); i++)
+            if (indirect->palette[i] != other.palette[i])
+                return false;
+        return same_bytes(indirect->data, other.data);
+    }
+    return same_bytes(std::get<pallete_data>(a), std::get<pallete_data>(b));
+}
+
+static void check_container(const std::vector<int32_t>& values, size_t max_items, bool biomes) {
+    pallete_container old_way(max_items, biomes);
+    for (auto it : values)
+        old_way.add(size_t(it));
+    auto expected = reference_compile(old_way);
+
+    pallete_container new_way(max_items, biomes);
+    new_way.assign(values.data(), values.size());
+    auto copy_result = new_way.compile();
+    auto move_result = std::move(new_way).compile();
+    CHECK(same(expected, copy_result));
+    CHECK(same(expected, move_result));
+}
+
+//`distinct` values from [0, max_items) spread randomly or in runs like real sections
+static std::vector<int32_t> generate(std::mt19937& random, size_t count, size_t distinct, size_t max_items, bool runs) {
+    std::vector<int32_t> ids;
+    std::uniform_int_distribution<int32_t> id(0, int32_t(max_items - 1));
+    while (ids.size() < distinct) {
+        int32_t value = id(random);
+        if (std::find(ids.begin(), ids.end(), value) == ids.end())
+            ids.push_back(value);
+    }
+    std::vector<int32_t> values;
+    values.reserve(count);
+    //every distinct value is present at least once
+    for (size_t i = 0; i < count && i < distinct; i++)
+        values.push_back(ids[i]);
+    std::uniform_int_distribution<size_t> pick(0, distinct - 1);
+    std::uniform_int_distribution<size_t> run(1, 64);
+    while (values.size() < count) {
+        int32_t value = ids[pick(random)];
+        for (size_t i = runs ? run(random) : 1; i && values.size() < count; i--)
+            values.push_back(value);
+    }
+    std::shuffle(values.begin(), values.begin() + std::min(count, distinct), random);
+    if (!runs)
+        std::shuffle(values.begin(), values.end(), random);
+    return values;
+}
+
+static void containers(std::mt19937& random, size_t count, size_t max_items, bool biomes) {
+    size_t cutoff = biomes ? pallete_container::max_indirect_biomes : pallete_container::max_indirect_blocks;
+    check_container({}, max_items, biomes);
+    for (size_t distinct : {size_t(1), size_t(2), cutoff, cutoff + 1, cutoff + 2})
+        for (bool runs : {false, true})
+            check_container(generate(random, count, distinct, max_items, runs), max_items, biomes);
+    std::uniform_int_distribution<size_t> distinct(1, std::min(count, cutoff * 2));
+    for (int i = 0; i < 50; i++)
+        check_container(generate(random, count, distinct(random), max_items, i & 1), max_items, biomes);
+}
+
+static void height_maps(std::mt19937& random) {
+    for (uint8_t bits = 1; bits < 32; bits++) {
+        for (size_t count : {0, 1, 63, 64, 65, 256}) {
+            std::uniform_int_distribution<uint32_t> value(0, uint32_t((uint64_t(1) << bits) - 1));
+            std::vector<uint32_t> values(count);
+            for (auto& it : values)
+                it = value(random);
+            pallete_data old_way(bits);
+            for (auto it : values)
+                old_way.add(it);
+            pallete_data new_way(bits);
+            new_way.assign(values.data(), values.size());
+            CHECK(same_bytes(old_way, new_way));
+        }
+    }
+}
+
+int main() {
+    std::mt19937 random(4242);
+    containers(random, 4096, 30000, false);
+    containers(random, 64, 64, true);
+    height_maps(random);
+    return 0;
+}
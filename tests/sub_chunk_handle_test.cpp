@@ -0,0 +1,108 @@
+/*
+ * Copyright 2024-Present Danyil Melnytskyi. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License"). You may not use
+ * this file except in compliance with the License. You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+#include <src/base_objects/world/sub_chunk_data.hpp>
+#include <tests/check.hpp>
+
+using namespace copper_server::base_objects;
+using world::sub_chunk_data;
+using world::sub_chunk_handle;
+
+static block_id_t register_block(const char* name) {
+    static_block_data data;
+    data.name = name;
+    return block::addNewStatelessBlock(std::move(data));
+}
+
+static block_id_t air;
+static block_id_t stone;
+
+static void unchanged_update_keeps_shared_section() {
+    sub_chunk_handle handle;
+    auto revision = handle.revision();
+    handle.update([](sub_chunk_data& section) {
+        section.blocks.set(1, 2, 3, stone);
+        section.blocks.set(1, 2, 3, air);
+    });
+    CHECK(handle.is_shared());
+    CHECK(handle.revision() == revision);
+}
+
+static void uniform_result_is_interned() {
+    sub_chunk_handle handle;
+    sub_chunk_handle other;
+    handle.update([](sub_chunk_data& section) { section.blocks.fill(stone); });
+    CHECK(handle.is_shared());
+    CHECK(handle->get_block(0, 0, 0).id == stone);
+
+    //interned instance must be copied before write
+    other.update([](sub_chunk_data& section) { section.blocks.fill(stone); });
+    CHECK(&other.get() == &handle.get());
+    other.edit().blocks.set(0, 0, 0, air);
+    CHECK(!other.is_shared());
+    CHECK(handle->get_block(0, 0, 0).id == stone);
+}
+
+static void nested_edit_is_kept() {
+    sub_chunk_handle handle;
+    sub_chunk_handle other;
+    auto revision = handle.revision();
+    handle.update([&](sub_chunk_data& section) {
+        //block tick handler could call world.set_block on same section
+        auto& nested = handle.edit();
+        CHECK(&nested == &section);
+        nested.blocks.set(4, 5, 6, stone);
+        section.blocks.set(7, 8, 9, stone);
+    });
+    CHECK(!handle.is_shared());
+    CHECK(handle.revision() > revision);
+    CHECK(handle->get_block(4, 5, 6).id == stone);
+    CHECK(handle->get_block(7, 8, 9).id == stone);
+
+    //shared empty section is not affected
+    CHECK(other.is_shared());
+    CHECK(other->get_block(4, 5, 6).id == air);
+
+    //handle owns private instance, so next edit does not touch interned sections
+    handle.edit().blocks.fill(air);
+    CHECK(other->get_block(7, 8, 9).id == air);
+}
+
+static void nested_edit_back_to_uniform() {
+    sub_chunk_handle handle;
+    sub_chunk_handle other;
+    handle.update([&](sub_chunk_data&) { handle.edit().blocks.fill(stone); });
+    CHECK(handle.is_shared());
+    CHECK(handle->get_block(0, 0, 0).id == stone);
+
+    //interned instance must stay immutable after handle became shared
+    handle.edit().blocks.set(0, 0, 0, air);
+    other.update([](sub_chunk_data& section) { section.blocks.fill(stone); });
+    CHECK(other->get_block(0, 0, 0).id == stone);
+}
+
+static void private_update_moves_revision_only_on_change() {
+    sub_chunk_handle handle;
+    handle.edit().blocks.set(0, 0, 0, stone);
+    auto revision = handle.revision();
+    handle.update([](sub_chunk_data& section) { section.blocks.set(0, 0, 0, stone); });
+    CHECK(handle.revision() == revision);
+    handle.update([](sub_chunk_data& section) { section.blocks.set(0, 0, 1, stone); });
+    CHECK(handle.revision() > revision);
+}
+
+int main() {
+    air = register_block("test:air");
+    stone = register_block("test:stone");
+    unchanged_update_keeps_shared_section();
+    uniform_result_is_interned();
+    nested_edit_is_kept();
+    nested_edit_back_to_uniform();
+    private_update_moves_revision_only_on_change();
+    return 0;
+}